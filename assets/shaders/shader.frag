@@ -1,14 +1,138 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(binding = 1) uniform sampler2D texSampler;
+// Selects the pipeline variant, see EPipelineVariant.
+layout(constant_id = 0) const uint SHADING_MODE = 0;
+
+const uint SHADING_TEXTURED     = 0;
+const uint SHADING_VERTEX_COLOR = 1;
+const uint SHADING_HIGHLIGHT    = 2;
+const uint SHADING_WIREFRAME    = 3;
+const uint SHADING_BOARD        = 4;
+
+layout(binding = 1) uniform sampler2D texSamplers[];
+
+struct BoardData
+{
+    vec4 tile;
+    uint squares[64]; // ESquareFlag bits of each square, 0 is a1.
+};
+
+layout(std430, binding = 3) readonly buffer BoardBuffer
+{
+    BoardData boards[];
+} boardBuffer;
+
+const uint SQUARE_SELECTED  = 1;
+const uint SQUARE_ATTACKED  = 2;
+const uint SQUARE_LAST_MOVE = 4;
+
+// 3x5 pixel glyphs of the file letters a-h and the rank digits 1-8. Bit row * 3 + column is set
+// for the lit pixels, with row 0 at the top and column 0 on the left.
+const uint GLYPHS[16] = uint[16](
+    0x6B70u, 0x3B59u, 0x6270u, 0x6B74u, 0x63EAu, 0x12CEu, 0x39AEu, 0x5B59u,
+    0x749Au, 0x72A3u, 0x38A3u, 0x49EDu, 0x38CFu, 0x2ACEu, 0x24A7u, 0x2AAAu);
+
+// Size of a glyph pixel, in squares.
+const float GLYPH_PIXEL = 0.07;
+
+// The object id is stored below this bit and, on the squares of a board, the square + 1 from it up.
+// Must match PICK_SQUARE_SHIFT in WizardChess.cpp.
+const uint PICK_SQUARE_SHIFT = 24;
 
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
+layout(location = 3) flat in uint fragObjectId;
+layout(location = 4) flat in uint fragBoard;
 
 layout(location = 0) out vec4 outColor;
+// Only stored when the pipeline has the object id attachment.
+layout(location = 1) out uint outObjectId;
+
+// True where the glyph, centered on center, has a lit pixel at point; both are in squares.
+bool GlyphPixel(uint glyph, vec2 point, vec2 center)
+{
+    ivec2 pixel = ivec2(floor((point - center) / GLYPH_PIXEL + vec2(1.5, 2.5)));
+    if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, ivec2(3, 5))))
+    {
+        return false;
+    }
+    return (GLYPHS[glyph] & (1u << uint((4 - pixel.y) * 3 + pixel.x))) != 0u;
+}
+
+// The board quad's texture coordinate is the position in squares: 0 to 8 over the playing area,
+// with a border of half a square that carries the coordinates.
+vec3 BoardColor(vec2 board)
+{
+    vec3 wood = texture(texSamplers[nonuniformEXT(fragTextureIndex)], board / 8.0).rgb;
+
+    if (any(lessThan(board, vec2(0.0))) || any(greaterThanEqual(board, vec2(8.0))))
+    {
+        vec3  color  = wood * vec3(0.35, 0.25, 0.18);
+        vec3  ink    = vec3(0.9, 0.85, 0.7);
+        ivec2 square = ivec2(floor(board));
+        if ((board.y < 0.0) && (square.x >= 0) && (square.x < 8) && GlyphPixel(uint(square.x), board, vec2(square.x + 0.5, -0.25)))
+        {
+            color = ink;
+        }
+        if ((board.x < 0.0) && (square.y >= 0) && (square.y < 8) && GlyphPixel(uint(8 + square.y), board, vec2(-0.25, square.y + 0.5)))
+        {
+            color = ink;
+        }
+        return color;
+    }
+
+    ivec2 square = ivec2(board);
+    bool  dark   = ((square.x + square.y) & 1) == 0; // a1 is dark.
+    vec3  color  = (dark ? vec3(0.55, 0.36, 0.22) : vec3(0.95, 0.85, 0.68)) * (0.5 + wood);
+
+    uint state = boardBuffer.boards[fragBoard].squares[square.y * 8 + square.x];
+    if ((state & SQUARE_LAST_MOVE) != 0u)
+    {
+        color = mix(color, vec3(0.8, 0.85, 0.3), 0.35);
+    }
+    if ((state & SQUARE_SELECTED) != 0u)
+    {
+        color = mix(color, vec3(1.0, 0.8, 0.2), 0.5);
+    }
+    if (((state & SQUARE_ATTACKED) != 0u) && (length(fract(board) - 0.5) < 0.15))
+    {
+        color = mix(color, vec3(0.1, 0.1, 0.1), 0.4);
+    }
+    return color;
+}
 
 void main()
 {
-    outColor = texture(texSampler, fragTexCoord);
-    //outColor = vec4(fragColor, 1.0);
+    outObjectId = fragObjectId;
+
+    if (SHADING_MODE == SHADING_VERTEX_COLOR)
+    {
+        outColor = vec4(fragColor, 1.0);
+    }
+    else if (SHADING_MODE == SHADING_WIREFRAME)
+    {
+        outColor = vec4(0.9, 0.9, 0.9, 1.0);
+    }
+    else if (SHADING_MODE == SHADING_BOARD)
+    {
+        outColor = vec4(BoardColor(fragTexCoord), 1.0);
+
+        // Lets a GPU pick of the board find the square without casting a ray.
+        if (all(greaterThanEqual(fragTexCoord, vec2(0.0))) && all(lessThan(fragTexCoord, vec2(8.0))))
+        {
+            ivec2 square = ivec2(fragTexCoord);
+            outObjectId |= uint(square.y * 8 + square.x + 1) << PICK_SQUARE_SHIFT;
+        }
+    }
+    else
+    {
+        outColor = texture(texSamplers[nonuniformEXT(fragTextureIndex)], fragTexCoord);
+
+        if (SHADING_MODE == SHADING_HIGHLIGHT)
+        {
+            outColor.rgb = mix(outColor.rgb, vec3(1.0, 0.8, 0.2), 0.4);
+        }
+    }
 }
\ No newline at end of file
@@ -4,25 +4,58 @@ layout(binding = 0) uniform UniformBufferObject
 {
     mat4 view;
     mat4 proj;
+    mat4 viewProj;
 } ubo;
 
+struct ObjectData
+{
+    mat4 world;
+    uint textureIndex;
+    uint board;
+};
+
+layout(std430, binding = 2) readonly buffer ObjectBuffer
+{
+    ObjectData objects[];
+} objectBuffer;
+
+struct BoardData
+{
+    vec4 tile; // Clip space scale (xy) and offset (zw) of the board's tile of the screen.
+    uint squares[64];
+};
+
+layout(std430, binding = 3) readonly buffer BoardBuffer
+{
+    BoardData boards[];
+} boardBuffer;
+
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
-
-//push constants block
-layout( push_constant ) uniform constants
-{
-    mat4 model;
-	mat4 normailzeMatrix;
-} pushConstant;
+layout(location = 2) flat out uint fragTextureIndex;
+layout(location = 3) flat out uint fragObjectId;
+layout(location = 4) flat out uint fragBoard;
 
 void main()
 {
-    gl_Position = ubo.proj * ubo.view * pushConstant.model * pushConstant.normailzeMatrix * vec4(inPosition, 1.0);
+    // The draw's first instance is the object index.
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+
+    // Every board is seen by the same camera, then moved into its own tile. The camera keeps the whole
+    // board inside its view, so nothing needs to be clipped against the tile.
+    vec4 tile     = boardBuffer.boards[object.board].tile;
+    vec4 position = ubo.viewProj * (object.world * vec4(inPosition, 1.0));
+    gl_Position   = vec4(position.xy * tile.xy + tile.zw * position.w, position.zw);
     fragColor = inColor;
     fragTexCoord = inTexCoord;
+
+    fragTextureIndex = object.textureIndex;
+    fragBoard = object.board;
+
+    // 0 is left for the background.
+    fragObjectId = gl_InstanceIndex + 1;
 }
\ No newline at end of file
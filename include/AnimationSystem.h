@@ -0,0 +1,67 @@
+#ifndef __ANIMATION_SYSTEM_H__
+#define __ANIMATION_SYSTEM_H__
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class TransformSystem;
+
+///@brief Plays piece moves: a lift, an arc and a landing, with a turn about the vertical axis.
+///
+///       Only active tracks are stored, in flat arrays with one entry per track, so a frame costs
+///       O(active tracks) no matter how many pieces there are. Update() evaluates the curves of all
+///       tracks in one pass, four tracks per SSE vector, and writes the results into the local
+///       transforms of the animated nodes. Finished tracks are swapped out of the arrays.
+class AnimationSystem
+{
+public:
+    AnimationSystem() = default;
+    ~AnimationSystem() = default;
+
+    ///@brief Moves a node from one position and yaw to another over duration seconds, starting at startTime.
+    ///       The height follows a parabola that peaks arcHeight above the straight path halfway through.
+    ///@note  A node that is already moving continues from where it is; its previous track is replaced.
+    void Play(uint32_t node, const glm::vec3& from, float fromYaw, const glm::vec3& to, float toYaw, float arcHeight, double startTime, float duration);
+
+    void Update(double time, TransformSystem& transforms);
+
+    // Stops every track where it is.
+    void Clear();
+
+    // Stops the track of a node where it is, if the node is moving.
+    void Stop(uint32_t node);
+
+    bool     Active()      const { return !m_nodes.empty(); }
+    uint32_t ActiveCount() const { return static_cast<uint32_t>(m_nodes.size()); }
+
+private:
+    void RemoveTrack(uint32_t track);
+
+    double m_epoch = 0.0; // Track times are floats relative to this.
+
+    std::vector<uint32_t> m_nodes;
+    std::vector<float>    m_startTimes;
+    std::vector<float>    m_inverseDurations;
+    std::vector<float>    m_fromX;
+    std::vector<float>    m_fromY;
+    std::vector<float>    m_fromZ;
+    std::vector<float>    m_toX;
+    std::vector<float>    m_toY;
+    std::vector<float>    m_toZ;
+    std::vector<float>    m_fromYaw;
+    std::vector<float>    m_toYaw;
+    std::vector<float>    m_arcHeights;
+
+    // Results of the last evaluation, one entry per track.
+    std::vector<float> m_outX;
+    std::vector<float> m_outY;
+    std::vector<float> m_outZ;
+    std::vector<float> m_outYaw;
+    std::vector<float> m_outProgress;
+};
+
+#endif // __ANIMATION_SYSTEM_H__
\ No newline at end of file
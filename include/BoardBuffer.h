@@ -0,0 +1,72 @@
+#ifndef __BOARD_BUFFER_H__
+#define __BOARD_BUFFER_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "Types.h"
+
+///@note The values are bits of the BoardBuffer entries read by shader.frag.
+enum ESquareFlag : unsigned int
+{
+    SquareSelected = 1 << 0, // Holds the selected piece.
+    SquareAttacked = 1 << 1, // Attacked by the selected piece.
+    SquareLastMove = 1 << 2, // Start or end of the last move.
+};
+
+const uint32_t BOARD_SQUARES = 64;
+
+///@brief Per-board data read by the shaders, indexed with the board of the object.
+///       Must match the std430 layout of BoardData in shader.vert and shader.frag.
+struct BoardData
+{
+    glm::vec4 tile = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f); // Clip space scale (xy) and offset (zw) that put the board into its tile of the screen.
+    uint32_t  squares[BOARD_SQUARES] = {};              // ESquareFlag bits of each square, 0 is a1.
+};
+static_assert(sizeof(BoardData) == 272, "BoardData must match the std430 layout in the shaders");
+
+///@brief Persistently mapped storage buffers with a BoardData entry per board.
+///
+///       The board is one quad whose fragment shader draws the squares, so changing how a square looks
+///       is a write of its 4-byte entry rather than a change of geometry. Like ObjectBuffer there is one
+///       buffer per frame in flight, and Flush() only writes the entries a frame has not seen yet.
+///       Data() is what the software rasterizer shades the squares from, the same flags shader.frag reads.
+class BoardBuffer
+{
+public:
+    BoardBuffer() = default;
+    ~BoardBuffer() = default;
+
+    void Create(uint32_t frameCount, uint32_t boardCount);
+    void Destroy();
+
+    void     SetSquare(uint32_t board, uint32_t square, uint32_t flags);
+    uint32_t Square(uint32_t board, uint32_t square) const { return m_boards[board].squares[square]; }
+    void     SetTile(uint32_t board, const glm::vec4& tile);
+
+    // Writes the entries the given frame has not seen yet into that frame's buffer.
+    void Flush(uint32_t frameIndex);
+
+    VkBuffer         Buffer(uint32_t frameIndex) const { return m_buffers[frameIndex]; }
+    VkDeviceSize     Size()                      const { return sizeof(BoardData) * m_boards.size(); }
+    uint32_t         BoardCount()                const { return static_cast<uint32_t>(m_boards.size()); }
+    const BoardData* Data()                      const { return m_boards.data(); }
+
+private:
+    uint32_t AllFrames() const { return (m_frameCount == 32) ? ~0u : ((1u << m_frameCount) - 1); }
+
+    uint32_t m_frameCount = 0;
+
+    std::vector<BoardData> m_boards;           // CPU copy of the latest value of each entry.
+    std::vector<uint32_t>  m_staleSquares;     // Per square of every board, a bit for each frame whose buffer is out of date.
+    std::vector<uint32_t>  m_staleTiles;       // The same for the tile of each board.
+    std::vector<uint32_t>  m_staleBoardFrames; // Per board, the frames with any stale entry of the board.
+
+    std::vector<VkBuffer>       m_buffers;
+    std::vector<VkDeviceMemory> m_buffersMemory;
+    std::vector<BoardData*>     m_buffersMapped;
+};
+
+#endif // __BOARD_BUFFER_H__
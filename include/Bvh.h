@@ -0,0 +1,196 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cassert>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define BVH_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define BVH_USE_SSE 0
+#endif
+
+struct Aabb
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void Grow(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Grow(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    // Half the surface area, which is all the SAH needs.
+    float HalfArea() const
+    {
+        glm::vec3 size = max - min;
+        return (size.x * size.y) + (size.y * size.z) + (size.z * size.x);
+    }
+};
+
+struct BvhRay
+{
+    BvhRay(const glm::vec3& rayOrigin, const glm::vec3& rayDirection)
+        : origin(rayOrigin)
+        , direction(rayDirection)
+    {
+        // Keep the slabs finite for axis-aligned rays.
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float d = direction[axis];
+            inverseDirection[axis] = 1.0f / ((std::abs(d) > 1e-20f) ? d : ((d < 0.0f) ? -1e-20f : 1e-20f));
+        }
+    }
+
+    glm::vec3 origin;
+    glm::vec3 direction;
+    glm::vec3 inverseDirection;
+};
+
+///@note 32 bytes, so two nodes share a cache line. Each bound is followed by a 32-bit field,
+///      which lets the SSE path load a bound as one unaligned vector and ignore the last lane.
+struct BvhNode
+{
+    glm::vec3 boundsMin;
+    uint32_t  leftFirst; // First primitive of a leaf, or the left child of an inner node; the right child follows it.
+    glm::vec3 boundsMax;
+    uint32_t  count;     // Primitives in a leaf, 0 for an inner node.
+
+    bool IsLeaf() const { return count > 0; }
+};
+
+///@brief Bounding volume hierarchy over a set of primitive bounds, built with the binned surface area heuristic.
+///
+///       The same structure serves the triangles of a mesh and the instances of a scene; the caller
+///       intersects the primitives of the leaves the ray reaches, nearest child first.
+class Bvh
+{
+public:
+    Bvh() = default;
+    ~Bvh() = default;
+
+    void Build(const std::vector<Aabb>& primitiveBounds);
+
+    bool Empty() const { return m_nodes.empty(); }
+
+    ///@brief Calls intersectPrimitive(primitiveIndex, tMax) for the primitives the ray may hit before tMax.
+    ///       It returns true on a hit closer than tMax and lowers tMax to its distance.
+    template <typename IntersectPrimitive>
+    bool Traverse(const BvhRay& ray, float& tMax, IntersectPrimitive intersectPrimitive) const
+    {
+        if (m_nodes.empty() || (IntersectNode(ray, m_nodes[0], tMax) == FLT_MAX))
+        {
+            return false;
+        }
+
+        bool     hit = false;
+        uint32_t stack[MAX_DEPTH];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        for (;;)
+        {
+            const BvhNode& node = m_nodes[nodeIndex];
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = 0; i < node.count; i++)
+                {
+                    hit |= intersectPrimitive(m_primitiveIndices[node.leftFirst + i], tMax);
+                }
+            }
+            else
+            {
+                uint32_t nearChild = node.leftFirst;
+                uint32_t farChild  = node.leftFirst + 1;
+                float    nearDist  = IntersectNode(ray, m_nodes[nearChild], tMax);
+                float    farDist   = IntersectNode(ray, m_nodes[farChild], tMax);
+                if (farDist < nearDist)
+                {
+                    std::swap(nearChild, farChild);
+                    std::swap(nearDist, farDist);
+                }
+
+                if (nearDist != FLT_MAX)
+                {
+                    if (farDist != FLT_MAX)
+                    {
+                        assert(stackSize < MAX_DEPTH);
+                        stack[stackSize++] = farChild;
+                    }
+                    nodeIndex = nearChild;
+                    continue;
+                }
+            }
+
+            // Pop the next subtree that is still in front of the closest hit.
+            bool found = false;
+            while ((stackSize > 0) && !found)
+            {
+                nodeIndex = stack[--stackSize];
+                found     = (IntersectNode(ray, m_nodes[nodeIndex], tMax) != FLT_MAX);
+            }
+            if (!found)
+            {
+                return hit;
+            }
+        }
+    }
+
+private:
+    ///@note Inner nodes are at most this deep, so the traversal stack, which holds at most one node per
+    ///      level, can be a fixed array. Skewed inputs end in larger leaves instead of deeper trees.
+    static const uint32_t MAX_DEPTH = 64;
+
+    // Distance at which the ray enters the node, or FLT_MAX when it misses it or enters beyond tMax.
+    static float IntersectNode(const BvhRay& ray, const BvhNode& node, float tMax)
+    {
+#if BVH_USE_SSE
+        __m128 origin           = _mm_setr_ps(ray.origin.x, ray.origin.y, ray.origin.z, 0.0f);
+        __m128 inverseDirection = _mm_setr_ps(ray.inverseDirection.x, ray.inverseDirection.y, ray.inverseDirection.z, 0.0f);
+        __m128 t1               = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMin.x), origin), inverseDirection);
+        __m128 t2               = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&node.boundsMax.x), origin), inverseDirection);
+        __m128 tNear            = _mm_min_ps(t1, t2);
+        __m128 tFar             = _mm_max_ps(t1, t2);
+
+        // Only the x, y and z lanes count.
+        float tEnter = _mm_cvtss_f32(_mm_max_ss(tNear, _mm_max_ss(_mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(tNear, tNear, _MM_SHUFFLE(2, 2, 2, 2)))));
+        float tExit  = _mm_cvtss_f32(_mm_min_ss(tFar, _mm_min_ss(_mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(tFar, tFar, _MM_SHUFFLE(2, 2, 2, 2)))));
+#else
+        glm::vec3 t1     = (node.boundsMin - ray.origin) * ray.inverseDirection;
+        glm::vec3 t2     = (node.boundsMax - ray.origin) * ray.inverseDirection;
+        glm::vec3 tNear  = glm::min(t1, t2);
+        glm::vec3 tFar   = glm::max(t1, t2);
+        float     tEnter = std::max(std::max(tNear.x, tNear.y), tNear.z);
+        float     tExit  = std::min(std::min(tFar.x, tFar.y), tFar.z);
+#endif
+        if ((tExit >= tEnter) && (tExit > 0.0f) && (tEnter < tMax))
+        {
+            return std::max(tEnter, 0.0f);
+        }
+        return FLT_MAX;
+    }
+
+    void  UpdateNodeBounds(uint32_t nodeIndex, const std::vector<Aabb>& primitiveBounds);
+    void  Subdivide(uint32_t nodeIndex, const std::vector<Aabb>& primitiveBounds, const std::vector<glm::vec3>& centroids);
+    float FindBestSplit(const BvhNode& node, const std::vector<Aabb>& primitiveBounds, const std::vector<glm::vec3>& centroids, int& axis, float& splitPosition) const;
+
+    std::vector<BvhNode>  m_nodes;            // The root is node 0.
+    std::vector<uint32_t> m_primitiveIndices; // Primitives in leaf order; leaves refer to ranges of this.
+};
+
+#endif // __BVH_H__
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef __DESCRIPTOR_ALLOCATOR_H__
+#define __DESCRIPTOR_ALLOCATOR_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+struct DescriptorPoolRatio
+{
+    VkDescriptorType type;
+    float            descriptorsPerSet;
+};
+
+///@brief Allocates descriptor sets from a growing chain of descriptor pools.
+///
+///       When the current pool runs out, it is retired to the full list and a larger pool is created,
+///       so allocation never fails because of a fixed pool size. Sets are never freed one by one;
+///       Reset() recycles every pool at once with vkResetDescriptorPool.
+///
+///       Keep one allocator per frame in flight for transient sets and reset it once the frame's
+///       timeline value has been reached. That makes transient allocation O(1) without any per-set frees.
+class DescriptorAllocator
+{
+public:
+    DescriptorAllocator() = default;
+    ~DescriptorAllocator() = default;
+
+    void Init(uint32_t initialSets, const std::vector<DescriptorPoolRatio>& poolRatios, VkDescriptorPoolCreateFlags flags = 0);
+    void Destroy();
+
+    VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+    void            Reset();
+
+    // Pools in the chain, in use or ready; Reset() keeps them all.
+    uint32_t        PoolCount() const { return static_cast<uint32_t>(m_fullPools.size() + m_readyPools.size()); }
+
+private:
+    VkDescriptorPool GetPool();
+    VkDescriptorPool CreatePool(uint32_t setCount);
+
+    static constexpr uint32_t MaxSetsPerPool = 4096;
+
+    std::vector<DescriptorPoolRatio> m_poolRatios;
+    std::vector<VkDescriptorPool>    m_fullPools;
+    std::vector<VkDescriptorPool>    m_readyPools;
+    VkDescriptorPoolCreateFlags      m_flags       = 0;
+    uint32_t                         m_setsPerPool = 0;
+};
+
+#endif // __DESCRIPTOR_ALLOCATOR_H__
@@ -0,0 +1,61 @@
+#ifndef __DYNAMIC_RESOLUTION_H__
+#define __DYNAMIC_RESOLUTION_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+///@brief Scales the render resolution to keep the GPU frame time within the present interval.
+///
+///       The scene is rendered into the top-left part of an offscreen target that has the size of the
+///       swap chain, then upscaled into the swap chain image. Only the viewport changes with the scale,
+///       so nothing has to be reallocated when it does.
+///
+///       The GPU time of every frame is measured with timestamp queries. The scale drops right away when
+///       a frame goes over budget and recovers in small steps while frames are well under it, so it
+///       does not oscillate. Without timestamp support the scene is always rendered at full resolution.
+class DynamicResolution
+{
+public:
+    DynamicResolution() = default;
+    ~DynamicResolution() = default;
+
+    void Init(uint32_t frameCount);
+    void Destroy();
+
+    // The size of the offscreen target, i.e. the resolution at a scale of 1.
+    void SetFullExtent(VkExtent2D extent) { m_fullExtent = extent; }
+
+    void SetTargetFrameTime(double seconds) { m_targetFrameTime = seconds; }
+
+    // Reads the GPU time of the last frame that used these queries and adjusts the scale.
+    ///@note Only valid once the frame has completed on the timeline.
+    void BeginFrame(uint32_t frameIndex);
+
+    void RecordFrameStart(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+    void RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    VkExtent2D RenderExtent() const;
+    VkExtent2D FullExtent()   const { return m_fullExtent; }
+    float      Scale()        const { return m_scale; }
+    bool       HasGpuTime()   const { return m_gpuTime > 0.0; }
+    double     GpuTimeMs()    const { return m_gpuTime * 1000.0; }
+    double     TotalGpuTime() const { return m_totalGpuTime; } // Seconds, summed over every measured frame.
+
+private:
+    void UpdateScale();
+
+    VkQueryPool       m_queryPool       = VK_NULL_HANDLE; // Two timestamps per frame in flight.
+    std::vector<bool> m_queriesWritten;
+    double            m_timestampPeriod = 0.0;            // Nanoseconds per timestamp tick.
+    uint64_t          m_timestampMask   = 0;
+
+    VkExtent2D m_fullExtent{};
+    float      m_scale           = 1.0f;
+    double     m_targetFrameTime = 1.0 / 60.0;
+    double     m_gpuTime         = 0.0; // Smoothed, in seconds.
+    double     m_totalGpuTime    = 0.0;
+};
+
+#endif // __DYNAMIC_RESOLUTION_H__
@@ -0,0 +1,85 @@
+#ifndef __FRAME_CAPTURE_H__
+#define __FRAME_CAPTURE_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include "ReadbackRing.h"
+#include "ThreadPool.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <atomic>
+
+enum ECaptureFormat : unsigned int
+{
+    Y4m     = 0, // YUV4MPEG2, 8-bit 4:4:4, which video encoders read straight from a pipe.
+    RawRgba = 1, // The RGBA bytes of each frame back to back, with no header.
+    NumCaptureFormats,
+};
+
+// The name of the format on the command line.
+const char* CaptureFormatName(ECaptureFormat format);
+
+// Returns false when no format has that name.
+bool ParseCaptureFormat(const std::string& name, ECaptureFormat* pFormat);
+
+///@brief Streams the rendered frames to a video file or pipe.
+///
+///       Each frame copies its final image into a slot of a readback ring, and a single writer thread
+///       converts and writes the slots in frame order straight from the mapped memory. When all slots
+///       are still in use, the render loop waits for the writer rather than leaving the frame out, which
+///       would shorten the video. All buffers are allocated by Start(), so capturing does not allocate per frame.
+class FrameCapture
+{
+public:
+    FrameCapture() = default;
+    ~FrameCapture() = default;
+
+    ///@param path  The file to write, or "-" for stdout.
+    ///@param bgra  Whether the captured images store blue first, like most swap chain formats.
+    void Start(const std::string& path, ECaptureFormat format, VkExtent2D extent, bool bgra, uint32_t frameRate);
+
+    // Waits for the captured frames to be written and closes the output.
+    void Stop();
+
+    bool Active() const { return m_pFile != nullptr; }
+
+    // Reserves a slot for the next frame, waiting for the writer when needed, or returns false when
+    // the frame is not captured.
+    bool BeginFrame(VkExtent2D extent);
+
+    // Copies the frame's image, in TRANSFER_SRC_OPTIMAL layout, into the reserved slot.
+    void RecordCopy(VkCommandBuffer commandBuffer, VkImage image) const;
+
+    // The frame is written once the timeline reaches timelineValue.
+    void EndFrame(uint64_t timelineValue);
+
+    uint32_t CapturedFrames() const { return m_writtenFrames.load(); }
+    uint32_t DroppedFrames()  const { return m_droppedFrames; }
+
+    // Captured frames per second of wall-clock time, from Start() to the last EndFrame().
+    double SustainedFrameRate() const;
+
+private:
+    void WriteFrame(const uint8_t* pPixels);
+
+    ThreadPool     m_writer; // A single thread, so the frames are written in order.
+    ReadbackRing   m_ring;
+    std::FILE*     m_pFile     = nullptr;
+    ECaptureFormat m_format    = ECaptureFormat::Y4m;
+    VkExtent2D     m_extent    = {};
+    bool           m_bgra      = false;
+    uint32_t       m_frameSlot = UINT32_MAX;
+
+    std::vector<uint8_t>  m_frameBuffer; // Converted frame, only touched by the writer thread.
+    std::atomic<uint32_t> m_writtenFrames{ 0 };
+    std::atomic<bool>     m_writeFailed{ false };
+    uint32_t              m_droppedFrames = 0;
+    uint32_t              m_endedFrames   = 0;
+    double                m_startTime     = 0.0;
+    double                m_lastFrameTime = 0.0;
+};
+
+#endif // __FRAME_CAPTURE_H__
@@ -0,0 +1,76 @@
+#ifndef __FRAME_PACER_H__
+#define __FRAME_PACER_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <chrono>
+
+///@brief Delays the start of a frame so that input is sampled as late as the display allows.
+///
+///       With VK_KHR_present_wait, the pacer waits until the previous frame has actually been presented,
+///       predicts the next presentation from the measured present interval and sleeps until the frame
+///       work is just expected to make it. The work estimate shrinks slowly while frames are on time and
+///       grows when one misses its presentation. The time from sampling input until the frame was
+///       presented is measured for every frame.
+///
+///       Without present wait there is no presentation feedback, so frames start right away.
+class FramePacer
+{
+public:
+    FramePacer() = default;
+    ~FramePacer() = default;
+
+    void Init(bool pacing);
+
+    // Present ids of an old swap chain cannot be waited on with the new one, and an idle gap
+    // between frames is not a missed presentation.
+    void Reset();
+
+    // Blocks until the next frame should start.
+    void WaitForFrameStart(VkSwapchainKHR swapChain);
+
+    // Call right after polling input.
+    void MarkInputSampled();
+
+    // Call right after vkQueueSubmit; the CPU part of the frame is a lower bound for the work estimate.
+    void MarkSubmitted();
+
+    // The id to pass in VkPresentIdKHR, or 0 without present wait.
+    uint64_t NextPresentId();
+
+    // Call after the frame has been queued for presentation.
+    void MarkPresented(uint64_t presentId);
+
+    bool   PresentWaitEnabled()  const { return m_pfnWaitForPresent != nullptr; }
+    bool   HasInputLatency()     const { return m_inputLatency > 0.0; }
+    double InputLatencyMs()      const { return m_inputLatency * 1000.0; }
+    double PresentIntervalMs()   const { return m_presentInterval * 1000.0; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static double SecondsSince(Clock::time_point start, Clock::time_point end);
+    static void   SleepUntil(Clock::time_point deadline);
+
+    static const size_t INPUT_TIME_HISTORY = 16;
+
+    PFN_vkWaitForPresentKHR m_pfnWaitForPresent = nullptr;
+    bool                    m_pacing            = false;
+
+    uint64_t m_nextPresentId = 1;
+    uint64_t m_lastPresentId = 0; // 0 while nothing has been presented on the current swap chain.
+
+    Clock::time_point                                 m_inputTime;
+    std::array<Clock::time_point, INPUT_TIME_HISTORY> m_presentInputTimes{}; // Input time of recent present ids.
+    Clock::time_point                                 m_lastPresentTime;
+    bool                                              m_hasLastPresentTime = false;
+
+    double m_presentInterval = 1.0 / 60.0;  // Seconds between presentations.
+    double m_workEstimate    = 1.0 / 120.0; // Seconds from sampling input until the frame is ready to present.
+    double m_cpuWork         = 0.0;         // Seconds from sampling input until submission.
+    double m_inputLatency    = 0.0;         // Seconds from sampling input until presentation.
+};
+
+#endif // __FRAME_PACER_H__
@@ -0,0 +1,25 @@
+#ifndef __IMAGE_WRITER_H__
+#define __IMAGE_WRITER_H__
+
+#include <cstdint>
+#include <string>
+
+enum EImageFormat : unsigned int
+{
+    Png = 0,
+    Ppm = 1, // Binary, without the alpha channel.
+    Raw = 2, // The RGBA bytes as they are, with no header.
+    NumImageFormats,
+};
+
+// The file name extension of the format, also its name on the command line.
+const char* ImageFormatName(EImageFormat format);
+
+// Returns false when no format has that name.
+bool ParseImageFormat(const std::string& name, EImageFormat* pFormat);
+
+///@brief Writes tightly packed 8-bit RGBA pixels, top row first, to a file. Returns false when writing fails.
+///@note  Thread-safe, so several images can be encoded on worker threads at once.
+bool WriteImage(const std::string& fileName, EImageFormat format, const uint8_t* pPixels, uint32_t width, uint32_t height);
+
+#endif // __IMAGE_WRITER_H__
@@ -0,0 +1,67 @@
+#ifndef __LATENCY_PROFILE_H__
+#define __LATENCY_PROFILE_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+#include <vector>
+
+enum ELatencyProfile : unsigned int
+{
+    LowLatency  = 0, // One frame in flight, tearing allowed.
+    Balanced    = 1, // Two frames in flight, the default.
+    Throughput  = 2, // Three frames in flight, keeps the GPU busiest.
+    PowerSaving = 3, // V-synced, animations capped at 30 Hz, no frames while nothing changes.
+    NumLatencyProfiles,
+};
+
+struct LatencyProfileSettings
+{
+    const char*                   name;
+    uint32_t                      framesInFlight;
+    std::vector<VkPresentModeKHR> presentModes;   // In order of preference. FIFO is the fallback since it is always supported.
+    double                        animationInterval; // Minimum seconds between animated frames, 0 to animate at the display rate.
+    bool                          framePacing;    // Delay frame starts to sample input as late as possible. Needs VK_KHR_present_wait.
+};
+
+inline const LatencyProfileSettings& GetLatencyProfileSettings(ELatencyProfile profile)
+{
+    static const LatencyProfileSettings settings[] =
+    {
+        { "low-latency",  1, { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR }, 0.0,        true  },
+        { "balanced",     2, { VK_PRESENT_MODE_MAILBOX_KHR },                                0.0,        true  },
+        { "throughput",   3, { VK_PRESENT_MODE_MAILBOX_KHR },                                0.0,        false },
+        { "power-saving", 2, { VK_PRESENT_MODE_FIFO_KHR },                                   1.0 / 30.0, false },
+    };
+
+    return settings[profile];
+}
+
+inline bool ParseLatencyProfile(const std::string& name, ELatencyProfile* pProfile)
+{
+    for (unsigned int i = 0; i < NumLatencyProfiles; i++)
+    {
+        if (name == GetLatencyProfileSettings(static_cast<ELatencyProfile>(i)).name)
+        {
+            *pProfile = static_cast<ELatencyProfile>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline const char* PresentModeName(VkPresentModeKHR presentMode)
+{
+    switch (presentMode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:    return "IMMEDIATE";
+    case VK_PRESENT_MODE_MAILBOX_KHR:      return "MAILBOX";
+    case VK_PRESENT_MODE_FIFO_KHR:         return "FIFO";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+    default:                               return "UNKNOWN";
+    }
+}
+
+#endif // __LATENCY_PROFILE_H__
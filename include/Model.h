@@ -15,6 +15,18 @@
 #include <string>
 
 #include "Types.h"
+#include "Bvh.h"
+
+///@brief One level of detail; a range of the model's index buffer.
+struct MeshLod
+{
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    float    error; // Largest distance a vertex moved from the full mesh, in model space.
+};
+
+// Level 0 is the full mesh; every further level roughly halves the detail of the one before.
+const uint32_t MAX_MODEL_LODS = 4;
 
 class Model
 {
@@ -24,11 +36,42 @@ public:
         Load(fileName);
     }
 
+    // A mesh generated in code; it is prepared like a loaded one.
+    Model(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+        : m_vertices(vertices)
+        , m_indices(indices)
+    {
+        Finish();
+    }
+
     ~Model();
 
     size_t    Indices()         const { return m_indices.size(); }
+    uint32_t  LodCount()        const { return static_cast<uint32_t>(m_lods.size()); }
     glm::mat4 NormalizeMatrix() const { return m_normalizeMatrix; }
     glm::mat4 ModelMatrix()     const { return m_modelMatrix; }
+    uint32_t  TextureIndex()    const { return m_textureIndex; }
+    uint32_t  PipelineVariant() const { return m_pipelineVariant; }
+
+    const MeshLod& Lod(uint32_t level) const { return m_lods[level]; }
+
+    // The mesh as the buffers hold it, for rendering on the CPU.
+    const Vertex*   VertexData() const { return m_vertices.data(); }
+    const uint32_t* IndexData()  const { return m_indices.data(); }
+
+    ///@brief Intersects a ray in model space with the full mesh.
+    ///       On a hit closer than tMax, tMax is lowered to its distance and texCoord is set to the texture coordinate there.
+    bool Intersect(const BvhRay& ray, float& tMax, glm::vec2& texCoord) const;
+
+    void SetTextureIndex(uint32_t textureIndex)
+    {
+        m_textureIndex = textureIndex;
+    }
+
+    void SetPipelineVariant(uint32_t pipelineVariant)
+    {
+        m_pipelineVariant = pipelineVariant;
+    }
 
     VkBuffer VertexBuffer()
     {
@@ -64,6 +107,22 @@ public:
         m_normalizeMatrix = glm::scale(m_normalizeMatrix, glm::vec3(scale));
     }
 
+    // Center of the bounding box in model space; the normalization matrix moves it to the origin.
+    glm::vec3 Center() const
+    {
+        return glm::vec3((m_boundaries[0] + m_boundaries[1]) / 2,
+                         (m_boundaries[2] + m_boundaries[3]) / 2,
+                         (m_boundaries[4] + m_boundaries[5]) / 2);
+    }
+
+    // Half size of the bounding box in model space.
+    glm::vec3 Extents() const
+    {
+        return glm::vec3((m_boundaries[1] - m_boundaries[0]) / 2,
+                         (m_boundaries[3] - m_boundaries[2]) / 2,
+                         (m_boundaries[5] - m_boundaries[4]) / 2);
+    }
+
     float MaxScale()
     {
         return std::max(std::max((m_boundaries[1] - m_boundaries[0]),
@@ -75,12 +134,19 @@ private:
     void CreateIndexBuffer();
     void CreateVertexBuffer();
     void Load(std::string fileName);
+    void Finish();
+    void GenerateLods();
+    void BuildBvh();
 
     glm::mat4               m_modelMatrix = glm::mat4(1.0f);
     std::vector<Vertex>     m_vertices;
-    std::vector<uint32_t>   m_indices;
+    std::vector<uint32_t>   m_indices; // The indices of every level of detail, one after the other.
+    std::vector<MeshLod>    m_lods;
+    Bvh                     m_bvh; // Over the triangles of the full mesh, for picking.
     float                   m_boundaries[6] = {};
     glm::mat4               m_normalizeMatrix = glm::mat4(1.0f);
+    uint32_t                m_textureIndex = 0;
+    uint32_t                m_pipelineVariant = 0;
 
     VkBuffer        m_vertexBuffer       = VK_NULL_HANDLE;
     VkDeviceMemory  m_vertexBufferMemory = VK_NULL_HANDLE;
@@ -0,0 +1,56 @@
+#ifndef __OBJECT_BUFFER_H__
+#define __OBJECT_BUFFER_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+#include "Types.h"
+
+///@brief Persistently mapped storage buffers with one ObjectData entry per object.
+///
+///       The shaders index the buffer with gl_InstanceIndex. There is one buffer per frame in flight,
+///       so a frame can be written while the previous one is still being read by the GPU.
+///       A CPU copy of every entry keeps track of which frames have not seen its latest value yet,
+///       and Flush() only rewrites those entries instead of the whole buffer.
+///       With a frame count of 0 no buffers are created and only the CPU copy is kept; BoardBuffer
+///       does the same. The software rasterizer then takes its world matrices from WorldMatrix().
+class ObjectBuffer
+{
+public:
+    ObjectBuffer() = default;
+    ~ObjectBuffer() = default;
+
+    void Create(uint32_t frameCount, uint32_t maxObjects);
+    void Destroy();
+
+    void SetWorldMatrix(uint32_t objectIndex, const glm::mat4& worldMatrix);
+    void SetTextureIndex(uint32_t objectIndex, uint32_t textureIndex);
+    void SetBoard(uint32_t objectIndex, uint32_t board);
+
+    // Writes the entries the given frame has not seen yet into that frame's buffer.
+    void Flush(uint32_t frameIndex);
+
+    const glm::mat4& WorldMatrix(uint32_t objectIndex) const { return m_objects[objectIndex].world; }
+    VkBuffer         Buffer(uint32_t frameIndex)       const { return m_buffers[frameIndex]; }
+    uint32_t         MaxObjects()                      const { return m_maxObjects; }
+    uint32_t         LastFlushWrites()                 const { return m_lastFlushWrites; }
+
+private:
+    void MarkDirty(uint32_t objectIndex);
+
+    uint32_t m_frameCount      = 0;
+    uint32_t m_maxObjects      = 0;
+    uint32_t m_lastFlushWrites = 0;
+
+    std::vector<ObjectData> m_objects;      // CPU copy of the latest value of each entry.
+    std::vector<uint32_t>   m_staleFrames;  // Per entry, a bit for each frame whose buffer is out of date.
+    std::vector<uint32_t>   m_dirtyObjects; // Entries with at least one stale frame.
+
+    std::vector<VkBuffer>       m_buffers;
+    std::vector<VkDeviceMemory> m_buffersMemory;
+    std::vector<ObjectData*>    m_buffersMapped;
+};
+
+#endif // __OBJECT_BUFFER_H__
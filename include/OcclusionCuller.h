@@ -0,0 +1,123 @@
+#ifndef __OCCLUSION_CULLER_H__
+#define __OCCLUSION_CULLER_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <vector>
+
+#include "Types.h"
+#include "DescriptorAllocator.h"
+
+enum ECullPhase : unsigned int
+{
+    Early = 0, // Tests against the depth pyramid of the previous frame.
+    Late  = 1, // Re-tests what the early phase culled against the pyramid of this frame.
+    NumCullPhases,
+};
+
+///@brief Hierarchical-Z occlusion culling.
+///
+///       The depth pyramid is an R32F mip chain where every texel holds the farthest depth of its footprint.
+///       A compute pass projects the bounds of every object, picks the pyramid level where they span a
+///       couple of texels and writes the instance count of the object's indirect draw command.
+///
+///       The early phase tests against the pyramid of the previous frame, which may cull objects that
+///       became visible since. After the early draws, the pyramid is rebuilt from the current depth
+///       buffer and the late phase re-tests only the objects the early phase culled.
+class OcclusionCuller
+{
+public:
+    OcclusionCuller() = default;
+    ~OcclusionCuller() = default;
+
+    // Culling writes the object index into firstInstance of the indirect draws.
+    static bool IsSupported();
+
+    void Init(uint32_t                 frameCount,
+              uint32_t                 maxObjects,
+              const std::vector<char>& hizShaderCode,
+              const std::vector<char>& cullShaderCode);
+    void Destroy();
+
+    void CreateDepthPyramid(VkExtent2D depthExtent);
+    void DestroyDepthPyramid();
+
+    void SetObjectBounds(uint32_t objectIndex, const glm::vec3& center, const glm::vec3& extents);
+
+    // Reads the counters of the last frame that used these buffers, then resets them.
+    void BeginFrame(uint32_t frameIndex);
+
+    // Writes one draw command per draw for both phases. The instance counts are filled in by the culling passes.
+    void WriteDrawCommands(uint32_t frameIndex, const std::vector<VkDrawIndexedIndirectCommand>& drawCommands);
+
+    void RecordCull(VkCommandBuffer      commandBuffer,
+                    uint32_t             frameIndex,
+                    ECullPhase           phase,
+                    DescriptorAllocator& descriptorAllocator,
+                    VkBuffer             objectBuffer,
+                    const glm::mat4&     viewProj,
+                    const glm::vec2&     viewportScale);
+
+    ///@note The depth image must be in VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL.
+    ///      The pyramid keeps the farthest depth, so texels outside of the viewport only make it more conservative.
+    void RecordBuildDepthPyramid(VkCommandBuffer      commandBuffer,
+                                 DescriptorAllocator& descriptorAllocator,
+                                 VkImageView          depthImageView);
+
+    VkBuffer DrawCommandBuffer(uint32_t frameIndex, ECullPhase phase) const { return m_frames[frameIndex].drawCommandBuffers[phase]; }
+    uint32_t DrawCount(uint32_t frameIndex)                           const { return m_frames[frameIndex].drawCount; }
+    uint32_t CulledObjects()                                          const { return m_culledObjects; }
+
+private:
+    struct CullPushConstants
+    {
+        glm::mat4 viewProj;
+        uint32_t  drawCount;
+        uint32_t  phase;
+        glm::vec2 viewportScale;
+    };
+
+    struct FrameResources
+    {
+        std::array<VkBuffer, NumCullPhases>                      drawCommandBuffers{};
+        std::array<VkDeviceMemory, NumCullPhases>                drawCommandBuffersMemory{};
+        std::array<VkDrawIndexedIndirectCommand*, NumCullPhases> drawCommandsMapped{};
+
+        VkBuffer        statsBuffer       = VK_NULL_HANDLE;
+        VkDeviceMemory  statsBufferMemory = VK_NULL_HANDLE;
+        uint32_t*       pStatsMapped      = nullptr;
+
+        uint32_t        drawCount         = 0;
+    };
+
+    void CreateDescriptorSetLayouts();
+    void CreatePipelines(const std::vector<char>& hizShaderCode, const std::vector<char>& cullShaderCode);
+
+    uint32_t m_maxObjects    = 0;
+    uint32_t m_culledObjects = 0;
+
+    std::vector<FrameResources> m_frames;
+
+    VkBuffer        m_boundsBuffer       = VK_NULL_HANDLE;
+    VkDeviceMemory  m_boundsBufferMemory = VK_NULL_HANDLE;
+    ObjectBounds*   m_pBoundsMapped      = nullptr;
+
+    VkImage                  m_pyramidImage       = VK_NULL_HANDLE;
+    VkDeviceMemory           m_pyramidImageMemory = VK_NULL_HANDLE;
+    VkImageView              m_pyramidView        = VK_NULL_HANDLE; // All levels, read by the culling pass.
+    std::vector<VkImageView> m_pyramidLevelViews;                   // One view per level, for building the pyramid.
+    std::vector<VkExtent2D>  m_pyramidLevelExtents;
+    VkSampler                m_pyramidSampler     = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout m_hizDescriptorSetLayout  = VK_NULL_HANDLE;
+    VkPipelineLayout      m_hizPipelineLayout       = VK_NULL_HANDLE;
+    VkPipeline            m_hizPipeline             = VK_NULL_HANDLE;
+
+    VkDescriptorSetLayout m_cullDescriptorSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout      m_cullPipelineLayout      = VK_NULL_HANDLE;
+    VkPipeline            m_cullPipeline            = VK_NULL_HANDLE;
+};
+
+#endif // __OCCLUSION_CULLER_H__
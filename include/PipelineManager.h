@@ -0,0 +1,67 @@
+#ifndef __PIPELINE_MANAGER_H__
+#define __PIPELINE_MANAGER_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+#include "ThreadPool.h"
+
+///@note The values are the SHADING_MODE specialization constant of shader.frag.
+enum EPipelineVariant : unsigned int
+{
+    Textured    = 0,
+    VertexColor = 1,
+    Highlight   = 2,
+    Wireframe   = 3,
+    Board       = 4, // Draws the squares of the board quad from the BoardBuffer.
+    NumPipelineVariants,
+};
+
+///@brief Owns the graphics pipelines of every variant and compiles them on worker threads.
+///
+///       The textured variant is the fallback. It is compiled synchronously in Init(); every other
+///       variant is compiled in the background after RequestVariant(). Get() never blocks: until a
+///       variant has finished compiling it returns the fallback pipeline.
+class PipelineManager
+{
+public:
+    PipelineManager() = default;
+    ~PipelineManager() = default;
+
+    void Init(ThreadPool*              pThreadPool,
+              VkPipelineLayout         pipelineLayout,
+              const std::vector<char>& vertShaderCode,
+              const std::vector<char>& fragShaderCode,
+              VkFormat                 colorFormat,
+              VkFormat                 idFormat,
+              VkFormat                 depthFormat);
+    void Destroy();
+
+    void RequestVariant(EPipelineVariant variant);
+    void RequestAllVariants();
+
+    bool       IsReady(EPipelineVariant variant) const;
+    VkPipeline Get(EPipelineVariant variant) const;
+    uint32_t   ReadyCount() const;
+
+private:
+    VkPipeline CreatePipeline(EPipelineVariant variant);
+
+    ThreadPool*      m_pThreadPool      = nullptr;
+    VkPipelineLayout m_pipelineLayout   = VK_NULL_HANDLE;
+    VkPipelineCache  m_pipelineCache    = VK_NULL_HANDLE;
+    VkShaderModule   m_vertShaderModule = VK_NULL_HANDLE;
+    VkShaderModule   m_fragShaderModule = VK_NULL_HANDLE;
+    VkFormat         m_colorFormat      = VK_FORMAT_UNDEFINED;
+    VkFormat         m_idFormat         = VK_FORMAT_UNDEFINED; // Second color attachment for the object ids; undefined when there is none.
+    VkFormat         m_depthFormat      = VK_FORMAT_UNDEFINED;
+
+    std::array<std::atomic<VkPipeline>, NumPipelineVariants> m_pipelines{};
+    std::array<std::atomic<bool>, NumPipelineVariants>       m_requested{};
+};
+
+#endif // __PIPELINE_MANAGER_H__
@@ -0,0 +1,77 @@
+#ifndef __READBACK_RING_H__
+#define __READBACK_RING_H__
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool;
+
+///@brief Persistently mapped host buffers that finished images are copied into, used round-robin.
+///
+///       A frame records the copy of its final image into a slot and hands the slot over with the
+///       timeline value of its submission. Poll() passes the slots whose copies have completed to
+///       the worker threads, oldest first, which consume the pixels straight from the mapped memory;
+///       the slot is only reused after its consumer has returned. With more slots than frames in
+///       flight, the GPU renders the next frames while the previous ones are being consumed.
+///       A pool with a single worker consumes the slots in submission order.
+class ReadbackRing
+{
+public:
+    // Called on a worker thread with the tightly packed pixels of a slot.
+    using Consumer = std::function<void(const uint8_t* pPixels)>;
+
+    ReadbackRing() = default;
+    ~ReadbackRing() = default;
+
+    void Create(ThreadPool* pThreadPool, uint32_t slotCount, VkDeviceSize slotSize);
+    void Destroy();
+
+    // Returns the next slot, waiting for its previous copy and consumer first.
+    uint32_t Acquire();
+
+    // Copies a color image in TRANSFER_SRC_OPTIMAL layout into the slot.
+    void RecordCopy(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkExtent2D extent) const;
+
+    // The slot is consumed once the timeline reaches timelineValue.
+    void Submit(uint32_t slot, uint64_t timelineValue, Consumer consumer);
+
+    // Hands the slots whose copies have completed to the workers. Does not wait.
+    void Poll();
+
+    // Waits until every submitted slot has been consumed.
+    void Flush();
+
+    uint32_t     SlotCount() const { return static_cast<uint32_t>(m_slots.size()); }
+    VkDeviceSize SlotSize()  const { return m_slotSize; }
+
+private:
+    void Dispatch(uint32_t slot);
+    void WaitForConsumer(uint32_t slot);
+
+    struct Slot
+    {
+        VkBuffer       buffer        = VK_NULL_HANDLE;
+        VkDeviceMemory memory        = VK_NULL_HANDLE;
+        uint8_t*       pMapped       = nullptr;
+        uint64_t       timelineValue = 0;
+        bool           copyPending   = false; // Submitted, not dispatched yet.
+        bool           consuming     = false; // Dispatched, the consumer has not returned yet.
+        Consumer       consumer;
+    };
+
+    ThreadPool*       m_pThreadPool = nullptr;
+    VkDeviceSize      m_slotSize    = 0;
+    bool              m_coherent    = true; // Otherwise the mapped range is invalidated before it is read.
+    std::vector<Slot> m_slots;
+    uint32_t          m_nextSlot    = 0;
+
+    std::mutex              m_mutex; // Guards the consuming flags.
+    std::condition_variable m_consumed;
+};
+
+#endif // __READBACK_RING_H__
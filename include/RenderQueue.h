@@ -0,0 +1,65 @@
+#ifndef __RENDER_QUEUE_H__
+#define __RENDER_QUEUE_H__
+
+#include <cstdint>
+#include <vector>
+
+enum ERenderPass : unsigned int
+{
+    Opaque      = 0,
+    Transparent = 1,
+    Overlay     = 2,
+};
+
+struct DrawPacket
+{
+    uint64_t sortKey;
+    uint32_t objectIndex;
+};
+
+///@brief Collects the draws of a frame and orders them by a packed 64-bit sort key.
+///
+///       Key layout for the opaque and overlay passes (most significant bits first):
+///       | pass (4) | pipeline (10) | material (12) | mesh (14) | depth (24) |
+///       Draws sharing a pipeline, material and mesh are adjacent, so state changes are minimal,
+///       and within each batch the draws go front-to-back for early depth rejection.
+///
+///       The transparent pass must be blended back-to-front, so its inverted depth is placed
+///       right below the pass bits instead:
+///       | pass (4) | inverted depth (24) | pipeline (10) | material (12) | mesh (14) |
+class RenderQueue
+{
+public:
+    static constexpr uint32_t PassBits     = 4;
+    static constexpr uint32_t PipelineBits = 10;
+    static constexpr uint32_t MaterialBits = 12;
+    static constexpr uint32_t MeshBits     = 14;
+    static constexpr uint32_t DepthBits    = 24;
+
+    static uint64_t MakeSortKey(ERenderPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float viewDepth, float farPlane);
+
+    static ERenderPass PassOf(uint64_t sortKey);
+    static uint32_t    PipelineOf(uint64_t sortKey);
+    static uint32_t    MaterialOf(uint64_t sortKey);
+    static uint32_t    MeshOf(uint64_t sortKey);
+
+    void Clear()
+    {
+        m_packets.clear();
+    }
+
+    void Submit(uint64_t sortKey, uint32_t objectIndex)
+    {
+        m_packets.push_back({ sortKey, objectIndex });
+    }
+
+    void Sort();
+
+    const std::vector<DrawPacket>& Packets() const { return m_packets; }
+
+private:
+    std::vector<DrawPacket> m_packets;
+    std::vector<DrawPacket> m_scratch;
+};
+
+#endif // __RENDER_QUEUE_H__
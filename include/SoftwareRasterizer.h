@@ -0,0 +1,122 @@
+#ifndef __SOFTWARE_RASTERIZER_H__
+#define __SOFTWARE_RASTERIZER_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "Types.h"
+#include "BoardBuffer.h"
+#include "PipelineManager.h"
+#include "ThreadPool.h"
+
+///@brief One object to draw; what a single instance of an instanced draw reads on the GPU.
+struct SoftwareDraw
+{
+    const Vertex*    pVertices    = nullptr;
+    const uint32_t*  pIndices     = nullptr; // The indices of the level of detail to draw.
+    uint32_t         indexCount   = 0;
+    glm::mat4        world        = glm::mat4(1.0f);
+    uint32_t         textureIndex = 0;
+    uint32_t         board        = 0;
+    EPipelineVariant variant      = EPipelineVariant::Textured;
+};
+
+///@brief Renders the scene on the CPU, for machines without a usable Vulkan device.
+///
+///       It runs shader.vert and shader.frag over the same Model vertices and indices and the same
+///       BoardBuffer entries. The screen is split into tiles. Worker threads first transform, clip and set
+///       up the triangles of consecutive draws and sort them into the tiles they touch; then every tile is
+///       rasterized by one thread, four pixels at a time with SSE. Tiles share no pixels, so the second pass
+///       needs no locks, and the triangles of a tile stay in draw order for any number of threads.
+///       The buffers are kept between frames, so a frame of the same size does not allocate.
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer() = default;
+    ~SoftwareRasterizer() = default;
+
+    void Init(ThreadPool* pThreadPool);
+
+    // Takes a copy of 8-bit sRGB RGBA texels and returns the texture index the draws refer to.
+    uint32_t AddTexture(uint32_t width, uint32_t height, const uint8_t* pPixels);
+
+    void Resize(uint32_t width, uint32_t height);
+
+    ///@param viewProj  The camera, with the y flip of the Vulkan projection.
+    ///@param pBoards   The entries of the BoardBuffer, which the draws index with their board.
+    void Render(const glm::mat4& viewProj, const BoardData* pBoards, const std::vector<SoftwareDraw>& draws);
+
+    // The last frame as tightly packed 8-bit sRGB RGBA rows, top row first; the layout ReadPixels() returns.
+    const std::vector<uint8_t>& Pixels() const { return m_pixels; }
+    uint32_t                    Width()  const { return m_width; }
+    uint32_t                    Height() const { return m_height; }
+
+    // Triangles of the last frame that were left after culling and clipping.
+    uint64_t SetUpTriangles() const { return m_setUpTriangles; }
+
+private:
+    static const uint32_t ATTRIBUTE_COUNT = 5; // Texture coordinate and vertex color.
+
+    struct Texture
+    {
+        uint32_t             width  = 0;
+        uint32_t             height = 0;
+        std::vector<uint8_t> texels;
+    };
+
+    struct ClipVertex
+    {
+        glm::vec4 position;
+        float     attributes[ATTRIBUTE_COUNT];
+    };
+
+    ///@brief A triangle ready for rasterization. Every value is a plane a * x + b * y + c in pixel coordinates.
+    struct Triangle
+    {
+        glm::vec3 edges[3];                    // Positive inside; edge i is opposite corner i.
+        glm::vec3 depth;                       // z / w.
+        glm::vec3 inverseW;
+        glm::vec3 attributes[ATTRIBUTE_COUNT]; // Divided by w, so they interpolate with perspective.
+        int32_t   minX, minY, maxX, maxY;      // Pixels whose centers the triangle can cover.
+        uint32_t  draw;
+        uint32_t  topLeftEdges;                // Bit per edge; pixel centers exactly on these edges are covered.
+    };
+
+    // The triangles set up by one job, and for every tile the ones that touch it.
+    struct Chunk
+    {
+        std::vector<Triangle>              triangles;
+        std::vector<std::vector<uint32_t>> bins;
+    };
+
+    void      SetUpDraws(Chunk& chunk, uint32_t firstDraw, uint32_t endDraw, const glm::mat4& viewProj) const;
+    void      SetUpTriangle(const ClipVertex* pCorners, uint32_t draw, bool cullBackFaces, Chunk& chunk) const;
+    void      RasterizeTile(uint32_t tile);
+    void      RasterizeTriangle(const Triangle& triangle, int32_t tileX, int32_t tileY, int32_t endX, int32_t endY);
+    glm::vec3 Shade(const Triangle& triangle, const SoftwareDraw& draw, float x, float y) const;
+    glm::vec3 BoardColor(const SoftwareDraw& draw, glm::vec2 board) const;
+    glm::vec3 Sample(uint32_t textureIndex, glm::vec2 texCoord) const;
+
+    ThreadPool*          m_pThreadPool = nullptr;
+    std::vector<Texture> m_textures;
+    float                m_srgbToLinear[256]  = {};
+    uint8_t              m_linearToSrgb[4096] = {}; // Indexed with the linear value times 4095.
+
+    uint32_t             m_width       = 0;
+    uint32_t             m_height      = 0;
+    uint32_t             m_depthStride = 0; // Rounded up to four pixels, so the SSE loads stay inside the row.
+    uint32_t             m_tilesX      = 0;
+    uint32_t             m_tilesY      = 0;
+    std::vector<uint8_t> m_pixels;
+    std::vector<float>   m_depth;
+
+    std::vector<Chunk>  m_chunks;
+    uint32_t            m_chunkCount     = 0; // Chunks used by the current frame.
+    uint64_t            m_setUpTriangles = 0;
+
+    // Only valid during Render().
+    const std::vector<SoftwareDraw>* m_pDraws  = nullptr;
+    const BoardData*                 m_pBoards = nullptr;
+};
+
+#endif // __SOFTWARE_RASTERIZER_H__
@@ -0,0 +1,57 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+///@brief A fixed set of worker threads consuming a FIFO job queue.
+///
+///       A job that throws does not take its worker down: the first exception is kept and rethrown by
+///       the next WaitIdle(), and the other jobs still run.
+class ThreadPool
+{
+public:
+    ThreadPool() = default;
+    ~ThreadPool()
+    {
+        Stop();
+    }
+
+    void Start(uint32_t threadCount);
+    void Stop();
+
+    void Enqueue(std::function<void()> job);
+
+    // Waits until the queue is empty and no job runs, then rethrows the first exception a job threw since the last call.
+    void WaitIdle();
+
+    ///@brief Calls body(begin, end) for consecutive ranges of at most grainSize items covering [0, count),
+    ///       on the workers and the calling thread, and returns once all ranges are done.
+    ///@note  The calling thread takes ranges itself, so it never waits on jobs queued before the call.
+    ///       When body throws, the remaining ranges still run and the first exception is rethrown here.
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body);
+
+    uint32_t ThreadCount() const { return static_cast<uint32_t>(m_threads.size()); }
+
+    static uint32_t DefaultThreadCount();
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread>          m_threads;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex                        m_mutex;
+    std::condition_variable           m_jobAvailable;
+    std::condition_variable           m_idle;
+    uint32_t                          m_activeJobs = 0;
+    bool                              m_stopping   = false;
+    std::exception_ptr                m_error;     // First exception thrown by a job, guarded by m_mutex.
+};
+
+#endif // __THREAD_POOL_H__
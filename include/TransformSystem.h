@@ -0,0 +1,76 @@
+#ifndef __TRANSFORM_SYSTEM_H__
+#define __TRANSFORM_SYSTEM_H__
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+const uint32_t NO_PARENT = UINT32_MAX;
+
+///@brief Hierarchy of transforms with the local translation, rotation and scale stored as structure of arrays.
+///
+///       Setting a local value only marks the node dirty. Update() sorts the nodes by depth when the
+///       hierarchy has changed, then computes the world matrices one depth level at a time, so every
+///       parent is final before its children read it. Only nodes whose local values or parent changed
+///       are recomputed, and large levels are split across the worker threads.
+class TransformSystem
+{
+public:
+    TransformSystem() = default;
+    ~TransformSystem() = default;
+
+    uint32_t Create(uint32_t parent = NO_PARENT);
+    void     Clear();
+
+    void SetParent(uint32_t node, uint32_t parent);
+    void SetPosition(uint32_t node, const glm::vec3& position);
+    void SetRotation(uint32_t node, const glm::quat& rotation);
+    void SetScale(uint32_t node, const glm::vec3& scale);
+
+    glm::vec3 Position(uint32_t node) const { return glm::vec3(m_positionX[node], m_positionY[node], m_positionZ[node]); }
+    glm::quat Rotation(uint32_t node) const { return glm::quat(m_rotationW[node], m_rotationX[node], m_rotationY[node], m_rotationZ[node]); }
+    glm::vec3 Scale(uint32_t node)    const { return glm::vec3(m_scaleX[node], m_scaleY[node], m_scaleZ[node]); }
+    uint32_t  Parent(uint32_t node)   const { return m_parents[node]; }
+    uint32_t  Count()                 const { return static_cast<uint32_t>(m_parents.size()); }
+
+    // Recomputes the world matrices of the dirty nodes and their descendants.
+    ///@note A null thread pool updates everything on the calling thread.
+    void Update(ThreadPool* pThreadPool);
+
+    const glm::mat4& WorldMatrix(uint32_t node) const { return m_worldMatrices[node]; }
+    bool             WorldChanged(uint32_t node) const { return m_worldChanged[node] != 0; } // During the last Update().
+
+private:
+    void SortByDepth();
+    void UpdateRange(const uint32_t* nodes, uint32_t count);
+
+    // Local transform, one array per component.
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_positionZ;
+    std::vector<float> m_rotationX;
+    std::vector<float> m_rotationY;
+    std::vector<float> m_rotationZ;
+    std::vector<float> m_rotationW;
+    std::vector<float> m_scaleX;
+    std::vector<float> m_scaleY;
+    std::vector<float> m_scaleZ;
+
+    std::vector<uint32_t>  m_parents;
+    std::vector<uint8_t>   m_localDirty;   // Bytes rather than bits, so worker threads can write neighbours.
+    std::vector<uint8_t>   m_worldChanged;
+    std::vector<glm::mat4> m_worldMatrices;
+
+    // Nodes sorted by depth; level i is m_depthOrder[m_levelStarts[i], m_levelStarts[i + 1]).
+    std::vector<uint32_t> m_depthOrder;
+    std::vector<uint32_t> m_levelStarts;
+    bool                  m_hierarchyDirty = false;
+};
+
+#endif // __TRANSFORM_SYSTEM_H__
\ No newline at end of file
@@ -57,10 +57,23 @@ struct Vertex
     }
 };
 
-struct ModelPushConstants
+///@brief Per-object data read by the shaders, indexed with gl_InstanceIndex.
+///       Must match the std430 layout of ObjectData in shader.vert.
+struct ObjectData
 {
-    glm::mat4 model;
-    glm::mat4 normailzeMatrix;
+    glm::mat4 world        = glm::mat4(1.0f); // Model matrix premultiplied with the normalization matrix.
+    uint32_t  textureIndex = 0;               // Index into the bindless texture array.
+    uint32_t  board        = 0;               // Index into the BoardBuffer, which places the object's board on the screen.
+    uint32_t  padding[2]   = {};              // std430 rounds the struct up to the alignment of the mat4.
+};
+static_assert(sizeof(ObjectData) == 80, "ObjectData must match the std430 layout in shader.vert");
+
+///@brief Model space bounding box of an object, read by the occlusion culling pass.
+///       Must match the std430 layout of ObjectBounds in cull.comp.
+struct ObjectBounds
+{
+    glm::vec4 center  = glm::vec4(0.0f);
+    glm::vec4 extents = glm::vec4(0.0f);
 };
 
 #endif // __TYPES_H__
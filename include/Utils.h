@@ -27,4 +27,14 @@ static std::vector<char> ReadFile(const std::string& filename)
     return buffer;
 }
 
+// CPU time used by all threads of the process so far, in seconds.
+double ProcessCpuTime();
+
+// Seconds on a monotonic clock from an arbitrary start. Unlike glfwGetTime() it works without GLFW.
+double MonotonicTime();
+
+// Whether the Vulkan loader library can be loaded. The executable delay loads it on Windows,
+// so this has to be checked before the first Vulkan call.
+bool VulkanLoaderAvailable();
+
 #endif // __UTILS_H__
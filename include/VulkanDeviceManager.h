@@ -9,6 +9,10 @@
 #include <cassert>
 #include <iostream>
 #include <optional>
+#include <set>
+#include <string>
+#include <deque>
+#include <functional>
 
 #include "VulkanSurfaceManager.h"
 
@@ -42,6 +46,8 @@ public:
     VkQueue          PresentQueue()   const { return m_presentQueue; }
     VkCommandPool    CommandPool()    const { return m_commandPool; }
 
+    const VkPhysicalDeviceFeatures& EnabledFeatures() const { return m_enabledFeatures; }
+
     VulkanSurfaceManager* SurfaceManager() const { return m_pSurfaceManager; }
 
     void DestroyValidationLayerNames();
@@ -50,9 +56,19 @@ public:
     void DestroyDeviceExtensionNames();
     void EnableDeviceExtensions(const std::vector<const char*>* pDeviceExtension);
 
+    // Optional extensions are enabled when the picked device supports them; they do not affect device selection.
+    void EnableOptionalDeviceExtensions(const std::vector<const char*>* pDeviceExtensions);
+    bool IsDeviceExtensionEnabled(const char* extensionName) const;
+
     void CreateGlfwWindow(int width, int height);
     void CreateSurface();
 
+    ///@brief Headless devices render into offscreen images in place of a window and a swap chain, so they
+    ///       need neither GLFW nor the surface and swap chain extensions. Set before creating the instance.
+    void SetHeadless(bool headless) { m_headless = headless; }
+    bool IsHeadless() const         { return m_headless; }
+    void CreateHeadlessTarget(int width, int height);
+
     std::vector<const char*> GetRequiredExtensions();
     void CreateInstance();
     void DestroyInstance();
@@ -66,6 +82,26 @@ public:
     void CreateLogicalDevice();
     void DestroyLogicalDevice();
 
+    ///@brief One timeline semaphore tracks GPU progress for every submission to the graphics queue.
+    ///       Each submission signals the next value, so everything submitted up to a value has
+    ///       finished once the counter reaches it.
+    VkSemaphore TimelineSemaphore()          const { return m_timelineSemaphore; }
+    uint64_t    LastSubmittedTimelineValue() const { return m_timelineValue; }
+    uint64_t    CompletedTimelineValue()     const;
+    uint64_t    NextTimelineValue()                { return ++m_timelineValue; }
+    void        WaitForTimelineValue(uint64_t value) const;
+
+    ///@brief Central retire queue for GPU objects that submitted work may still use.
+    ///       Without a timeline value, the callback runs after the next submission to the graphics queue
+    ///       has completed, which also covers work that is recorded but not submitted yet and presents
+    ///       queued before that submission. With one, it runs as soon as the timeline reaches it.
+    ///       Nothing on the frame path has to wait for the device to destroy a resource.
+    void DeferDestruction(std::function<void()> destroy);
+    void DeferDestruction(std::function<void()> destroy, uint64_t timelineValue);
+
+    // Runs the callbacks of everything the GPU is done with. Cheap when nothing is due.
+    void DestroyRetiredResources();
+
     void CreateSwapChain();
     void DestroySwapChain();
 
@@ -98,20 +134,44 @@ public:
         return commandBuffer;
     }
 
-    void EndSingleTimeCommands(
+    // Submits without waiting. Returns the timeline value the submission signals; resources it uses
+    // can be retired with that value.
+    uint64_t SubmitSingleTimeCommands(
         VkCommandBuffer commandBuffer)
     {
         vkEndCommandBuffer(commandBuffer);
 
+        uint64_t signalValue = NextTimelineValue();
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues    = &signalValue;
+
         VkSubmitInfo submitInfo{};
         submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext                = &timelineInfo;
         submitInfo.commandBufferCount   = 1;
         submitInfo.pCommandBuffers      = &commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores    = &m_timelineSemaphore;
 
         vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(m_graphicsQueue);
 
-        vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+        DeferDestruction([this, commandBuffer]()
+        {
+            vkFreeCommandBuffers(m_device, m_commandPool, 1, &commandBuffer);
+        }, signalValue);
+
+        return signalValue;
+    }
+
+    // Waits for this submission only, not for the frames that may be in flight on the same queue.
+    void EndSingleTimeCommands(
+        VkCommandBuffer commandBuffer)
+    {
+        WaitForTimelineValue(SubmitSingleTimeCommands(commandBuffer));
+        DestroyRetiredResources();
     }
 
     static bool CheckValidationLayerSupport(const std::vector<const char*>& validationLayers);
@@ -131,13 +191,28 @@ private:
 
     VkCommandPool m_commandPool = VK_NULL_HANDLE;
 
+    VkSemaphore m_timelineSemaphore = VK_NULL_HANDLE;
+    uint64_t    m_timelineValue     = 0; // Last value signaled by a submission.
+
+    struct RetiredResource
+    {
+        uint64_t              timelineValue; // Destroyed once the timeline reaches this value.
+        std::function<void()> destroy;
+    };
+    std::deque<RetiredResource> m_retiredResources; // Sorted by timeline value.
+
+    VkPhysicalDeviceFeatures m_enabledFeatures{};
+
     VkDebugUtilsMessengerEXT m_debugMessenger = VK_NULL_HANDLE;
 
     VulkanSurfaceManager* m_pSurfaceManager = nullptr;
 
+    bool                     m_headless               = false;
     bool                     m_enableValidationLayers = false;
     std::vector<const char*> m_validationLayers;
     std::vector<const char*> m_deviceExtensions;
+    std::vector<std::string> m_optionalDeviceExtensions;
+    std::set<std::string>    m_enabledDeviceExtensions;
 };
 
 extern VulkanDeviceManager* g_pVk;
@@ -62,10 +62,15 @@ static void CreateBuffer(
     vkBindBufferMemory(device, buffer, bufferMemory, 0);
 }
 
-static void CopyBuffer(
-    VkBuffer        srcBuffer,
-    VkBuffer        dstBuffer,
-    VkDeviceSize    size)
+// Returns the timeline value of the copy; the source can be retired with it.
+///@note Nothing waits for the copy, so it ends with a barrier that makes the data visible to the given
+///      stages and accesses of everything submitted later to the same queue, like the frames.
+static uint64_t CopyBuffer(
+    VkBuffer                srcBuffer,
+    VkBuffer                dstBuffer,
+    VkDeviceSize            size,
+    VkPipelineStageFlags    dstStageMask,
+    VkAccessFlags           dstAccessMask)
 {
     VkCommandBuffer commandBuffer = VK.BeginSingleTimeCommands();
 
@@ -73,10 +78,29 @@ static void CopyBuffer(
     copyRegion.size = size;
     vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-    VK.EndSingleTimeCommands(commandBuffer);
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = dstAccessMask;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = dstBuffer;
+    barrier.offset              = 0;
+    barrier.size                = size;
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+        0,
+        0, nullptr,
+        1, &barrier,
+        0, nullptr);
+
+    return VK.SubmitSingleTimeCommands(commandBuffer);
 }
 
-static void CopyBufferToImage(
+// Returns the timeline value of the copy; the source can be retired with it.
+static uint64_t CopyBufferToImage(
     VkBuffer    buffer,
     VkImage     image,
     uint32_t    width,
@@ -102,7 +126,43 @@ static void CopyBufferToImage(
 
     vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
 
-    VK.EndSingleTimeCommands(commandBuffer);
+    return VK.SubmitSingleTimeCommands(commandBuffer);
+}
+
+static void RecordImageBarrier(
+    VkCommandBuffer         commandBuffer,
+    VkImage                 image,
+    VkImageAspectFlags      aspectMask,
+    VkImageLayout           oldLayout,
+    VkImageLayout           newLayout,
+    VkPipelineStageFlags    srcStageMask,
+    VkAccessFlags           srcAccessMask,
+    VkPipelineStageFlags    dstStageMask,
+    VkAccessFlags           dstAccessMask)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout                       = oldLayout;
+    barrier.newLayout                       = newLayout;
+    barrier.srcAccessMask                   = srcAccessMask;
+    barrier.dstAccessMask                   = dstAccessMask;
+    barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image                           = image;
+    barrier.subresourceRange.aspectMask     = aspectMask;
+    barrier.subresourceRange.baseMipLevel   = 0;
+    barrier.subresourceRange.levelCount     = VK_REMAINING_MIP_LEVELS;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount     = VK_REMAINING_ARRAY_LAYERS;
+
+    vkCmdPipelineBarrier(
+        commandBuffer,
+        srcStageMask, dstStageMask,
+        0,
+        0, nullptr,
+        0, nullptr,
+        1, &barrier
+    );
 }
 
 static VkShaderModule CreateShaderModule(const std::vector<char>& code)
@@ -25,28 +25,62 @@ public:
     }
 
     void InitWindow(int width, int height);
+    void InitHeadless(int width, int height);
     void CreateSurface();
     void DestroySurface();
 
     SwapChainSupportDetails         QuerySwapChainSupport(VkPhysicalDevice device);
     VkSurfaceFormatKHR              ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
+    void                            SetSwapChainPreferences(const std::vector<VkPresentModeKHR>& presentModes, uint32_t imageCount);
     VkPresentModeKHR                ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D                      ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
     void                            CreateSwapChain();
     void                            DestroySwapChain();
 
-    GLFWwindow*                     Window()  const { return m_window; }
-    VkSurfaceKHR                    Surface() const { return m_surface; }
+    ///@brief Destroys the semaphores presents of the current swap chain wait on, together with that swap chain
+    ///       once it has been replaced and released, see MarkImageAcquired().
+    void                            RetirePresentSemaphores(const std::vector<VkSemaphore>& semaphores);
+
+    // Frames in flight of the renderer, which decides how long replaced swap chains are kept.
+    void                            SetFramesInFlight(uint32_t framesInFlight) { m_framesInFlight = framesInFlight; }
+
+    ///@brief Called after each image acquired from the current swap chain. A replaced swap chain and its
+    ///       present semaphores are released once the new one has acquired an image per frame in flight,
+    ///       and destroyed when the frame that acquired the last of them has completed.
+    ///@note  Without the present fences of VK_EXT_swapchain_maintenance1, which is not enabled, nothing
+    ///       signals that a present is done with its semaphore. The presents of the old swap chain were
+    ///       queued before any of the new one, so by then the presentation engine has moved on to the
+    ///       new images; this is the usual approximation, not a guarantee the API gives.
+    void                            MarkImageAcquired();
+
+    GLFWwindow*                     Window()   const { return m_window; }
+    VkSurfaceKHR                    Surface()  const { return m_surface; }
+    bool                            Headless() const { return m_headless; }
 
     VkSwapchainKHR                  SwapChain()            const { return m_swapChain; }
     const VkExtent2D                SwapChainExtent()      const { return m_swapChainExtent; }
     const std::vector<VkImage>&     SwapChainImages()      const { return m_swapChainImages; }
     VkFormat                        SwapChainImageFormat() const { return m_swapChainImageFormat; }
     const std::vector<VkImageView>& SwapChainImageViews()  const { return m_swapChainImageViews; }
+    VkPresentModeKHR                PresentMode()          const { return m_presentMode; }
+    bool                            SwapChainReadable()    const { return m_headless || m_swapChainReadable; } // Images can be copied from.
     
 
     void GetGlfwFrameBufferSize(int* pWidth, int* pHeight);
 private:
+    void CreateHeadlessImages();
+
+    // A replaced swap chain, kept with its image views and present semaphores until MarkImageAcquired() releases it.
+    struct RetiredSwapChain
+    {
+        VkSwapchainKHR           swapChain    = VK_NULL_HANDLE;
+        std::vector<VkImageView> imageViews;
+        std::vector<VkSemaphore> presentSemaphores;
+        uint32_t                 acquiresLeft = 0; // Images the newer swap chains still have to acquire.
+    };
+
+    void DestroyRetiredSwapChain(const RetiredSwapChain& retired) const;
+
     VulkanDeviceManager*     m_pDeviceManager = nullptr;
 
     VkSurfaceKHR             m_surface = VK_NULL_HANDLE;
@@ -57,6 +91,20 @@ private:
     std::vector<VkImage>     m_swapChainImages;
     VkFormat                 m_swapChainImageFormat = VK_FORMAT_UNDEFINED;
     std::vector<VkImageView> m_swapChainImageViews;
+    VkPresentModeKHR         m_presentMode          = VK_PRESENT_MODE_FIFO_KHR;
+    bool                     m_swapChainReadable    = false;
+    std::vector<VkSemaphore> m_retiredPresentSemaphores; // Destroyed with m_swapChain.
+
+    std::vector<RetiredSwapChain> m_retiredSwapChains;
+    uint32_t                      m_framesInFlight = 1;
+
+    ///@note Headless, the swap chain images are plain offscreen images that this class owns.
+    bool                        m_headless       = false;
+    VkExtent2D                  m_headlessExtent = {};
+    std::vector<VkDeviceMemory> m_headlessImageMemory;
+
+    std::vector<VkPresentModeKHR> m_preferredPresentModes = { VK_PRESENT_MODE_MAILBOX_KHR };
+    uint32_t                      m_preferredImageCount   = 0; // 0 picks one more than the minimum.
 };
 
 #endif // __VULKAN_SURFACE_MANAGER_H__
@@ -6,15 +6,69 @@
 
 #include <vector>
 #include <optional>
+#include <string>
+#include <atomic>
+#include <array>
+#include <istream>
 
 #include "Model.h"
+#include "Bvh.h"
+#include "TransformSystem.h"
+#include "AnimationSystem.h"
+#include "RenderQueue.h"
+#include "DescriptorAllocator.h"
+#include "PipelineManager.h"
+#include "ThreadPool.h"
+#include "ObjectBuffer.h"
+#include "BoardBuffer.h"
+#include "ReadbackRing.h"
+#include "ImageWriter.h"
+#include "FrameCapture.h"
+#include "OcclusionCuller.h"
+#include "LatencyProfile.h"
+#include "FramePacer.h"
+#include "DynamicResolution.h"
+#include "SoftwareRasterizer.h"
 
 #include "VulkanSurfaceManager.h"
 #include "MemoryTracker.h"
 
+// One drawn instance of a model. Several objects can share a model.
+struct SceneObject
+{
+    uint32_t model;     // Index into m_models, an EModel value.
+    uint32_t transform; // Node of the object in m_transforms.
+    int      square = -1;    // Square a piece stands on, 0 is a1; -1 for the board and captured pieces.
+    bool     black  = false;
+    bool     hidden = false; // Spare pieces that the current position does not use.
+    uint32_t board  = 0;     // Index into m_boards and the board buffer.
+};
+
+// Chess state of one board, which the moves animate.
+struct BoardState
+{
+    std::array<uint32_t, 64> squareObjects;           // Piece on each square, UINT32_MAX when empty.
+    uint32_t                 capturedCounts[2] = {};  // Captured white and black pieces, which line up beside the board.
+    int                      lastMoveFrom      = -1;
+    int                      lastMoveTo        = -1;
+};
+
+struct Texture
+{
+    VkImage        image       = VK_NULL_HANDLE;
+    VkDeviceMemory imageMemory = VK_NULL_HANDLE;
+    VkImageView    imageView   = VK_NULL_HANDLE;
+};
+
 class WizardChess {
 public:
-    WizardChess(int width, int height) : m_width(width), m_height(height) {}
+    WizardChess(int width, int height, ELatencyProfile latencyProfile = ELatencyProfile::Balanced)
+        : m_width(width)
+        , m_height(height)
+        , m_latencyProfile(latencyProfile)
+        , m_framesInFlight(GetLatencyProfileSettings(latencyProfile).framesInFlight)
+    {
+    }
     ~WizardChess();
 
     void run();
@@ -23,70 +77,281 @@ public:
         m_framebufferResized = true;
     }
 
+    // Requests a redraw. Thread-safe, so results computed off the main thread can call it.
+    void Invalidate();
+    void ToggleAnimation();
+
+    // Scales the screen-space error the levels of detail may have by 2^bias; positive values trade detail for speed.
+    void  SetLodBias(float bias) { m_lodBias = bias; }
+    float LodBias() const        { return m_lodBias; }
+
+    // Selects the piece or board square under the cursor, given in window coordinates.
+    ///@note Picking a square or a piece while a piece is selected moves the selected piece there.
+    void Pick(double cursorX, double cursorY);
+
+    // Picks with the object id buffer instead of ray casts. Must be set before run().
+    void SetGpuPicking(bool enabled) { m_gpuPicking = enabled; }
+
+    ///@brief Renders into offscreen images without a window; must be set before Init().
+    ///       GLFW is not used at all, so this works on machines without a display and with software
+    ///       devices that have no surface support. Drive it with RenderFrame() and ReadPixels().
+    void SetHeadless(bool headless) { m_headless = headless; }
+
+    ///@brief Renders on the CPU instead of with Vulkan; must be set before Init().
+    ///       Init() also switches to it when no Vulkan device can be created. Windowed, the frames are
+    ///       shown with OpenGL 1.1, which any driver has; headless, everything but capturing works as usual.
+    void SetSoftwareRendering(bool enabled) { m_softwareRendering = enabled; }
+    bool SoftwareRendering() const          { return m_softwareRendering; }
+
+    // run() is Init(), MainLoop(), then Shutdown(); called one by one, the scene can be set up after Init().
+    void Init();
+    void MainLoop();
+    void Shutdown();
+
+    struct UsageReport
+    {
+        double frameRate = 0.0;
+        double cpuUsage  = 0.0;  // Percent of one core, so worker threads can take it past 100.
+        double gpuUsage  = -1.0; // Percent of the GPU time the frames took, negative without timestamp queries.
+    };
+
+    ///@brief Runs the main loop for the given seconds, with the turntable spinning or paused, and reports
+    ///       what the process used meanwhile. Called after Init() instead of MainLoop(); not headless.
+    ///@note  The GPU usage only covers the frames of this process, not the compositor presenting them.
+    UsageReport MeasureUsage(double seconds, bool animating);
+
+    // Renders one frame into the next offscreen image. Headless only.
+    void RenderFrame();
+
+    // Waits for the last rendered frame and copies it out as tightly packed 8-bit RGBA rows, top row first.
+    void ReadPixels(std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+
+    ///@brief Shows boardCount boards, each in its own tile of the screen; must be set before Init().
+    ///       The boards share the meshes, textures and buffers, and copies of a piece on all boards are
+    ///       drawn together, so the number of draws does not grow with the number of boards.
+    ///@note  The wall is for watching games; picking is off.
+    void     SetSpectatorWall(uint32_t boardCount) { m_boardCount = boardCount; }
+    uint32_t BoardCount() const                    { return m_boardCount; }
+
+    // Sets up the pieces of a position in Forsyth-Edwards notation. Only the piece placement field is used.
+    ///@note Returns false and leaves the board as it is when the placement is malformed, or when its extra
+    ///      pieces, like promoted queens, would take more objects than the object buffers hold.
+    bool LoadFen(const std::string& fen, uint32_t board = 0);
+
+    // Animates a move in coordinate notation like e2e4 on a board. The moves are not checked against the rules.
+    ///@note Returns false when the move is malformed or its start square is empty.
+    bool PlayMove(const std::string& move, uint32_t board = 0);
+
+    ///@brief Renders the position on each line of positions to <outputPrefix><line number>.<format>. Headless only.
+    ///       Several frames are in flight and the images are encoded on the worker threads meanwhile,
+    ///       so the GPU is never idle waiting for a readback. Returns the number of images written.
+    uint32_t RenderBatch(std::istream& positions, const std::string& outputPrefix, EImageFormat format);
+
+    ///@brief Streams every rendered frame to a video file, or to stdout for "-"; must be set before Init().
+    ///       Windowed, the presented images are captured, so the board is redrawn every frame meanwhile.
+    ///@note While capturing, the frames are paced to frameRate and the animations advance by exactly one
+    ///      video frame per captured frame, so the video plays at the speed of the scene even when the
+    ///      frames could not be rendered and written that fast.
+    void SetCapture(const std::string& path, ECaptureFormat format, uint32_t frameRate)
+    {
+        m_capturePath      = path;
+        m_captureFormat    = format;
+        m_captureFrameRate = frameRate;
+    }
+
+    uint32_t CapturedFrames() const { return m_frameCapture.CapturedFrames(); }
+    uint32_t DroppedFrames()  const { return m_frameCapture.DroppedFrames(); }
+    double   SustainedFrameRate() const { return m_frameCapture.SustainedFrameRate(); }
+
 private:
     void     InitVulkan();
-    void     MainLoop();
-    void     CleanupSwapChain();
+    void     InitSoftware();
+    void     CleanupSoftware();
+    void     RenderSoftwareFrame();
+    void     DrawSoftwareFrame();
+    GLFWwindow* Window() const;
+    void     RetireSwapChainResources();
     void     Cleanup();
     void     RecreateSwapChain();
-    void     CreateRenderPass();
     void     CreateDescriptorSetLayout();
     void     CreateGraphicsPipeline();
-    void     CreateFramebuffers();
+    void     CreateColorResources();
+    void     CreateIdResources();
+    void     CreatePickReadbackBuffers();
     void     CreateDepthResources();
     VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
     VkFormat FindDepthFormat();
     bool     HasStencilComponent(VkFormat format);
-    void     CreateTextureImage();
-    void     CreateTextureImageView();
+    uint32_t CreateTextureImage(const std::string& fileName);
+    void     CreateTextureImageView(Texture& texture);
     void     CreateTextureSampler();
+    void     WriteBindlessTextures(uint32_t firstTexture, uint32_t textureCount);
     void     CreateImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory);
     void     TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
     void     LoadModel();
+    uint32_t AddObject(uint32_t model, uint32_t transform, uint32_t board);
+    uint32_t AddPiece(uint32_t model, int file, int rank, bool black, uint32_t board);
+    void     LayOutWall();
+    void     PlacePiece(uint32_t objectIndex, int square);
+    Model*   ObjectModel(uint32_t objectIndex) const { return m_models[m_objects[objectIndex].model]; }
+    float    PieceHalfHeight(uint32_t model) const;
+    void     HandlePick();
+    void     MovePiece(uint32_t objectIndex, int square);
+    uint64_t AttackedSquares(uint32_t objectIndex) const;
+    void     UpdateBoardSquares(uint32_t board);
     void     CreateUniformBuffers();
-    void     CreateDescriptorPool();
+    double   AnimationClock() const;
+    void     UpdateObjects();
+    void     UpdateObjectBuffer(uint32_t currentImage);
+    void     CreateDescriptorAllocators();
     void     CreateDescriptorSets();
+    void     BeginRendering(VkCommandBuffer commandBuffer, VkAttachmentLoadOp loadOp);
+    void     SelectLods(uint32_t renderHeight);
+    void     BuildRenderQueue();
+    void     RecordDraws(VkCommandBuffer commandBuffer, VkBuffer drawCommandBuffer);
+    void     RecordPickReadback(VkCommandBuffer commandBuffer);
+    void     ResolvePickReadbacks();
     void     RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    void     SubmitFrame(uint32_t imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore);
+    void     GetWindowSize(int* pWidth, int* pHeight) const;
+    void     CreateRenderFinishedSemaphores();
     void     CreateSyncObjects();
+    void     UpdateCamera(VkExtent2D extent);
     void     UpdateUniformBuffer(uint32_t currentImage, int modelIndex);
+    void     UpdateFrameStats();
+    void     RunMainLoop(double endTime);
     void     DrawFrame();
+    bool     NeedsRedraw() const;
 
     int m_width;
     int m_height;
 
-    std::vector<VkFramebuffer> m_swapChainFramebuffers;
+    ELatencyProfile m_latencyProfile;
+    uint32_t        m_framesInFlight; // Sizes every per-frame resource.
 
-    VkRenderPass            m_renderPass = VK_NULL_HANDLE;
     VkDescriptorSetLayout   m_descriptorSetLayout;
     VkPipelineLayout        m_pipelineLayout;
-    VkPipeline              m_graphicsPipeline;
+    PipelineManager         m_pipelineManager;
+
+    ThreadPool              m_threadPool;
+
+    // The scene is rendered into the color image at the dynamic resolution, then upscaled into the swap chain image.
+    VkImage                 m_colorImage;
+    VkDeviceMemory          m_colorImageMemory;
+    VkImageView             m_colorImageView;
+    VkFilter                m_upscaleFilter = VK_FILTER_NEAREST;
+    DynamicResolution       m_dynamicResolution;
 
     VkImage                 m_depthImage;
     VkDeviceMemory          m_depthImageMemory;
     VkImageView             m_depthImageView;
 
-    VkImage                 m_textureImage;
-    VkDeviceMemory          m_textureImageMemory;
-    VkImageView             m_textureImageView;
+    std::vector<Texture>    m_textures;
     VkSampler               m_textureSampler;
+    uint32_t                m_maxBindlessTextures = 0;
+
+    std::vector<Model*>      m_models;  // One per EModel.
+    std::vector<SceneObject> m_objects; // Indexed like the object buffer.
+    TransformSystem          m_transforms;
+    uint32_t                 m_sceneRoot = NO_PARENT;
+
+    // The boards all stand at the origin below the scene root; the board buffer moves each into its tile.
+    AnimationSystem          m_animations;
+    std::vector<BoardState>  m_boards;
+    uint32_t                 m_boardCount    = 1;
+    uint32_t                 m_wallColumns   = 1;
+    uint32_t                 m_wallRows      = 1;
+    uint32_t                 m_selectedPiece = UINT32_MAX;
+
+    glm::mat4               m_viewMatrix = glm::mat4(1.0f);
+    glm::mat4               m_projMatrix = glm::mat4(1.0f);
+
+    RenderQueue             m_renderQueue;
 
-    std::vector<Model*>     m_models;
+    float                   m_lodBias = 0.0f;
+    std::vector<uint32_t>   m_objectLods;         // Level of detail of each object in the last frame.
+    uint64_t                m_frameTriangles = 0; // Triangles submitted by the last frame, before culling.
+
+    Bvh                     m_sceneBvh;                     // Over the world bounds of the objects, rebuilt for every pick.
+    uint32_t                m_pickedObject = UINT32_MAX;
+    int                     m_pickedSquare = -1;            // 0 is a1, 63 is h8.
+    double                  m_pickTime     = 0.0;           // Seconds the last pick took.
+
+    // With GPU picking, every draw also writes its object index plus one into the id image, and a click
+    // copies the id under the cursor into a small host-visible buffer of the frame. It is read once the
+    // frame has completed on the timeline, one or two frames later, so picking never stalls the GPU.
+    bool                        m_gpuPicking    = false;
+    VkImage                     m_idImage       = VK_NULL_HANDLE;
+    VkDeviceMemory              m_idImageMemory = VK_NULL_HANDLE;
+    VkImageView                 m_idImageView   = VK_NULL_HANDLE;
+    std::vector<VkBuffer>       m_pickReadbackBuffers;
+    std::vector<VkDeviceMemory> m_pickReadbackBuffersMemory;
+    std::vector<void*>          m_pickReadbackBuffersMapped;
+    std::vector<bool>           m_pickReadbackPending; // The frame copied a pick into its readback buffer.
+    bool                        m_pickRequested = false;
+    double                      m_pickCursorX   = 0.0;
+    double                      m_pickCursorY   = 0.0;
+    double                      m_pickStartTime = 0.0;
+
+    OcclusionCuller                           m_occlusionCuller;
+    bool                                      m_occlusionCulling = false;
+    std::vector<VkDrawIndexedIndirectCommand> m_drawCommands;
 
     std::vector<VkBuffer>       m_uniformBuffers;
     std::vector<VkDeviceMemory> m_uniformBuffersMemory;
     std::vector<void*>          m_uniformBuffersMapped;
 
-    VkDescriptorPool             m_descriptorPool;
-    std::vector<VkDescriptorSet> m_descriptorSets;
+    ObjectBuffer                m_objectBuffer;
+    BoardBuffer                 m_boardBuffer;
+
+    DescriptorAllocator              m_globalDescriptorAllocator;
+    std::vector<DescriptorAllocator> m_frameDescriptorAllocators;
+    std::vector<VkDescriptorSet>     m_descriptorSets;
 
     std::vector<VkCommandBuffer> m_commandBuffers;
 
     std::vector<VkSemaphore> m_imageAvailableSemaphores;
-    std::vector<VkSemaphore> m_renderFinishedSemaphores;
-    std::vector<VkFence>     m_inFlightFences;
+    std::vector<VkSemaphore> m_renderFinishedSemaphores; // One per swap chain image.
+    std::vector<uint64_t>    m_frameTimelineValues; // Timeline value signaled by the last submission of each frame.
     uint32_t                 m_currentFrame = 0;
 
+    FramePacer               m_framePacer;
+    double                   m_refreshInterval = 1.0 / 60.0; // Seconds between refreshes of the display showing the window.
+
     bool m_framebufferResized = false;
+
+    bool           m_headless                   = false;
+    uint32_t       m_lastRenderedImage          = UINT32_MAX;
+    VkBuffer       m_headlessReadbackBuffer     = VK_NULL_HANDLE; // Created on the first ReadPixels().
+    VkDeviceMemory m_headlessReadbackMemory     = VK_NULL_HANDLE;
+    VkDeviceSize   m_headlessReadbackBufferSize = 0;
+    ReadbackRing   m_readbackRing;                                // Created by the first RenderBatch().
+    uint32_t       m_captureSlot                = UINT32_MAX;     // Slot of m_readbackRing the next frame copies its image into.
+
+    FrameCapture   m_frameCapture;
+    std::string    m_capturePath;
+    ECaptureFormat m_captureFormat              = ECaptureFormat::Y4m;
+    uint32_t       m_captureFrameRate           = 60;
+    bool           m_captureFrame               = false; // The frame being recorded copies its image into m_frameCapture.
+    double         m_captureTime                = 0.0;   // The animation clock while capturing, one video frame per captured frame.
+
+    // Without a Vulkan device, the frames are rasterized on the CPU and drawn into an OpenGL window.
+    bool                      m_softwareRendering = false;
+    SoftwareRasterizer        m_softwareRasterizer;
+    GLFWwindow*               m_softwareWindow    = nullptr;
+    std::vector<SoftwareDraw> m_softwareDraws;
+
+    std::atomic<bool> m_frameDirty{ true }; // Set by anything that changes what is on screen.
+    bool              m_animating  = false; // Space starts and pauses the turntable; paused, an untouched board draws no frames.
+
+    double m_animationTime       = 0.0;
+    double m_lastAnimationUpdate = 0.0;
+
+    double   m_statsStartTime = 0.0;
+    uint32_t m_statsFrames    = 0;
+    double   m_statsCpuTime   = 0.0;
+    double   m_statsGpuTime   = 0.0;
+    uint64_t m_drawnFrames    = 0; // Frames shown in the window since Init(), for MeasureUsage().
 };
 
 #endif // __WIZARD_CHESS_H__
\ No newline at end of file
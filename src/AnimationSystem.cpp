@@ -0,0 +1,167 @@
+#include "AnimationSystem.h"
+#include "TransformSystem.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define ANIMATION_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define ANIMATION_USE_SSE 0
+#endif
+
+void AnimationSystem::Play(uint32_t node, const glm::vec3& from, float fromYaw, const glm::vec3& to, float toYaw, float arcHeight, double startTime, float duration)
+{
+    if (m_nodes.empty())
+    {
+        m_epoch = startTime;
+    }
+
+    auto existing = std::find(m_nodes.begin(), m_nodes.end(), node);
+    if (existing != m_nodes.end())
+    {
+        RemoveTrack(static_cast<uint32_t>(existing - m_nodes.begin()));
+    }
+
+    m_nodes.push_back(node);
+    m_startTimes.push_back(static_cast<float>(startTime - m_epoch));
+    m_inverseDurations.push_back(1.0f / std::max(duration, 1e-3f));
+    m_fromX.push_back(from.x);
+    m_fromY.push_back(from.y);
+    m_fromZ.push_back(from.z);
+    m_toX.push_back(to.x);
+    m_toY.push_back(to.y);
+    m_toZ.push_back(to.z);
+    m_fromYaw.push_back(fromYaw);
+    m_toYaw.push_back(toYaw);
+    m_arcHeights.push_back(arcHeight);
+}
+
+void AnimationSystem::RemoveTrack(uint32_t track)
+{
+    auto swapRemove = [track](auto& values)
+    {
+        values[track] = values.back();
+        values.pop_back();
+    };
+
+    swapRemove(m_nodes);
+    swapRemove(m_startTimes);
+    swapRemove(m_inverseDurations);
+    swapRemove(m_fromX);
+    swapRemove(m_fromY);
+    swapRemove(m_fromZ);
+    swapRemove(m_toX);
+    swapRemove(m_toY);
+    swapRemove(m_toZ);
+    swapRemove(m_fromYaw);
+    swapRemove(m_toYaw);
+    swapRemove(m_arcHeights);
+}
+
+void AnimationSystem::Clear()
+{
+    m_nodes.clear();
+    m_startTimes.clear();
+    m_inverseDurations.clear();
+    m_fromX.clear();
+    m_fromY.clear();
+    m_fromZ.clear();
+    m_toX.clear();
+    m_toY.clear();
+    m_toZ.clear();
+    m_fromYaw.clear();
+    m_toYaw.clear();
+    m_arcHeights.clear();
+}
+
+void AnimationSystem::Stop(uint32_t node)
+{
+    auto track = std::find(m_nodes.begin(), m_nodes.end(), node);
+    if (track != m_nodes.end())
+    {
+        RemoveTrack(static_cast<uint32_t>(track - m_nodes.begin()));
+    }
+}
+
+void AnimationSystem::Update(double time, TransformSystem& transforms)
+{
+    uint32_t trackCount = ActiveCount();
+    if (trackCount == 0)
+    {
+        return;
+    }
+
+    m_outX.resize(trackCount);
+    m_outY.resize(trackCount);
+    m_outZ.resize(trackCount);
+    m_outYaw.resize(trackCount);
+    m_outProgress.resize(trackCount);
+
+    float    now   = static_cast<float>(time - m_epoch);
+    uint32_t track = 0;
+
+    // progress t in [0, 1], eased e = t^2 (3 - 2t) for the horizontal path and the turn,
+    // and a parabola 4 t (1 - t) for the arc, so the piece lifts off and lands vertically slower.
+#if ANIMATION_USE_SSE
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps(1.0f);
+    const __m128 two   = _mm_set1_ps(2.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 four  = _mm_set1_ps(4.0f);
+    const __m128 now4  = _mm_set1_ps(now);
+    for (; track + 4 <= trackCount; track += 4)
+    {
+        __m128 t = _mm_mul_ps(_mm_sub_ps(now4, _mm_loadu_ps(&m_startTimes[track])), _mm_loadu_ps(&m_inverseDurations[track]));
+        t        = _mm_min_ps(_mm_max_ps(t, zero), one);
+
+        __m128 eased = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t)));
+        __m128 arc   = _mm_mul_ps(_mm_mul_ps(four, t), _mm_sub_ps(one, t));
+
+        __m128 fromX = _mm_loadu_ps(&m_fromX[track]);
+        __m128 fromY = _mm_loadu_ps(&m_fromY[track]);
+        __m128 fromZ = _mm_loadu_ps(&m_fromZ[track]);
+        __m128 fromW = _mm_loadu_ps(&m_fromYaw[track]);
+        __m128 x     = _mm_add_ps(fromX, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_toX[track]), fromX), eased));
+        __m128 y     = _mm_add_ps(fromY, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_toY[track]), fromY), t));
+        __m128 z     = _mm_add_ps(fromZ, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_toZ[track]), fromZ), eased));
+        __m128 yaw   = _mm_add_ps(fromW, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_toYaw[track]), fromW), eased));
+        y            = _mm_add_ps(y, _mm_mul_ps(arc, _mm_loadu_ps(&m_arcHeights[track])));
+
+        _mm_storeu_ps(&m_outX[track], x);
+        _mm_storeu_ps(&m_outY[track], y);
+        _mm_storeu_ps(&m_outZ[track], z);
+        _mm_storeu_ps(&m_outYaw[track], yaw);
+        _mm_storeu_ps(&m_outProgress[track], t);
+    }
+#endif
+    for (; track < trackCount; track++)
+    {
+        float t     = std::clamp((now - m_startTimes[track]) * m_inverseDurations[track], 0.0f, 1.0f);
+        float eased = t * t * (3.0f - 2.0f * t);
+        float arc   = 4.0f * t * (1.0f - t);
+
+        m_outX[track]        = m_fromX[track] + (m_toX[track] - m_fromX[track]) * eased;
+        m_outY[track]        = m_fromY[track] + (m_toY[track] - m_fromY[track]) * t + arc * m_arcHeights[track];
+        m_outZ[track]        = m_fromZ[track] + (m_toZ[track] - m_fromZ[track]) * eased;
+        m_outYaw[track]      = m_fromYaw[track] + (m_toYaw[track] - m_fromYaw[track]) * eased;
+        m_outProgress[track] = t;
+    }
+
+    for (track = 0; track < trackCount; track++)
+    {
+        float halfYaw = 0.5f * m_outYaw[track];
+        transforms.SetPosition(m_nodes[track], glm::vec3(m_outX[track], m_outY[track], m_outZ[track]));
+        transforms.SetRotation(m_nodes[track], glm::quat(std::cos(halfYaw), 0.0f, std::sin(halfYaw), 0.0f));
+    }
+
+    // Drop the finished tracks; going backwards keeps the swapped-in tracks already visited.
+    for (uint32_t i = trackCount; i-- > 0;)
+    {
+        if (m_outProgress[i] >= 1.0f)
+        {
+            RemoveTrack(i);
+        }
+    }
+}
\ No newline at end of file
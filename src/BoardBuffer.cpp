@@ -0,0 +1,108 @@
+#include "BoardBuffer.h"
+#include "VulkanHelper.h"
+#include "VulkanDeviceManager.h"
+
+#include <cassert>
+#include <cstring>
+
+void BoardBuffer::Create(uint32_t frameCount, uint32_t boardCount)
+{
+    assert(frameCount <= 32);
+    assert(boardCount > 0);
+    assert(m_buffers.empty());
+
+    m_frameCount = frameCount;
+    m_boards.assign(boardCount, BoardData());
+    m_staleSquares.assign(static_cast<size_t>(boardCount) * BOARD_SQUARES, 0);
+    m_staleTiles.assign(boardCount, 0);
+    m_staleBoardFrames.assign(boardCount, 0);
+
+    m_buffers.resize(frameCount);
+    m_buffersMemory.resize(frameCount);
+    m_buffersMapped.resize(frameCount);
+
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        CreateBuffer(Size(), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffers[i], m_buffersMemory[i]);
+
+        void* pMapped = nullptr;
+        vkMapMemory(VK.Device(), m_buffersMemory[i], 0, Size(), 0, &pMapped);
+        m_buffersMapped[i] = static_cast<BoardData*>(pMapped);
+
+        memcpy(pMapped, m_boards.data(), static_cast<size_t>(Size()));
+    }
+}
+
+void BoardBuffer::Destroy()
+{
+    VkDevice device = VK.Device();
+
+    for (uint32_t i = 0; i < m_buffers.size(); i++)
+    {
+        vkDestroyBuffer(device, m_buffers[i], nullptr);
+        vkFreeMemory(device, m_buffersMemory[i], nullptr);
+    }
+
+    m_buffers.clear();
+    m_buffersMemory.clear();
+    m_buffersMapped.clear();
+}
+
+void BoardBuffer::SetSquare(uint32_t board, uint32_t square, uint32_t flags)
+{
+    assert(board < BoardCount());
+    assert(square < BOARD_SQUARES);
+
+    if (m_boards[board].squares[square] != flags)
+    {
+        m_boards[board].squares[square]                = flags;
+        m_staleSquares[board * BOARD_SQUARES + square] = AllFrames();
+        m_staleBoardFrames[board]                      = AllFrames();
+    }
+}
+
+void BoardBuffer::SetTile(uint32_t board, const glm::vec4& tile)
+{
+    assert(board < BoardCount());
+
+    if (m_boards[board].tile != tile)
+    {
+        m_boards[board].tile      = tile;
+        m_staleTiles[board]       = AllFrames();
+        m_staleBoardFrames[board] = AllFrames();
+    }
+}
+
+void BoardBuffer::Flush(uint32_t frameIndex)
+{
+    assert(frameIndex < m_frameCount);
+
+    // The 64 squares of a board with a stale entry are checked faster than a dirty list is kept;
+    // boards without one are skipped, so a wall of boards costs a check per board.
+    const uint32_t frameBit = 1u << frameIndex;
+    BoardData*     pMapped  = m_buffersMapped[frameIndex];
+    for (uint32_t board = 0; board < BoardCount(); board++)
+    {
+        if (!(m_staleBoardFrames[board] & frameBit))
+        {
+            continue;
+        }
+        m_staleBoardFrames[board] &= ~frameBit;
+
+        if (m_staleTiles[board] & frameBit)
+        {
+            pMapped[board].tile  = m_boards[board].tile;
+            m_staleTiles[board] &= ~frameBit;
+        }
+
+        uint32_t* pStaleSquares = &m_staleSquares[board * BOARD_SQUARES];
+        for (uint32_t square = 0; square < BOARD_SQUARES; square++)
+        {
+            if (pStaleSquares[square] & frameBit)
+            {
+                pMapped[board].squares[square] = m_boards[board].squares[square];
+                pStaleSquares[square]         &= ~frameBit;
+            }
+        }
+    }
+}
@@ -0,0 +1,172 @@
+#include "Bvh.h"
+
+#include <numeric>
+#include <utility>
+
+// Buckets the centroids are sorted into along each axis when searching for a split.
+static const uint32_t SAH_BINS = 8;
+
+// Nodes with this many primitives or fewer are not split.
+static const uint32_t MAX_LEAF_PRIMITIVES = 2;
+
+void Bvh::Build(const std::vector<Aabb>& primitiveBounds)
+{
+    m_nodes.clear();
+    m_primitiveIndices.resize(primitiveBounds.size());
+    std::iota(m_primitiveIndices.begin(), m_primitiveIndices.end(), 0u);
+
+    if (primitiveBounds.empty())
+    {
+        return;
+    }
+
+    std::vector<glm::vec3> centroids(primitiveBounds.size());
+    for (size_t i = 0; i < primitiveBounds.size(); i++)
+    {
+        centroids[i] = (primitiveBounds[i].min + primitiveBounds[i].max) * 0.5f;
+    }
+
+    // A binary tree with n leaves has 2n - 1 nodes.
+    m_nodes.reserve(primitiveBounds.size() * 2);
+    m_nodes.push_back({ glm::vec3(0.0f), 0, glm::vec3(0.0f), static_cast<uint32_t>(primitiveBounds.size()) });
+    UpdateNodeBounds(0, primitiveBounds);
+    Subdivide(0, primitiveBounds, centroids);
+}
+
+void Bvh::UpdateNodeBounds(uint32_t nodeIndex, const std::vector<Aabb>& primitiveBounds)
+{
+    BvhNode& node = m_nodes[nodeIndex];
+
+    Aabb bounds;
+    for (uint32_t i = 0; i < node.count; i++)
+    {
+        bounds.Grow(primitiveBounds[m_primitiveIndices[node.leftFirst + i]]);
+    }
+    node.boundsMin = bounds.min;
+    node.boundsMax = bounds.max;
+}
+
+float Bvh::FindBestSplit(const BvhNode& node, const std::vector<Aabb>& primitiveBounds, const std::vector<glm::vec3>& centroids, int& axis, float& splitPosition) const
+{
+    float bestCost = FLT_MAX;
+
+    Aabb centroidBounds;
+    for (uint32_t i = 0; i < node.count; i++)
+    {
+        centroidBounds.Grow(centroids[m_primitiveIndices[node.leftFirst + i]]);
+    }
+
+    for (int a = 0; a < 3; a++)
+    {
+        float boundsMin = centroidBounds.min[a];
+        float boundsMax = centroidBounds.max[a];
+        if (boundsMin == boundsMax)
+        {
+            continue;
+        }
+
+        Aabb     bins[SAH_BINS];
+        uint32_t binCounts[SAH_BINS] = {};
+        float    scale               = SAH_BINS / (boundsMax - boundsMin);
+        for (uint32_t i = 0; i < node.count; i++)
+        {
+            uint32_t primitive = m_primitiveIndices[node.leftFirst + i];
+            uint32_t bin       = std::min(SAH_BINS - 1, static_cast<uint32_t>((centroids[primitive][a] - boundsMin) * scale));
+            bins[bin].Grow(primitiveBounds[primitive]);
+            binCounts[bin]++;
+        }
+
+        // Sweep from both sides to get the cost of every plane between two bins.
+        float    leftArea[SAH_BINS - 1];
+        float    rightArea[SAH_BINS - 1];
+        uint32_t leftCount[SAH_BINS - 1];
+        uint32_t rightCount[SAH_BINS - 1];
+        Aabb     leftBox;
+        Aabb     rightBox;
+        uint32_t leftSum  = 0;
+        uint32_t rightSum = 0;
+        for (uint32_t i = 0; i < SAH_BINS - 1; i++)
+        {
+            leftSum += binCounts[i];
+            leftCount[i] = leftSum;
+            leftBox.Grow(bins[i]);
+            leftArea[i] = leftBox.HalfArea();
+
+            rightSum += binCounts[SAH_BINS - 1 - i];
+            rightCount[SAH_BINS - 2 - i] = rightSum;
+            rightBox.Grow(bins[SAH_BINS - 1 - i]);
+            rightArea[SAH_BINS - 2 - i] = rightBox.HalfArea();
+        }
+
+        for (uint32_t i = 0; i < SAH_BINS - 1; i++)
+        {
+            if ((leftCount[i] == 0) || (rightCount[i] == 0))
+            {
+                continue;
+            }
+
+            float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+            if (cost < bestCost)
+            {
+                bestCost      = cost;
+                axis          = a;
+                splitPosition = boundsMin + (i + 1) / scale;
+            }
+        }
+    }
+
+    return bestCost;
+}
+
+void Bvh::Subdivide(uint32_t nodeIndex, const std::vector<Aabb>& primitiveBounds, const std::vector<glm::vec3>& centroids)
+{
+    // Nodes to split, with their depth below the root.
+    std::vector<std::pair<uint32_t, uint32_t>> pending = { { nodeIndex, 0u } };
+    while (!pending.empty())
+    {
+        uint32_t current = pending.back().first;
+        uint32_t depth   = pending.back().second;
+        pending.pop_back();
+
+        BvhNode node = m_nodes[current];
+        if ((node.count <= MAX_LEAF_PRIMITIVES) || (depth >= MAX_DEPTH))
+        {
+            continue;
+        }
+
+        int   axis          = 0;
+        float splitPosition = 0.0f;
+        float splitCost     = FindBestSplit(node, primitiveBounds, centroids, axis, splitPosition);
+
+        // Keep the leaf when no split is cheaper than testing all of its primitives.
+        Aabb nodeBounds;
+        nodeBounds.min = node.boundsMin;
+        nodeBounds.max = node.boundsMax;
+        if (splitCost >= node.count * nodeBounds.HalfArea())
+        {
+            continue;
+        }
+
+        uint32_t* first = m_primitiveIndices.data() + node.leftFirst;
+        uint32_t* last  = first + node.count;
+        uint32_t* split = std::partition(first, last, [&](uint32_t primitive) { return centroids[primitive][axis] < splitPosition; });
+
+        uint32_t leftCount = static_cast<uint32_t>(split - first);
+        if ((leftCount == 0) || (leftCount == node.count))
+        {
+            continue;
+        }
+
+        uint32_t leftChild = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.push_back({ glm::vec3(0.0f), node.leftFirst, glm::vec3(0.0f), leftCount });
+        m_nodes.push_back({ glm::vec3(0.0f), node.leftFirst + leftCount, glm::vec3(0.0f), node.count - leftCount });
+        UpdateNodeBounds(leftChild, primitiveBounds);
+        UpdateNodeBounds(leftChild + 1, primitiveBounds);
+
+        m_nodes[current].leftFirst = leftChild;
+        m_nodes[current].count     = 0;
+
+        pending.push_back({ leftChild, depth + 1 });
+        pending.push_back({ leftChild + 1, depth + 1 });
+    }
+}
\ No newline at end of file
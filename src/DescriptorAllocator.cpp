@@ -0,0 +1,130 @@
+#include "DescriptorAllocator.h"
+#include "VulkanDeviceManager.h"
+
+#include <stdexcept>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+
+void DescriptorAllocator::Init(uint32_t initialSets, const std::vector<DescriptorPoolRatio>& poolRatios, VkDescriptorPoolCreateFlags flags)
+{
+    assert(m_readyPools.empty() && m_fullPools.empty());
+    assert(initialSets > 0);
+
+    m_poolRatios = poolRatios;
+    m_flags      = flags;
+
+    m_readyPools.push_back(CreatePool(initialSets));
+
+    // The next pool in the chain is 50% larger than this one.
+    m_setsPerPool = std::min(initialSets + initialSets / 2 + 1, MaxSetsPerPool);
+}
+
+void DescriptorAllocator::Destroy()
+{
+    VkDevice device = VK.Device();
+
+    for (VkDescriptorPool pool : m_readyPools)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    m_readyPools.clear();
+
+    for (VkDescriptorPool pool : m_fullPools)
+    {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    m_fullPools.clear();
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+    VkDescriptorPool pool = GetPool();
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool     = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = &layout;
+
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkResult        result        = vkAllocateDescriptorSets(VK.Device(), &allocInfo, &descriptorSet);
+
+    // The pool is exhausted: retire it and retry once with a fresh pool.
+    if ((result == VK_ERROR_OUT_OF_POOL_MEMORY) || (result == VK_ERROR_FRAGMENTED_POOL))
+    {
+        m_fullPools.push_back(pool);
+
+        pool                     = GetPool();
+        allocInfo.descriptorPool = pool;
+        result                   = vkAllocateDescriptorSets(VK.Device(), &allocInfo, &descriptorSet);
+    }
+
+    if (result != VK_SUCCESS)
+    {
+        m_fullPools.push_back(pool);
+        throw std::runtime_error("failed to allocate descriptor set!");
+    }
+
+    m_readyPools.push_back(pool);
+    return descriptorSet;
+}
+
+void DescriptorAllocator::Reset()
+{
+    VkDevice device = VK.Device();
+
+    for (VkDescriptorPool pool : m_readyPools)
+    {
+        vkResetDescriptorPool(device, pool, 0);
+    }
+
+    for (VkDescriptorPool pool : m_fullPools)
+    {
+        vkResetDescriptorPool(device, pool, 0);
+        m_readyPools.push_back(pool);
+    }
+    m_fullPools.clear();
+}
+
+VkDescriptorPool DescriptorAllocator::GetPool()
+{
+    if (!m_readyPools.empty())
+    {
+        VkDescriptorPool pool = m_readyPools.back();
+        m_readyPools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = CreatePool(m_setsPerPool);
+    m_setsPerPool = std::min(m_setsPerPool + m_setsPerPool / 2, MaxSetsPerPool);
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocator::CreatePool(uint32_t setCount)
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    poolSizes.reserve(m_poolRatios.size());
+    for (const DescriptorPoolRatio& ratio : m_poolRatios)
+    {
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type            = ratio.type;
+        poolSize.descriptorCount = std::max(1u, static_cast<uint32_t>(std::ceil(ratio.descriptorsPerSet * setCount)));
+        poolSizes.push_back(poolSize);
+    }
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags         = m_flags;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+    poolInfo.maxSets       = setCount;
+
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    if (vkCreateDescriptorPool(VK.Device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    return pool;
+}
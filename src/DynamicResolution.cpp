@@ -0,0 +1,133 @@
+#include "DynamicResolution.h"
+#include "VulkanDeviceManager.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const float MIN_RENDER_SCALE = 0.5f;
+static const float MAX_RENDER_SCALE = 1.0f;
+
+// Step taken towards full resolution per frame that is well under budget.
+static const float SCALE_UP_STEP = 0.01f;
+
+// Share of the frame time the GPU may take; the rest absorbs spikes.
+static const double GPU_BUDGET = 0.85;
+
+// Frames faster than this share of the budget raise the scale. Between it and the budget, the scale holds.
+static const double SCALE_UP_THRESHOLD = 0.75;
+
+// Exponential moving average weight of a new GPU time sample.
+static const double SMOOTHING = 0.2;
+
+void DynamicResolution::Init(uint32_t frameCount)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(VK.PhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(VK.PhysicalDevice(), &queueFamilyCount, nullptr);
+
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(VK.PhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    uint32_t validBits = queueFamilies[VK.FindQueueFamilies(VK.PhysicalDevice()).graphicsFamily.value()].timestampValidBits;
+    if ((validBits == 0) || (properties.limits.timestampPeriod <= 0.0f))
+    {
+        // No timing, so the scale stays at 1.
+        return;
+    }
+
+    m_timestampPeriod = properties.limits.timestampPeriod;
+    m_timestampMask   = (validBits >= 64) ? UINT64_MAX : ((uint64_t(1) << validBits) - 1);
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = frameCount * 2;
+
+    if (vkCreateQueryPool(VK.Device(), &queryPoolInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+
+    m_queriesWritten.assign(frameCount, false);
+}
+
+void DynamicResolution::Destroy()
+{
+    if (m_queryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(VK.Device(), m_queryPool, nullptr);
+        m_queryPool = VK_NULL_HANDLE;
+    }
+    m_queriesWritten.clear();
+}
+
+void DynamicResolution::BeginFrame(uint32_t frameIndex)
+{
+    if ((m_queryPool == VK_NULL_HANDLE) || !m_queriesWritten[frameIndex])
+    {
+        return;
+    }
+
+    uint64_t timestamps[2] = {};
+    VkResult result = vkGetQueryPoolResults(VK.Device(), m_queryPool, frameIndex * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    uint64_t ticks   = (timestamps[1] - timestamps[0]) & m_timestampMask;
+    double   gpuTime = ticks * m_timestampPeriod * 1e-9;
+    m_totalGpuTime += gpuTime;
+    m_gpuTime = (m_gpuTime > 0.0) ? (m_gpuTime + SMOOTHING * (gpuTime - m_gpuTime)) : gpuTime;
+
+    UpdateScale();
+}
+
+void DynamicResolution::UpdateScale()
+{
+    double budget = m_targetFrameTime * GPU_BUDGET;
+
+    if (m_gpuTime > budget)
+    {
+        // The cost is proportional to the pixel count, so the scale goes with the square root of the time.
+        // Only move halfway, the smoothed time lags behind the change.
+        float target = m_scale * static_cast<float>(std::sqrt(budget / m_gpuTime));
+        m_scale      = std::max(MIN_RENDER_SCALE, m_scale + 0.5f * (target - m_scale));
+    }
+    else if (m_gpuTime < budget * SCALE_UP_THRESHOLD)
+    {
+        m_scale = std::min(MAX_RENDER_SCALE, m_scale + SCALE_UP_STEP);
+    }
+}
+
+void DynamicResolution::RecordFrameStart(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (m_queryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, m_queryPool, frameIndex * 2, 2);
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, frameIndex * 2);
+}
+
+void DynamicResolution::RecordFrameEnd(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    if (m_queryPool == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, frameIndex * 2 + 1);
+    m_queriesWritten[frameIndex] = true;
+}
+
+VkExtent2D DynamicResolution::RenderExtent() const
+{
+    VkExtent2D extent;
+    extent.width  = std::max(1u, static_cast<uint32_t>(m_fullExtent.width * m_scale + 0.5f));
+    extent.height = std::max(1u, static_cast<uint32_t>(m_fullExtent.height * m_scale + 0.5f));
+    return extent;
+}
@@ -0,0 +1,210 @@
+#include "FrameCapture.h"
+#include "Utils.h"
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+const char* CaptureFormatName(ECaptureFormat format)
+{
+    static const char* names[] = { "y4m", "raw" };
+    return names[format];
+}
+
+bool ParseCaptureFormat(const std::string& name, ECaptureFormat* pFormat)
+{
+    for (unsigned int i = 0; i < NumCaptureFormats; i++)
+    {
+        if (name == CaptureFormatName(static_cast<ECaptureFormat>(i)))
+        {
+            *pFormat = static_cast<ECaptureFormat>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Frames that can wait for the writer, about 130 ms of video at 60 frames per second.
+static const uint32_t CAPTURE_SLOT_COUNT = 8;
+
+void FrameCapture::Start(const std::string& path, ECaptureFormat format, VkExtent2D extent, bool bgra, uint32_t frameRate)
+{
+    assert(!Active());
+
+    if (path == "-")
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        m_pFile = stdout;
+    }
+    else
+    {
+        m_pFile = std::fopen(path.c_str(), "wb");
+    }
+    if (m_pFile == nullptr)
+    {
+        throw std::runtime_error("failed to open capture output!");
+    }
+
+    m_format = format;
+    m_extent = extent;
+    m_bgra   = bgra;
+    m_writtenFrames = 0;
+    m_writeFailed   = false;
+    m_droppedFrames = 0;
+    m_endedFrames   = 0;
+    m_startTime     = MonotonicTime();
+    m_lastFrameTime = m_startTime;
+
+    size_t pixelCount = static_cast<size_t>(extent.width) * extent.height;
+    if (format == ECaptureFormat::Y4m)
+    {
+        // Full resolution chroma, so there is nothing to average; limited range BT.601 like most players expect.
+        std::fprintf(m_pFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C444 XCOLORRANGE=LIMITED\n", extent.width, extent.height, frameRate);
+        m_frameBuffer.resize(pixelCount * 3);
+    }
+    else if (bgra)
+    {
+        m_frameBuffer.resize(pixelCount * 4);
+    }
+
+    m_writer.Start(1);
+    m_ring.Create(&m_writer, CAPTURE_SLOT_COUNT, static_cast<VkDeviceSize>(pixelCount) * 4);
+}
+
+void FrameCapture::Stop()
+{
+    if (!Active())
+    {
+        return;
+    }
+
+    m_ring.Destroy();
+    m_writer.Stop();
+
+    if (m_pFile == stdout)
+    {
+        std::fflush(m_pFile);
+    }
+    else
+    {
+        std::fclose(m_pFile);
+    }
+    m_pFile = nullptr;
+
+    if (m_writeFailed)
+    {
+        std::cerr << "failed to write captured frames, " << m_writtenFrames << " written" << std::endl;
+    }
+    std::vector<uint8_t>().swap(m_frameBuffer);
+}
+
+bool FrameCapture::BeginFrame(VkExtent2D extent)
+{
+    assert(m_frameSlot == UINT32_MAX);
+
+    // Hand the finished copies to the writer first, which frees their slots sooner.
+    m_ring.Poll();
+
+    ///@note The video has a fixed size, so frames of a resized window are left out.
+    if ((extent.width != m_extent.width) || (extent.height != m_extent.height))
+    {
+        m_droppedFrames++;
+        return false;
+    }
+
+    m_frameSlot = m_ring.Acquire();
+    return true;
+}
+
+void FrameCapture::RecordCopy(VkCommandBuffer commandBuffer, VkImage image) const
+{
+    assert(m_frameSlot != UINT32_MAX);
+    m_ring.RecordCopy(commandBuffer, m_frameSlot, image, m_extent);
+}
+
+void FrameCapture::EndFrame(uint64_t timelineValue)
+{
+    assert(m_frameSlot != UINT32_MAX);
+
+    // Only captures this, so the consumer does not allocate either.
+    m_ring.Submit(m_frameSlot, timelineValue, [this](const uint8_t* pPixels) { WriteFrame(pPixels); });
+    m_frameSlot = UINT32_MAX;
+
+    m_endedFrames++;
+    m_lastFrameTime = MonotonicTime();
+}
+
+double FrameCapture::SustainedFrameRate() const
+{
+    double elapsed = m_lastFrameTime - m_startTime;
+    return (elapsed > 0.0) ? (m_endedFrames / elapsed) : 0.0;
+}
+
+void FrameCapture::WriteFrame(const uint8_t* pPixels)
+{
+    if (m_writeFailed)
+    {
+        return;
+    }
+
+    size_t pixelCount = static_cast<size_t>(m_extent.width) * m_extent.height;
+    size_t redOffset  = m_bgra ? 2 : 0;
+    size_t blueOffset = m_bgra ? 0 : 2;
+
+    bool written = true;
+    if (m_format == ECaptureFormat::Y4m)
+    {
+        uint8_t* pY = m_frameBuffer.data();
+        uint8_t* pU = pY + pixelCount;
+        uint8_t* pV = pU + pixelCount;
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            int r = pPixels[i * 4 + redOffset];
+            int g = pPixels[i * 4 + 1];
+            int b = pPixels[i * 4 + blueOffset];
+
+            // BT.601 limited range in 8.8 fixed point; every result stays within [16, 240].
+            pY[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+            pU[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pV[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+
+        written = (std::fwrite("FRAME\n", 1, 6, m_pFile) == 6) &&
+                  (std::fwrite(m_frameBuffer.data(), 1, m_frameBuffer.size(), m_pFile) == m_frameBuffer.size());
+    }
+    else
+    {
+        const uint8_t* pFrame = pPixels;
+        if (m_bgra)
+        {
+            uint8_t* pRgba = m_frameBuffer.data();
+            for (size_t i = 0; i < pixelCount; i++)
+            {
+                pRgba[i * 4 + 0] = pPixels[i * 4 + 2];
+                pRgba[i * 4 + 1] = pPixels[i * 4 + 1];
+                pRgba[i * 4 + 2] = pPixels[i * 4 + 0];
+                pRgba[i * 4 + 3] = pPixels[i * 4 + 3];
+            }
+            pFrame = pRgba;
+        }
+
+        written = (std::fwrite(pFrame, 1, pixelCount * 4, m_pFile) == pixelCount * 4);
+    }
+
+    if (written)
+    {
+        m_writtenFrames++;
+    }
+    else
+    {
+        m_writeFailed = true;
+    }
+}
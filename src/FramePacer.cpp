@@ -0,0 +1,129 @@
+#include "FramePacer.h"
+#include "VulkanDeviceManager.h"
+
+#include <algorithm>
+#include <thread>
+
+// Wake up this long before the predicted start, to absorb scheduling noise.
+static const double PACING_MARGIN = 0.001;
+
+// How long to wait for a presentation before giving up on pacing the frame.
+static const uint64_t PRESENT_WAIT_TIMEOUT_NS = 100 * 1000 * 1000;
+
+// Exponential moving average weight of a new sample.
+static const double SMOOTHING = 0.1;
+
+void FramePacer::Init(bool pacing)
+{
+    m_pacing = pacing;
+
+    if (VK.IsDeviceExtensionEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        m_pfnWaitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(VK.Device(), "vkWaitForPresentKHR"));
+    }
+
+    Reset();
+}
+
+void FramePacer::Reset()
+{
+    m_lastPresentId      = 0;
+    m_hasLastPresentTime = false;
+}
+
+double FramePacer::SecondsSince(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void FramePacer::SleepUntil(Clock::time_point deadline)
+{
+    // OS sleeps overshoot by up to a scheduler tick, so sleep in short steps and yield for the rest.
+    const auto coarseStep = std::chrono::milliseconds(1);
+    while (deadline - Clock::now() > 2 * coarseStep)
+    {
+        std::this_thread::sleep_for(coarseStep);
+    }
+    while (Clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::WaitForFrameStart(VkSwapchainKHR swapChain)
+{
+    if (!PresentWaitEnabled() || (m_lastPresentId == 0))
+    {
+        return;
+    }
+
+    VkResult result = m_pfnWaitForPresent(VK.Device(), swapChain, m_lastPresentId, PRESENT_WAIT_TIMEOUT_NS);
+    if (result != VK_SUCCESS)
+    {
+        // Timed out, or the swap chain is out of date; the acquire that follows deals with the latter.
+        return;
+    }
+
+    Clock::time_point now = Clock::now();
+
+    double latency = SecondsSince(m_presentInputTimes[m_lastPresentId % INPUT_TIME_HISTORY], now);
+    m_inputLatency = (m_inputLatency > 0.0) ? (m_inputLatency + SMOOTHING * (latency - m_inputLatency)) : latency;
+
+    if (m_hasLastPresentTime)
+    {
+        double interval = SecondsSince(m_lastPresentTime, now);
+
+        // A presentation that took much longer than usual means the frame missed its slot.
+        if (interval > 1.5 * m_presentInterval)
+        {
+            m_workEstimate = std::min(m_workEstimate + 0.25 * m_presentInterval, m_presentInterval);
+        }
+        else
+        {
+            m_presentInterval += SMOOTHING * (interval - m_presentInterval);
+            m_workEstimate     = std::max(m_workEstimate * 0.995, m_cpuWork);
+        }
+    }
+    m_lastPresentTime    = now;
+    m_hasLastPresentTime = true;
+
+    if (m_pacing)
+    {
+        double delay = m_presentInterval - m_workEstimate - PACING_MARGIN;
+        if (delay > 0.0)
+        {
+            SleepUntil(now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay)));
+        }
+    }
+}
+
+void FramePacer::MarkInputSampled()
+{
+    m_inputTime = Clock::now();
+}
+
+void FramePacer::MarkSubmitted()
+{
+    double cpuWork = SecondsSince(m_inputTime, Clock::now());
+    m_cpuWork += SMOOTHING * (cpuWork - m_cpuWork);
+}
+
+uint64_t FramePacer::NextPresentId()
+{
+    if (!PresentWaitEnabled())
+    {
+        return 0;
+    }
+
+    uint64_t presentId = m_nextPresentId++;
+    m_presentInputTimes[presentId % INPUT_TIME_HISTORY] = m_inputTime;
+    return presentId;
+}
+
+void FramePacer::MarkPresented(uint64_t presentId)
+{
+    if (presentId != 0)
+    {
+        m_lastPresentId = presentId;
+    }
+}
@@ -0,0 +1,383 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+const char* ImageFormatName(EImageFormat format)
+{
+    static const char* names[] = { "png", "ppm", "raw" };
+    return names[format];
+}
+
+bool ParseImageFormat(const std::string& name, EImageFormat* pFormat)
+{
+    for (unsigned int i = 0; i < NumImageFormats; i++)
+    {
+        if (name == ImageFormatName(static_cast<EImageFormat>(i)))
+        {
+            *pFormat = static_cast<EImageFormat>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// LZ77 parameters of the deflate stream. Longer chains compress a little better and take longer.
+static const uint32_t DEFLATE_WINDOW_SIZE  = 32768;
+static const uint32_t DEFLATE_MIN_MATCH    = 3;
+static const uint32_t DEFLATE_MAX_MATCH    = 258;
+static const uint32_t DEFLATE_HASH_BITS    = 15;
+static const uint32_t DEFLATE_MAX_CHAIN    = 32;
+
+// Appends bits least significant bit first, the order of deflate streams.
+struct BitWriter
+{
+    std::vector<uint8_t>& out;
+    uint32_t              bitBuffer = 0;
+    uint32_t              bitCount  = 0;
+
+    explicit BitWriter(std::vector<uint8_t>& output) : out(output) {}
+
+    void Write(uint32_t bits, uint32_t count)
+    {
+        bitBuffer |= bits << bitCount;
+        bitCount  += count;
+        while (bitCount >= 8)
+        {
+            out.push_back(static_cast<uint8_t>(bitBuffer));
+            bitBuffer >>= 8;
+            bitCount   -= 8;
+        }
+    }
+
+    // Huffman codes are defined most significant bit first.
+    void WriteCode(uint32_t code, uint32_t length)
+    {
+        uint32_t reversed = 0;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            reversed = (reversed << 1) | ((code >> i) & 1);
+        }
+        Write(reversed, length);
+    }
+
+    void Flush()
+    {
+        if (bitCount > 0)
+        {
+            out.push_back(static_cast<uint8_t>(bitBuffer));
+        }
+        bitBuffer = 0;
+        bitCount  = 0;
+    }
+};
+
+// Literal or length symbol with the fixed Huffman code of deflate.
+static void WriteFixedSymbol(BitWriter& writer, uint32_t symbol)
+{
+    if (symbol < 144)
+    {
+        writer.WriteCode(0x30 + symbol, 8);
+    }
+    else if (symbol < 256)
+    {
+        writer.WriteCode(0x190 + (symbol - 144), 9);
+    }
+    else if (symbol < 280)
+    {
+        writer.WriteCode(symbol - 256, 7);
+    }
+    else
+    {
+        writer.WriteCode(0xC0 + (symbol - 280), 8);
+    }
+}
+
+static void WriteMatch(BitWriter& writer, uint32_t length, uint32_t distance)
+{
+    static const uint16_t lengthBase[29]  = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t  lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30]    = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t  distExtra[30]   = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    uint32_t lengthCode = 28;
+    while (lengthBase[lengthCode] > length)
+    {
+        lengthCode--;
+    }
+    WriteFixedSymbol(writer, 257 + lengthCode);
+    writer.Write(length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+
+    uint32_t distCode = 29;
+    while (distBase[distCode] > distance)
+    {
+        distCode--;
+    }
+    writer.WriteCode(distCode, 5);
+    writer.Write(distance - distBase[distCode], distExtra[distCode]);
+}
+
+///@brief zlib stream of one deflate block with the fixed Huffman codes and greedy LZ77 matching.
+///       Rendered boards have long runs of equal filtered bytes, which this handles well enough
+///       without the cost of building dynamic Huffman tables.
+static void Deflate(const std::vector<uint8_t>& data, std::vector<uint8_t>& out)
+{
+    out.push_back(0x78); // 32K window, deflate.
+    out.push_back(0x01); // Fastest compression level, checksum of the header.
+
+    BitWriter writer(out);
+    writer.Write(1, 1); // Final block.
+    writer.Write(1, 2); // Fixed Huffman codes.
+
+    const uint32_t        size = static_cast<uint32_t>(data.size());
+    std::vector<int32_t>  head(1u << DEFLATE_HASH_BITS, -1);
+    std::vector<int32_t>  prev(DEFLATE_WINDOW_SIZE, -1);
+    auto hashAt = [&data](uint32_t position)
+    {
+        uint32_t value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+        return (value * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+    };
+    auto insert = [&](uint32_t position)
+    {
+        if (position + DEFLATE_MIN_MATCH <= size)
+        {
+            uint32_t hash = hashAt(position);
+            prev[position % DEFLATE_WINDOW_SIZE] = head[hash];
+            head[hash]                           = static_cast<int32_t>(position);
+        }
+    };
+
+    uint32_t position = 0;
+    while (position < size)
+    {
+        uint32_t bestLength   = 0;
+        uint32_t bestDistance = 0;
+        if (position + DEFLATE_MIN_MATCH <= size)
+        {
+            uint32_t maxLength = std::min(DEFLATE_MAX_MATCH, size - position);
+            int32_t  candidate = head[hashAt(position)];
+            for (uint32_t chain = 0; (chain < DEFLATE_MAX_CHAIN) && (candidate >= 0); chain++)
+            {
+                uint32_t distance = position - static_cast<uint32_t>(candidate);
+                if (distance > DEFLATE_WINDOW_SIZE)
+                {
+                    break;
+                }
+
+                uint32_t length = 0;
+                while ((length < maxLength) && (data[candidate + length] == data[position + length]))
+                {
+                    length++;
+                }
+                if (length > bestLength)
+                {
+                    bestLength   = length;
+                    bestDistance = distance;
+                    if (length == maxLength)
+                    {
+                        break;
+                    }
+                }
+
+                int32_t next = prev[candidate % DEFLATE_WINDOW_SIZE];
+                candidate    = (next < candidate) ? next : -1; // The slot was reused by a newer position.
+            }
+        }
+
+        if (bestLength >= DEFLATE_MIN_MATCH)
+        {
+            WriteMatch(writer, bestLength, bestDistance);
+            for (uint32_t i = 0; i < bestLength; i++)
+            {
+                insert(position + i);
+            }
+            position += bestLength;
+        }
+        else
+        {
+            WriteFixedSymbol(writer, data[position]);
+            insert(position);
+            position++;
+        }
+    }
+
+    WriteFixedSymbol(writer, 256); // End of block.
+    writer.Flush();
+
+    uint32_t a = 1, b = 0;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    uint32_t adler = (b << 16) | a;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        out.push_back(static_cast<uint8_t>(adler >> shift));
+    }
+}
+
+static uint32_t Crc32(const uint8_t* pData, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool     tableReady = []()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+            }
+            table[i] = value;
+        }
+        return true;
+    }();
+    (void)tableReady;
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void WriteBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static void WritePngChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data)
+{
+    WriteBigEndian(out, static_cast<uint32_t>(data.size()));
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    WriteBigEndian(out, Crc32(&out[typeStart], out.size() - typeStart));
+}
+
+static uint8_t Paeth(int a, int b, int c)
+{
+    int p  = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    return static_cast<uint8_t>(((pa <= pb) && (pa <= pc)) ? a : ((pb <= pc) ? b : c));
+}
+
+static bool WritePng(std::ofstream& file, const uint8_t* pPixels, uint32_t width, uint32_t height)
+{
+    // Each row gets the filter with the smallest sum of absolute differences, the usual heuristic.
+    const size_t         stride = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> filtered;
+    std::vector<uint8_t> candidate(stride);
+    std::vector<uint8_t> best(stride);
+    filtered.reserve((stride + 1) * height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* row   = pPixels + y * stride;
+        const uint8_t* above = (y > 0) ? (row - stride) : nullptr;
+
+        uint32_t bestCost   = UINT32_MAX;
+        uint8_t  bestFilter = 0;
+        for (uint8_t filter = 0; filter < 5; filter++)
+        {
+            uint32_t cost = 0;
+            for (size_t i = 0; i < stride; i++)
+            {
+                int left      = (i >= 4) ? row[i - 4] : 0;
+                int up        = above ? above[i] : 0;
+                int upperLeft = (above && (i >= 4)) ? above[i - 4] : 0;
+                int predicted = 0;
+                switch (filter)
+                {
+                case 1: predicted = left;                         break;
+                case 2: predicted = up;                           break;
+                case 3: predicted = (left + up) / 2;              break;
+                case 4: predicted = Paeth(left, up, upperLeft);   break;
+                }
+                candidate[i] = static_cast<uint8_t>(row[i] - predicted);
+                cost        += static_cast<uint32_t>(std::abs(static_cast<int8_t>(candidate[i])));
+            }
+            if (cost < bestCost)
+            {
+                bestCost   = cost;
+                bestFilter = filter;
+                best.swap(candidate);
+            }
+        }
+
+        filtered.push_back(bestFilter);
+        filtered.insert(filtered.end(), best.begin(), best.end());
+    }
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<uint8_t> header;
+    WriteBigEndian(header, width);
+    WriteBigEndian(header, height);
+    header.push_back(8); // Bits per channel.
+    header.push_back(6); // RGBA.
+    header.push_back(0); // Deflate.
+    header.push_back(0); // Adaptive filtering.
+    header.push_back(0); // Not interlaced.
+    WritePngChunk(png, "IHDR", header);
+
+    std::vector<uint8_t> compressed;
+    Deflate(filtered, compressed);
+    WritePngChunk(png, "IDAT", compressed);
+    WritePngChunk(png, "IEND", {});
+
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return file.good();
+}
+
+static bool WritePpm(std::ofstream& file, const uint8_t* pPixels, uint32_t width, uint32_t height)
+{
+    file << "P6\n" << width << " " << height << "\n255\n";
+
+    std::vector<char> row(width * 3);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint8_t* pixel = pPixels + static_cast<size_t>(y) * width * 4;
+        for (uint32_t x = 0; x < width; x++, pixel += 4)
+        {
+            row[x * 3 + 0] = static_cast<char>(pixel[0]);
+            row[x * 3 + 1] = static_cast<char>(pixel[1]);
+            row[x * 3 + 2] = static_cast<char>(pixel[2]);
+        }
+        file.write(row.data(), row.size());
+    }
+
+    return file.good();
+}
+
+bool WriteImage(const std::string& fileName, EImageFormat format, const uint8_t* pPixels, uint32_t width, uint32_t height)
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    switch (format)
+    {
+    case EImageFormat::Png:
+        return WritePng(file, pPixels, width, height);
+    case EImageFormat::Ppm:
+        return WritePpm(file, pPixels, width, height);
+    case EImageFormat::Raw:
+        file.write(reinterpret_cast<const char*>(pPixels), static_cast<std::streamsize>(width) * height * 4);
+        return file.good();
+    default:
+        return false;
+    }
+}
@@ -7,15 +7,36 @@
 #include "VulkanDeviceManager.h"
 
 #include <unordered_map>
+#include <cfloat>
 #include <cmath>
+#include <algorithm>
+
+// Cells along the largest side of the bounding box for the first simplified level; halved for each further level.
+static const uint32_t LOD_GRID_RESOLUTION = 64;
+
+// A level must drop at least this share of the triangles of the previous one, or the chain ends.
+static const float LOD_MIN_REDUCTION = 0.25f;
 
 Model::~Model()
 {
-    vkDestroyBuffer(VK.Device(), m_indexBuffer, nullptr);
-    vkFreeMemory(VK.Device(), m_indexBufferMemory, nullptr);
+    // Without Vulkan the buffers are never created.
+    if ((m_vertexBuffer == VK_NULL_HANDLE) && (m_indexBuffer == VK_NULL_HANDLE))
+    {
+        return;
+    }
+
+    // Models can be released while frames that draw them are still in flight.
+    VK.DeferDestruction([indexBuffer = m_indexBuffer, indexBufferMemory = m_indexBufferMemory,
+                         vertexBuffer = m_vertexBuffer, vertexBufferMemory = m_vertexBufferMemory]()
+    {
+        VkDevice device = VK.Device();
+
+        vkDestroyBuffer(device, indexBuffer, nullptr);
+        vkFreeMemory(device, indexBufferMemory, nullptr);
 
-    vkDestroyBuffer(VK.Device(), m_vertexBuffer, nullptr);
-    vkFreeMemory(VK.Device(), m_vertexBufferMemory, nullptr);
+        vkDestroyBuffer(device, vertexBuffer, nullptr);
+        vkFreeMemory(device, vertexBufferMemory, nullptr);
+    });
 }
 
 void Model::Load(std::string fileNmae)
@@ -30,13 +51,6 @@ void Model::Load(std::string fileNmae)
         throw std::runtime_error(warn + err);
     }
 
-    m_boundaries[0] = attrib.vertices[0];
-    m_boundaries[1] = attrib.vertices[0];
-    m_boundaries[2] = attrib.vertices[1];
-    m_boundaries[3] = attrib.vertices[1];
-    m_boundaries[4] = attrib.vertices[2];
-    m_boundaries[5] = attrib.vertices[2];
-
     for (const auto& shape : shapes)
     {
         for (const auto& index : shape.mesh.indices)
@@ -50,13 +64,6 @@ void Model::Load(std::string fileNmae)
                 attrib.vertices[3 * index.vertex_index + 2]
             };
 
-            m_boundaries[0] = std::min(m_boundaries[0], vertex.pos[0]);
-            m_boundaries[1] = std::max(m_boundaries[1], vertex.pos[0]);
-            m_boundaries[2] = std::min(m_boundaries[2], vertex.pos[1]);
-            m_boundaries[3] = std::max(m_boundaries[3], vertex.pos[1]);
-            m_boundaries[4] = std::min(m_boundaries[4], vertex.pos[2]);
-            m_boundaries[5] = std::max(m_boundaries[5], vertex.pos[2]);
-
             if (index.texcoord_index != -1)
             {
                 vertex.texCoord =
@@ -66,13 +73,28 @@ void Model::Load(std::string fileNmae)
                 };
             }
 
-            vertex.color = { vertex.pos[0], vertex.pos[1], vertex.pos[2] };
-
             m_indices.push_back(m_vertices.size());
             m_vertices.push_back(vertex);
         }
     }
 
+    Finish();
+}
+
+void Model::Finish()
+{
+    m_boundaries[0] = m_boundaries[2] = m_boundaries[4] = FLT_MAX;
+    m_boundaries[1] = m_boundaries[3] = m_boundaries[5] = -FLT_MAX;
+    for (const auto& vertex : m_vertices)
+    {
+        m_boundaries[0] = std::min(m_boundaries[0], vertex.pos[0]);
+        m_boundaries[1] = std::max(m_boundaries[1], vertex.pos[0]);
+        m_boundaries[2] = std::min(m_boundaries[2], vertex.pos[1]);
+        m_boundaries[3] = std::max(m_boundaries[3], vertex.pos[1]);
+        m_boundaries[4] = std::min(m_boundaries[4], vertex.pos[2]);
+        m_boundaries[5] = std::max(m_boundaries[5], vertex.pos[2]);
+    }
+
     float maxLength = std::max(std::max((m_boundaries[1] - m_boundaries[0]) / 2,
                                         (m_boundaries[3] - m_boundaries[2]) / 2),
                                (m_boundaries[5] - m_boundaries[4]) / 2);
@@ -83,11 +105,170 @@ void Model::Load(std::string fileNmae)
                                                   (m_boundaries[2] + m_boundaries[3]) / 2,
                                                   (m_boundaries[4] + m_boundaries[5]) / 2));
 
+    // The vertex color is the position within the bounding box; flat meshes have no extent along one axis.
     for (auto& vertex : m_vertices)
     {
-        vertex.color[0] = (vertex.color[0] - m_boundaries[0]) / (m_boundaries[1] - m_boundaries[0]);
-        vertex.color[1] = (vertex.color[1] - m_boundaries[2]) / (m_boundaries[3] - m_boundaries[2]);
-        vertex.color[2] = (vertex.color[2] - m_boundaries[4]) / (m_boundaries[5] - m_boundaries[4]);
+        vertex.color[0] = (vertex.pos[0] - m_boundaries[0]) / std::max(m_boundaries[1] - m_boundaries[0], FLT_EPSILON);
+        vertex.color[1] = (vertex.pos[1] - m_boundaries[2]) / std::max(m_boundaries[3] - m_boundaries[2], FLT_EPSILON);
+        vertex.color[2] = (vertex.pos[2] - m_boundaries[4]) / std::max(m_boundaries[5] - m_boundaries[4], FLT_EPSILON);
+    }
+
+    GenerateLods();
+    BuildBvh();
+}
+
+void Model::BuildBvh()
+{
+    std::vector<Aabb> triangleBounds(m_lods[0].indexCount / 3);
+    for (uint32_t triangle = 0; triangle < triangleBounds.size(); triangle++)
+    {
+        for (uint32_t corner = 0; corner < 3; corner++)
+        {
+            triangleBounds[triangle].Grow(m_vertices[m_indices[m_lods[0].firstIndex + triangle * 3 + corner]].pos);
+        }
+    }
+
+    m_bvh.Build(triangleBounds);
+}
+
+bool Model::Intersect(const BvhRay& ray, float& tMax, glm::vec2& texCoord) const
+{
+    // Moller-Trumbore for the triangles of the leaves the ray reaches.
+    return m_bvh.Traverse(ray, tMax, [&](uint32_t triangle, float& tClosest)
+    {
+        const uint32_t* indices = &m_indices[m_lods[0].firstIndex + triangle * 3];
+        const Vertex&   v0      = m_vertices[indices[0]];
+        const Vertex&   v1      = m_vertices[indices[1]];
+        const Vertex&   v2      = m_vertices[indices[2]];
+
+        glm::vec3 edge1       = v1.pos - v0.pos;
+        glm::vec3 edge2       = v2.pos - v0.pos;
+        glm::vec3 p           = glm::cross(ray.direction, edge2);
+        float     determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < 1e-12f)
+        {
+            return false;
+        }
+
+        float     inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s                  = ray.origin - v0.pos;
+        float     u                  = glm::dot(s, p) * inverseDeterminant;
+        if ((u < 0.0f) || (u > 1.0f))
+        {
+            return false;
+        }
+
+        glm::vec3 q = glm::cross(s, edge1);
+        float     v = glm::dot(ray.direction, q) * inverseDeterminant;
+        if ((v < 0.0f) || (u + v > 1.0f))
+        {
+            return false;
+        }
+
+        float t = glm::dot(edge2, q) * inverseDeterminant;
+        if ((t <= 0.0f) || (t >= tClosest))
+        {
+            return false;
+        }
+
+        tClosest = t;
+        texCoord = v0.texCoord * (1.0f - u - v) + v1.texCoord * u + v2.texCoord * v;
+        return true;
+    });
+}
+
+void Model::GenerateLods()
+{
+    const uint32_t fullIndexCount = static_cast<uint32_t>(m_indices.size());
+    m_lods.clear();
+    m_lods.push_back({ 0, fullIndexCount, 0.0f });
+
+    ///@note Every level is simplified from the full mesh by vertex clustering: the bounding box is split
+    ///      into a grid, the vertices in each cell are merged into their average and triangles that
+    ///      collapse are dropped. It keeps the silhouette within a cell size, which is all a distant
+    ///      piece needs.
+    glm::vec3 minCorner(m_boundaries[0], m_boundaries[2], m_boundaries[4]);
+    float     size = 2.0f * MaxScale();
+    if (size <= 0.0f)
+    {
+        return;
+    }
+
+    for (uint32_t resolution = LOD_GRID_RESOLUTION; (m_lods.size() < MAX_MODEL_LODS) && (resolution >= 2); resolution /= 2)
+    {
+        float cellSize = size / resolution;
+
+        // Cluster of every vertex of the full mesh.
+        std::unordered_map<uint64_t, uint32_t> clusterOfCell;
+        std::vector<uint32_t>                  clusterOfVertex(fullIndexCount);
+        std::vector<Vertex>                    clusters;
+        std::vector<uint32_t>                  clusterSizes;
+        for (uint32_t i = 0; i < fullIndexCount; i++)
+        {
+            const Vertex& vertex = m_vertices[m_indices[i]];
+            glm::uvec3    cell   = glm::uvec3(glm::clamp((vertex.pos - minCorner) / cellSize, glm::vec3(0.0f), glm::vec3(static_cast<float>(resolution - 1))));
+            uint64_t      key    = (uint64_t(cell.x) << 42) | (uint64_t(cell.y) << 21) | uint64_t(cell.z);
+
+            auto found = clusterOfCell.find(key);
+            if (found == clusterOfCell.end())
+            {
+                found = clusterOfCell.emplace(key, static_cast<uint32_t>(clusters.size())).first;
+                clusters.push_back({ glm::vec3(0.0f), glm::vec3(0.0f), glm::vec2(0.0f) });
+                clusterSizes.push_back(0);
+            }
+
+            uint32_t cluster = found->second;
+            clusters[cluster].pos      += vertex.pos;
+            clusters[cluster].color    += vertex.color;
+            clusters[cluster].texCoord += vertex.texCoord;
+            clusterSizes[cluster]++;
+            clusterOfVertex[i] = cluster;
+        }
+
+        for (uint32_t cluster = 0; cluster < clusters.size(); cluster++)
+        {
+            float weight = 1.0f / clusterSizes[cluster];
+            clusters[cluster].pos      *= weight;
+            clusters[cluster].color    *= weight;
+            clusters[cluster].texCoord *= weight;
+        }
+
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i + 2 < fullIndexCount; i += 3)
+        {
+            uint32_t a = clusterOfVertex[i];
+            uint32_t b = clusterOfVertex[i + 1];
+            uint32_t c = clusterOfVertex[i + 2];
+            if ((a == b) || (b == c) || (a == c))
+            {
+                continue;
+            }
+            indices.push_back(a);
+            indices.push_back(b);
+            indices.push_back(c);
+        }
+        // The selection expects the error to grow with the level.
+        float error = m_lods.back().error;
+        for (uint32_t i = 0; i < fullIndexCount; i++)
+        {
+            error = std::max(error, glm::length(m_vertices[m_indices[i]].pos - clusters[clusterOfVertex[i]].pos));
+        }
+
+        // Coarser grids only pay off when they remove a good share of what is left.
+        if (indices.empty() || (indices.size() > m_lods.back().indexCount * (1.0f - LOD_MIN_REDUCTION)))
+        {
+            continue;
+        }
+
+        uint32_t firstVertex = static_cast<uint32_t>(m_vertices.size());
+        uint32_t firstIndex  = static_cast<uint32_t>(m_indices.size());
+        m_vertices.insert(m_vertices.end(), clusters.begin(), clusters.end());
+        for (uint32_t index : indices)
+        {
+            m_indices.push_back(firstVertex + index);
+        }
+
+        m_lods.push_back({ firstIndex, static_cast<uint32_t>(indices.size()), error });
     }
 }
 
@@ -120,11 +301,14 @@ void Model::CreateVertexBuffer()
                  m_vertexBufferMemory);
 
     // Copy data from the staging buffer to the GPU-local vertex buffer
-    CopyBuffer(stagingBuffer, m_vertexBuffer, bufferSize);
+    uint64_t copyValue = CopyBuffer(stagingBuffer, m_vertexBuffer, bufferSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
 
-    // Clean up the staging buffer and its memory after data has been transferred
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    // Clean up the staging buffer and its memory once the copy has completed
+    VK.DeferDestruction([device, stagingBuffer, stagingBufferMemory]()
+    {
+        vkDestroyBuffer(device, stagingBuffer, nullptr);
+        vkFreeMemory(device, stagingBufferMemory, nullptr);
+    }, copyValue);
 }
 
 void Model::CreateIndexBuffer()
@@ -156,9 +340,12 @@ void Model::CreateIndexBuffer()
                  m_indexBufferMemory);
 
     // Copy data from the staging buffer to the GPU-local index buffer
-    CopyBuffer(stagingBuffer, m_indexBuffer, bufferSize);
+    uint64_t copyValue = CopyBuffer(stagingBuffer, m_indexBuffer, bufferSize, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
 
-    // Clean up the staging buffer and its memory after data has been transferred
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    // Clean up the staging buffer and its memory once the copy has completed
+    VK.DeferDestruction([device, stagingBuffer, stagingBufferMemory]()
+    {
+        vkDestroyBuffer(device, stagingBuffer, nullptr);
+        vkFreeMemory(device, stagingBufferMemory, nullptr);
+    }, copyValue);
 }
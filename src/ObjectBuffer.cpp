@@ -0,0 +1,135 @@
+#include "ObjectBuffer.h"
+#include "VulkanHelper.h"
+#include "VulkanDeviceManager.h"
+
+#include <cassert>
+#include <cstring>
+
+void ObjectBuffer::Create(uint32_t frameCount, uint32_t maxObjects)
+{
+    assert(frameCount <= 32);
+    assert(m_buffers.empty());
+
+    m_frameCount = frameCount;
+    m_maxObjects = maxObjects;
+
+    m_objects.assign(maxObjects, ObjectData{});
+    m_staleFrames.assign(maxObjects, 0);
+    m_dirtyObjects.clear();
+    m_dirtyObjects.reserve(maxObjects);
+
+    VkDeviceSize bufferSize = sizeof(ObjectData) * maxObjects;
+
+    m_buffers.resize(frameCount);
+    m_buffersMemory.resize(frameCount);
+    m_buffersMapped.resize(frameCount);
+
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        CreateBuffer(bufferSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_buffers[i], m_buffersMemory[i]);
+
+        void* pMapped = nullptr;
+        vkMapMemory(VK.Device(), m_buffersMemory[i], 0, bufferSize, 0, &pMapped);
+        m_buffersMapped[i] = static_cast<ObjectData*>(pMapped);
+
+        // Start from the same defaults as the CPU copy.
+        memcpy(pMapped, m_objects.data(), static_cast<size_t>(bufferSize));
+    }
+}
+
+void ObjectBuffer::Destroy()
+{
+    VkDevice device = VK.Device();
+
+    for (uint32_t i = 0; i < m_buffers.size(); i++)
+    {
+        vkDestroyBuffer(device, m_buffers[i], nullptr);
+        vkFreeMemory(device, m_buffersMemory[i], nullptr);
+    }
+
+    m_buffers.clear();
+    m_buffersMemory.clear();
+    m_buffersMapped.clear();
+}
+
+void ObjectBuffer::SetWorldMatrix(uint32_t objectIndex, const glm::mat4& worldMatrix)
+{
+    assert(objectIndex < m_maxObjects);
+
+    if (m_objects[objectIndex].world != worldMatrix)
+    {
+        m_objects[objectIndex].world = worldMatrix;
+        MarkDirty(objectIndex);
+    }
+}
+
+void ObjectBuffer::SetTextureIndex(uint32_t objectIndex, uint32_t textureIndex)
+{
+    assert(objectIndex < m_maxObjects);
+
+    if (m_objects[objectIndex].textureIndex != textureIndex)
+    {
+        m_objects[objectIndex].textureIndex = textureIndex;
+        MarkDirty(objectIndex);
+    }
+}
+
+void ObjectBuffer::SetBoard(uint32_t objectIndex, uint32_t board)
+{
+    assert(objectIndex < m_maxObjects);
+
+    if (m_objects[objectIndex].board != board)
+    {
+        m_objects[objectIndex].board = board;
+        MarkDirty(objectIndex);
+    }
+}
+
+void ObjectBuffer::MarkDirty(uint32_t objectIndex)
+{
+    // Without buffers there is nothing to bring up to date.
+    if (m_frameCount == 0)
+    {
+        return;
+    }
+
+    if (m_staleFrames[objectIndex] == 0)
+    {
+        m_dirtyObjects.push_back(objectIndex);
+    }
+
+    m_staleFrames[objectIndex] = (m_frameCount == 32) ? ~0u : ((1u << m_frameCount) - 1);
+}
+
+void ObjectBuffer::Flush(uint32_t frameIndex)
+{
+    assert(frameIndex < m_frameCount);
+
+    const uint32_t frameBit = 1u << frameIndex;
+    ObjectData*    pMapped  = m_buffersMapped[frameIndex];
+
+    m_lastFlushWrites = 0;
+
+    for (size_t i = 0; i < m_dirtyObjects.size();)
+    {
+        uint32_t objectIndex = m_dirtyObjects[i];
+
+        if (m_staleFrames[objectIndex] & frameBit)
+        {
+            pMapped[objectIndex] = m_objects[objectIndex];
+            m_staleFrames[objectIndex] &= ~frameBit;
+            m_lastFlushWrites++;
+        }
+
+        // Once every frame has the latest value, the entry is clean; remove it by swapping with the last one.
+        if (m_staleFrames[objectIndex] == 0)
+        {
+            m_dirtyObjects[i] = m_dirtyObjects.back();
+            m_dirtyObjects.pop_back();
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,512 @@
+#include "OcclusionCuller.h"
+#include "VulkanHelper.h"
+#include "VulkanDeviceManager.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
+static const uint32_t HIZ_GROUP_SIZE  = 16;
+static const uint32_t CULL_GROUP_SIZE = 64;
+
+static uint32_t PreviousPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while ((result << 1) <= value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+static VkImageView CreatePyramidView(VkImage image, uint32_t baseMipLevel, uint32_t levelCount)
+{
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image                           = image;
+    viewInfo.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format                          = VK_FORMAT_R32_SFLOAT;
+    viewInfo.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel   = baseMipLevel;
+    viewInfo.subresourceRange.levelCount     = levelCount;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount     = 1;
+
+    VkImageView imageView;
+    if (vkCreateImageView(VK.Device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid image view!");
+    }
+
+    return imageView;
+}
+
+static void RecordComputeBarrier(
+    VkCommandBuffer      commandBuffer,
+    VkPipelineStageFlags srcStageMask,
+    VkAccessFlags        srcAccessMask,
+    VkPipelineStageFlags dstStageMask,
+    VkAccessFlags        dstAccessMask)
+{
+    VkMemoryBarrier barrier{};
+    barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+
+    vkCmdPipelineBarrier(commandBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+bool OcclusionCuller::IsSupported()
+{
+    return VK.EnabledFeatures().drawIndirectFirstInstance == VK_TRUE;
+}
+
+void OcclusionCuller::Init(
+    uint32_t                 frameCount,
+    uint32_t                 maxObjects,
+    const std::vector<char>& hizShaderCode,
+    const std::vector<char>& cullShaderCode)
+{
+    assert(m_frames.empty());
+
+    m_maxObjects = maxObjects;
+
+    CreateDescriptorSetLayouts();
+    CreatePipelines(hizShaderCode, cullShaderCode);
+
+    VkDevice device = VK.Device();
+
+    // The bounds only change when objects are added, so one buffer is shared by all frames.
+    VkDeviceSize boundsSize = sizeof(ObjectBounds) * maxObjects;
+    CreateBuffer(boundsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_boundsBuffer, m_boundsBufferMemory);
+    vkMapMemory(device, m_boundsBufferMemory, 0, boundsSize, 0, reinterpret_cast<void**>(&m_pBoundsMapped));
+    memset(m_pBoundsMapped, 0, static_cast<size_t>(boundsSize));
+
+    VkDeviceSize drawCommandsSize = sizeof(VkDrawIndexedIndirectCommand) * maxObjects;
+
+    m_frames.resize(frameCount);
+    for (FrameResources& frame : m_frames)
+    {
+        for (uint32_t phase = 0; phase < NumCullPhases; phase++)
+        {
+            CreateBuffer(drawCommandsSize, VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.drawCommandBuffers[phase], frame.drawCommandBuffersMemory[phase]);
+            vkMapMemory(device, frame.drawCommandBuffersMemory[phase], 0, drawCommandsSize, 0, reinterpret_cast<void**>(&frame.drawCommandsMapped[phase]));
+        }
+
+        CreateBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.statsBuffer, frame.statsBufferMemory);
+        vkMapMemory(device, frame.statsBufferMemory, 0, sizeof(uint32_t), 0, reinterpret_cast<void**>(&frame.pStatsMapped));
+        *frame.pStatsMapped = 0;
+    }
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType        = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter    = VK_FILTER_NEAREST;
+    samplerInfo.minFilter    = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.minLod       = 0.0f;
+    samplerInfo.maxLod       = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &m_pyramidSampler) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid sampler!");
+    }
+}
+
+void OcclusionCuller::Destroy()
+{
+    VkDevice device = VK.Device();
+
+    DestroyDepthPyramid();
+
+    for (FrameResources& frame : m_frames)
+    {
+        for (uint32_t phase = 0; phase < NumCullPhases; phase++)
+        {
+            vkDestroyBuffer(device, frame.drawCommandBuffers[phase], nullptr);
+            vkFreeMemory(device, frame.drawCommandBuffersMemory[phase], nullptr);
+        }
+
+        vkDestroyBuffer(device, frame.statsBuffer, nullptr);
+        vkFreeMemory(device, frame.statsBufferMemory, nullptr);
+    }
+    m_frames.clear();
+
+    vkDestroyBuffer(device, m_boundsBuffer, nullptr);
+    vkFreeMemory(device, m_boundsBufferMemory, nullptr);
+    m_boundsBuffer  = VK_NULL_HANDLE;
+    m_pBoundsMapped = nullptr;
+
+    vkDestroySampler(device, m_pyramidSampler, nullptr);
+
+    vkDestroyPipeline(device, m_hizPipeline, nullptr);
+    vkDestroyPipelineLayout(device, m_hizPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, m_hizDescriptorSetLayout, nullptr);
+
+    vkDestroyPipeline(device, m_cullPipeline, nullptr);
+    vkDestroyPipelineLayout(device, m_cullPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, m_cullDescriptorSetLayout, nullptr);
+}
+
+void OcclusionCuller::CreateDescriptorSetLayouts()
+{
+    VkDevice device = VK.Device();
+
+    std::array<VkDescriptorSetLayoutBinding, 2> hizBindings{};
+    hizBindings[0].binding         = 0;
+    hizBindings[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    hizBindings[0].descriptorCount = 1;
+    hizBindings[0].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    hizBindings[1].binding         = 1;
+    hizBindings[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    hizBindings[1].descriptorCount = 1;
+    hizBindings[1].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutCreateInfo hizLayoutInfo{};
+    hizLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    hizLayoutInfo.bindingCount = static_cast<uint32_t>(hizBindings.size());
+    hizLayoutInfo.pBindings    = hizBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &hizLayoutInfo, nullptr, &m_hizDescriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid descriptor set layout!");
+    }
+
+    // Objects, bounds, draw commands, early draw commands, depth pyramid, stats; see cull.comp.
+    std::array<VkDescriptorSetLayoutBinding, 6> cullBindings{};
+    for (uint32_t i = 0; i < cullBindings.size(); i++)
+    {
+        cullBindings[i].binding         = i;
+        cullBindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        cullBindings[i].descriptorCount = 1;
+        cullBindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    cullBindings[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    VkDescriptorSetLayoutCreateInfo cullLayoutInfo{};
+    cullLayoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    cullLayoutInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+    cullLayoutInfo.pBindings    = cullBindings.data();
+
+    if (vkCreateDescriptorSetLayout(device, &cullLayoutInfo, nullptr, &m_cullDescriptorSetLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling descriptor set layout!");
+    }
+}
+
+void OcclusionCuller::CreatePipelines(const std::vector<char>& hizShaderCode, const std::vector<char>& cullShaderCode)
+{
+    VkDevice device = VK.Device();
+
+    VkPipelineLayoutCreateInfo hizLayoutInfo{};
+    hizLayoutInfo.sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    hizLayoutInfo.setLayoutCount = 1;
+    hizLayoutInfo.pSetLayouts    = &m_hizDescriptorSetLayout;
+
+    if (vkCreatePipelineLayout(device, &hizLayoutInfo, nullptr, &m_hizPipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.offset     = 0;
+    pushConstantRange.size       = sizeof(CullPushConstants);
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkPipelineLayoutCreateInfo cullLayoutInfo{};
+    cullLayoutInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    cullLayoutInfo.setLayoutCount         = 1;
+    cullLayoutInfo.pSetLayouts            = &m_cullDescriptorSetLayout;
+    cullLayoutInfo.pushConstantRangeCount = 1;
+    cullLayoutInfo.pPushConstantRanges    = &pushConstantRange;
+
+    if (vkCreatePipelineLayout(device, &cullLayoutInfo, nullptr, &m_cullPipelineLayout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling pipeline layout!");
+    }
+
+    VkShaderModule hizShaderModule  = CreateShaderModule(hizShaderCode);
+    VkShaderModule cullShaderModule = CreateShaderModule(cullShaderCode);
+
+    std::array<VkComputePipelineCreateInfo, 2> pipelineInfos{};
+    for (VkComputePipelineCreateInfo& pipelineInfo : pipelineInfos)
+    {
+        pipelineInfo.sType        = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.pName  = "main";
+    }
+    pipelineInfos[0].stage.module = hizShaderModule;
+    pipelineInfos[0].layout       = m_hizPipelineLayout;
+    pipelineInfos[1].stage.module = cullShaderModule;
+    pipelineInfos[1].layout       = m_cullPipelineLayout;
+
+    std::array<VkPipeline, 2> pipelines{};
+    if (vkCreateComputePipelines(device, VK_NULL_HANDLE, static_cast<uint32_t>(pipelineInfos.size()), pipelineInfos.data(), nullptr, pipelines.data()) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create culling compute pipelines!");
+    }
+    m_hizPipeline  = pipelines[0];
+    m_cullPipeline = pipelines[1];
+
+    vkDestroyShaderModule(device, cullShaderModule, nullptr);
+    vkDestroyShaderModule(device, hizShaderModule, nullptr);
+}
+
+void OcclusionCuller::CreateDepthPyramid(VkExtent2D depthExtent)
+{
+    assert(m_pyramidImage == VK_NULL_HANDLE);
+
+    VkDevice device = VK.Device();
+
+    // Rounding down to a power of two keeps every level an exact half of the one below.
+    VkExtent2D extent = { PreviousPowerOfTwo(std::max(depthExtent.width, 1u)), PreviousPowerOfTwo(std::max(depthExtent.height, 1u)) };
+
+    uint32_t levelCount = 1;
+    while ((std::max(extent.width, extent.height) >> levelCount) > 0)
+    {
+        levelCount++;
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width  = extent.width;
+    imageInfo.extent.height = extent.height;
+    imageInfo.extent.depth  = 1;
+    imageInfo.mipLevels     = levelCount;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.format        = VK_FORMAT_R32_SFLOAT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage         = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device, &imageInfo, nullptr, &m_pyramidImage) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create depth pyramid image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, m_pyramidImage, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize  = memRequirements.size;
+    allocInfo.memoryTypeIndex = FindMemoryType(VK.PhysicalDevice(), memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &m_pyramidImageMemory) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to allocate depth pyramid image memory!");
+    }
+
+    vkBindImageMemory(device, m_pyramidImage, m_pyramidImageMemory, 0);
+
+    m_pyramidView = CreatePyramidView(m_pyramidImage, 0, levelCount);
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        m_pyramidLevelViews.push_back(CreatePyramidView(m_pyramidImage, level, 1));
+        m_pyramidLevelExtents.push_back({ std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) });
+    }
+
+    // The pyramid stays in the general layout. It starts at the far plane, so nothing is culled
+    // until it has been built from a real depth buffer.
+    VkCommandBuffer commandBuffer = VK.BeginSingleTimeCommands();
+
+    RecordImageBarrier(commandBuffer, m_pyramidImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL,
+                       VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkClearColorValue farPlane = { { 1.0f, 0.0f, 0.0f, 0.0f } };
+    VkImageSubresourceRange range{ VK_IMAGE_ASPECT_COLOR_BIT, 0, levelCount, 0, 1 };
+    vkCmdClearColorImage(commandBuffer, m_pyramidImage, VK_IMAGE_LAYOUT_GENERAL, &farPlane, 1, &range);
+
+    RecordImageBarrier(commandBuffer, m_pyramidImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    // The next frame is submitted to the same queue after the clear, so it does not have to be waited for.
+    VK.SubmitSingleTimeCommands(commandBuffer);
+}
+
+void OcclusionCuller::DestroyDepthPyramid()
+{
+    // Frames in flight may still read the pyramid, so it goes away once they complete.
+    VK.DeferDestruction([levelViews = m_pyramidLevelViews, view = m_pyramidView, image = m_pyramidImage, memory = m_pyramidImageMemory]()
+    {
+        VkDevice device = VK.Device();
+
+        for (VkImageView imageView : levelViews)
+        {
+            vkDestroyImageView(device, imageView, nullptr);
+        }
+
+        vkDestroyImageView(device, view, nullptr);
+        vkDestroyImage(device, image, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+    });
+
+    m_pyramidLevelViews.clear();
+    m_pyramidLevelExtents.clear();
+
+    m_pyramidView        = VK_NULL_HANDLE;
+    m_pyramidImage       = VK_NULL_HANDLE;
+    m_pyramidImageMemory = VK_NULL_HANDLE;
+}
+
+void OcclusionCuller::SetObjectBounds(uint32_t objectIndex, const glm::vec3& center, const glm::vec3& extents)
+{
+    assert(objectIndex < m_maxObjects);
+
+    m_pBoundsMapped[objectIndex].center  = glm::vec4(center, 1.0f);
+    m_pBoundsMapped[objectIndex].extents = glm::vec4(extents, 0.0f);
+}
+
+void OcclusionCuller::BeginFrame(uint32_t frameIndex)
+{
+    ///@note Only valid once the frame has completed on the timeline.
+    FrameResources& frame = m_frames[frameIndex];
+
+    m_culledObjects     = *frame.pStatsMapped;
+    *frame.pStatsMapped = 0;
+}
+
+void OcclusionCuller::WriteDrawCommands(uint32_t frameIndex, const std::vector<VkDrawIndexedIndirectCommand>& drawCommands)
+{
+    assert(drawCommands.size() <= m_maxObjects);
+
+    FrameResources& frame = m_frames[frameIndex];
+
+    frame.drawCount = static_cast<uint32_t>(drawCommands.size());
+    for (uint32_t phase = 0; phase < NumCullPhases; phase++)
+    {
+        memcpy(frame.drawCommandsMapped[phase], drawCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * drawCommands.size());
+    }
+}
+
+void OcclusionCuller::RecordCull(
+    VkCommandBuffer      commandBuffer,
+    uint32_t             frameIndex,
+    ECullPhase           phase,
+    DescriptorAllocator& descriptorAllocator,
+    VkBuffer             objectBuffer,
+    const glm::mat4&     viewProj,
+    const glm::vec2&     viewportScale)
+{
+    FrameResources& frame = m_frames[frameIndex];
+
+    VkDescriptorSet descriptorSet = descriptorAllocator.Allocate(m_cullDescriptorSetLayout);
+
+    std::array<VkDescriptorBufferInfo, 5> bufferInfos{};
+    bufferInfos[0] = { objectBuffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[1] = { m_boundsBuffer, 0, VK_WHOLE_SIZE };
+    bufferInfos[2] = { frame.drawCommandBuffers[phase], 0, VK_WHOLE_SIZE };
+    bufferInfos[3] = { frame.drawCommandBuffers[ECullPhase::Early], 0, VK_WHOLE_SIZE };
+    bufferInfos[4] = { frame.statsBuffer, 0, VK_WHOLE_SIZE };
+
+    VkDescriptorImageInfo pyramidInfo{};
+    pyramidInfo.sampler     = m_pyramidSampler;
+    pyramidInfo.imageView   = m_pyramidView;
+    pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+    // Bindings 0-3 and 5 are storage buffers, binding 4 is the depth pyramid.
+    std::array<VkWriteDescriptorSet, 6> descriptorWrites{};
+    for (uint32_t i = 0; i < descriptorWrites.size(); i++)
+    {
+        descriptorWrites[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet          = descriptorSet;
+        descriptorWrites[i].dstBinding      = i;
+        descriptorWrites[i].descriptorCount = 1;
+        descriptorWrites[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[i].pBufferInfo     = &bufferInfos[(i < 4) ? i : 4];
+    }
+    descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[4].pBufferInfo    = nullptr;
+    descriptorWrites[4].pImageInfo     = &pyramidInfo;
+
+    vkUpdateDescriptorSets(VK.Device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+    CullPushConstants constants{};
+    constants.viewProj      = viewProj;
+    constants.drawCount     = frame.drawCount;
+    constants.phase         = phase;
+    constants.viewportScale = viewportScale;
+
+    // The early phase reads the pyramid built by the previous frame, possibly in an earlier submission.
+    RecordComputeBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, m_cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants), &constants);
+    vkCmdDispatch(commandBuffer, (frame.drawCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // The draw commands are consumed by the indirect draws and, for the early phase, by the late culling pass.
+    // The counter is read back on the host once the frame has completed on the timeline.
+    RecordComputeBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT);
+}
+
+void OcclusionCuller::RecordBuildDepthPyramid(
+    VkCommandBuffer      commandBuffer,
+    DescriptorAllocator& descriptorAllocator,
+    VkImageView          depthImageView)
+{
+    // The early culling pass must be done reading the pyramid before it is overwritten.
+    RecordComputeBarrier(commandBuffer,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0);
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_hizPipeline);
+
+    for (uint32_t level = 0; level < m_pyramidLevelViews.size(); level++)
+    {
+        VkDescriptorSet descriptorSet = descriptorAllocator.Allocate(m_hizDescriptorSetLayout);
+
+        // The first level reduces the depth buffer, every other level reduces the level below.
+        VkDescriptorImageInfo srcInfo{};
+        srcInfo.sampler     = m_pyramidSampler;
+        srcInfo.imageView   = (level == 0) ? depthImageView : m_pyramidLevelViews[level - 1];
+        srcInfo.imageLayout = (level == 0) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+
+        VkDescriptorImageInfo dstInfo{};
+        dstInfo.imageView   = m_pyramidLevelViews[level];
+        dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+        descriptorWrites[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet          = descriptorSet;
+        descriptorWrites[0].dstBinding      = 0;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[0].pImageInfo      = &srcInfo;
+
+        descriptorWrites[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet          = descriptorSet;
+        descriptorWrites[1].dstBinding      = 1;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptorWrites[1].pImageInfo      = &dstInfo;
+
+        vkUpdateDescriptorSets(VK.Device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_hizPipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+
+        const VkExtent2D& extent = m_pyramidLevelExtents[level];
+        vkCmdDispatch(commandBuffer, (extent.width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (extent.height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+        // The next level reads this one.
+        RecordImageBarrier(commandBuffer, m_pyramidImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+    }
+}
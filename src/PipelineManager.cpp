@@ -0,0 +1,267 @@
+#include "PipelineManager.h"
+#include "VulkanHelper.h"
+#include "VulkanDeviceManager.h"
+#include "Types.h"
+
+#include <iostream>
+#include <cassert>
+
+void PipelineManager::Init(
+    ThreadPool*              pThreadPool,
+    VkPipelineLayout         pipelineLayout,
+    const std::vector<char>& vertShaderCode,
+    const std::vector<char>& fragShaderCode,
+    VkFormat                 colorFormat,
+    VkFormat                 idFormat,
+    VkFormat                 depthFormat)
+{
+    assert(pThreadPool != nullptr);
+
+    m_pThreadPool    = pThreadPool;
+    m_pipelineLayout = pipelineLayout;
+    m_colorFormat    = colorFormat;
+    m_idFormat       = idFormat;
+    m_depthFormat    = depthFormat;
+
+    for (uint32_t i = 0; i < NumPipelineVariants; i++)
+    {
+        m_pipelines[i].store(VK_NULL_HANDLE);
+        m_requested[i].store(false);
+    }
+
+    ///@note The shader modules are only read by vkCreateGraphicsPipelines, so all workers can share them.
+    m_vertShaderModule = CreateShaderModule(vertShaderCode);
+    m_fragShaderModule = CreateShaderModule(fragShaderCode);
+
+    // The pipeline cache is internally synchronized, so concurrent compilations can share it.
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (vkCreatePipelineCache(VK.Device(), &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+
+    // The fallback must exist before the first frame, so it is the only synchronous compilation.
+    m_requested[EPipelineVariant::Textured].store(true);
+    m_pipelines[EPipelineVariant::Textured].store(CreatePipeline(EPipelineVariant::Textured));
+}
+
+void PipelineManager::Destroy()
+{
+    VkDevice device = VK.Device();
+
+    // Let in-flight compilations finish before tearing down what they use.
+    if (m_pThreadPool != nullptr)
+    {
+        m_pThreadPool->WaitIdle();
+    }
+
+    for (auto& pipeline : m_pipelines)
+    {
+        vkDestroyPipeline(device, pipeline.exchange(VK_NULL_HANDLE), nullptr);
+    }
+
+    vkDestroyPipelineCache(device, m_pipelineCache, nullptr);
+    m_pipelineCache = VK_NULL_HANDLE;
+
+    vkDestroyShaderModule(device, m_fragShaderModule, nullptr);
+    vkDestroyShaderModule(device, m_vertShaderModule, nullptr);
+    m_fragShaderModule = VK_NULL_HANDLE;
+    m_vertShaderModule = VK_NULL_HANDLE;
+}
+
+void PipelineManager::RequestVariant(EPipelineVariant variant)
+{
+    assert(variant < NumPipelineVariants);
+
+    // Only the first request of a variant schedules a compilation.
+    if (m_requested[variant].exchange(true))
+    {
+        return;
+    }
+
+    m_pThreadPool->Enqueue([this, variant]()
+    {
+        try
+        {
+            m_pipelines[variant].store(CreatePipeline(variant));
+        }
+        catch (const std::exception& e)
+        {
+            ///@note The variant keeps drawing with the fallback pipeline.
+            std::cerr << "Pipeline variant " << variant << ": " << e.what() << std::endl;
+        }
+    });
+}
+
+void PipelineManager::RequestAllVariants()
+{
+    for (uint32_t i = 0; i < NumPipelineVariants; i++)
+    {
+        RequestVariant(static_cast<EPipelineVariant>(i));
+    }
+}
+
+bool PipelineManager::IsReady(EPipelineVariant variant) const
+{
+    return m_pipelines[variant].load(std::memory_order_acquire) != VK_NULL_HANDLE;
+}
+
+VkPipeline PipelineManager::Get(EPipelineVariant variant) const
+{
+    VkPipeline pipeline = m_pipelines[variant].load(std::memory_order_acquire);
+    return (pipeline != VK_NULL_HANDLE) ? pipeline : m_pipelines[EPipelineVariant::Textured].load(std::memory_order_relaxed);
+}
+
+uint32_t PipelineManager::ReadyCount() const
+{
+    uint32_t readyCount = 0;
+    for (uint32_t i = 0; i < NumPipelineVariants; i++)
+    {
+        readyCount += IsReady(static_cast<EPipelineVariant>(i)) ? 1 : 0;
+    }
+    return readyCount;
+}
+
+VkPipeline PipelineManager::CreatePipeline(EPipelineVariant variant)
+{
+    // The variant selects the shading path of the fragment shader through a specialization constant.
+    uint32_t shadingMode = static_cast<uint32_t>(variant);
+
+    VkSpecializationMapEntry specializationEntry{};
+    specializationEntry.constantID = 0;
+    specializationEntry.offset     = 0;
+    specializationEntry.size       = sizeof(uint32_t);
+
+    VkSpecializationInfo specializationInfo{};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries   = &specializationEntry;
+    specializationInfo.dataSize      = sizeof(uint32_t);
+    specializationInfo.pData         = &shadingMode;
+
+    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
+    vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
+    vertShaderStageInfo.module = m_vertShaderModule;
+    vertShaderStageInfo.pName  = "main";
+
+    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
+    fragShaderStageInfo.sType               = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragShaderStageInfo.stage               = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragShaderStageInfo.module              = m_fragShaderModule;
+    fragShaderStageInfo.pName               = "main";
+    fragShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    auto bindingDescription    = Vertex::GetBindingDescription();
+    auto attributeDescriptions = Vertex::GetAttributeDescriptions();
+
+    vertexInputInfo.vertexBindingDescriptionCount   = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions      = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    ///@note Wireframe needs the fillModeNonSolid feature; without it the variant is drawn filled.
+    bool wireframe = (variant == EPipelineVariant::Wireframe) && VK.EnabledFeatures().fillModeNonSolid;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType                    = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable         = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable  = VK_FALSE;
+    rasterizer.polygonMode              = wireframe ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth                = 1.0f;
+    rasterizer.cullMode                 = wireframe ? VK_CULL_MODE_NONE : VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace                = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.depthBiasEnable          = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable   = VK_FALSE;
+    multisampling.rasterizationSamples  = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType                  = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable        = VK_TRUE;
+    depthStencil.depthWriteEnable       = VK_TRUE;
+    depthStencil.depthCompareOp         = VK_COMPARE_OP_LESS;
+    depthStencil.depthBoundsTestEnable  = VK_FALSE;
+    depthStencil.stencilTestEnable      = VK_FALSE;
+
+    // The object ids are integers, so that attachment is never blended.
+    VkPipelineColorBlendAttachmentState colorBlendAttachments[2]{};
+    colorBlendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    colorBlendAttachments[0].blendEnable    = VK_FALSE;
+    colorBlendAttachments[1].colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+    colorBlendAttachments[1].blendEnable    = VK_FALSE;
+
+    VkFormat colorFormats[]       = { m_colorFormat, m_idFormat };
+    uint32_t colorAttachmentCount = (m_idFormat != VK_FORMAT_UNDEFINED) ? 2 : 1;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType                 = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable         = VK_FALSE;
+    colorBlending.logicOp               = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount       = colorAttachmentCount;
+    colorBlending.pAttachments          = colorBlendAttachments;
+    colorBlending.blendConstants[0]     = 0.0f;
+    colorBlending.blendConstants[1]     = 0.0f;
+    colorBlending.blendConstants[2]     = 0.0f;
+    colorBlending.blendConstants[3]     = 0.0f;
+
+    std::vector<VkDynamicState> dynamicStates =
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType              = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount  = static_cast<uint32_t>(dynamicStates.size());
+    dynamicState.pDynamicStates     = dynamicStates.data();
+
+    VkPipelineRenderingCreateInfo renderingInfo{};
+    renderingInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingInfo.colorAttachmentCount      = colorAttachmentCount;
+    renderingInfo.pColorAttachmentFormats   = colorFormats;
+    renderingInfo.depthAttachmentFormat     = m_depthFormat;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType                  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.pNext                  = &renderingInfo;
+    pipelineInfo.stageCount             = 2;
+    pipelineInfo.pStages                = shaderStages;
+    pipelineInfo.pVertexInputState      = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState    = &inputAssembly;
+    pipelineInfo.pViewportState         = &viewportState;
+    pipelineInfo.pRasterizationState    = &rasterizer;
+    pipelineInfo.pMultisampleState      = &multisampling;
+    pipelineInfo.pDepthStencilState     = &depthStencil;
+    pipelineInfo.pColorBlendState       = &colorBlending;
+    pipelineInfo.pDynamicState          = &dynamicState;
+    pipelineInfo.layout                 = m_pipelineLayout;
+    pipelineInfo.renderPass             = VK_NULL_HANDLE;
+    pipelineInfo.subpass                = 0;
+    pipelineInfo.basePipelineHandle     = VK_NULL_HANDLE;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(VK.Device(), m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+
+    return pipeline;
+}
@@ -0,0 +1,228 @@
+#include "ReadbackRing.h"
+#include "ThreadPool.h"
+#include "VulkanHelper.h"
+
+#include <cassert>
+#include <exception>
+
+// Picks the first memory type with the given properties, or returns false.
+static bool FindHostMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t* pTypeIndex, VkMemoryPropertyFlags* pTypeProperties)
+{
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(VK.PhysicalDevice(), &memProperties);
+
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
+    {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            *pTypeIndex      = i;
+            *pTypeProperties = memProperties.memoryTypes[i].propertyFlags;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ReadbackRing::Create(ThreadPool* pThreadPool, uint32_t slotCount, VkDeviceSize slotSize)
+{
+    assert(m_slots.empty());
+    assert(slotCount > 0);
+
+    VkDevice device = VK.Device();
+
+    m_pThreadPool = pThreadPool;
+    m_slotSize    = slotSize;
+    m_slots       = std::vector<Slot>(slotCount);
+    m_nextSlot    = 0;
+
+    for (Slot& slot : m_slots)
+    {
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size        = slotSize;
+        bufferInfo.usage       = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateBuffer(device, &bufferInfo, nullptr, &slot.buffer) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create readback buffer!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetBufferMemoryRequirements(device, slot.buffer, &memRequirements);
+
+        ///@note The CPU reads every byte of a slot, which is many times faster from cached memory.
+        ///      Cached memory need not be coherent, so coherence is only the fallback.
+        uint32_t              typeIndex      = 0;
+        VkMemoryPropertyFlags typeProperties = 0;
+        if (!FindHostMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT, &typeIndex, &typeProperties) &&
+            !FindHostMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &typeIndex, &typeProperties))
+        {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+        m_coherent = (typeProperties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = memRequirements.size;
+        allocInfo.memoryTypeIndex = typeIndex;
+
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &slot.memory) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate readback buffer memory!");
+        }
+
+        vkBindBufferMemory(device, slot.buffer, slot.memory, 0);
+
+        void* pMapped = nullptr;
+        vkMapMemory(device, slot.memory, 0, VK_WHOLE_SIZE, 0, &pMapped);
+        slot.pMapped = static_cast<uint8_t*>(pMapped);
+    }
+}
+
+void ReadbackRing::Destroy()
+{
+    // The workers may still read the mapped memory.
+    Flush();
+
+    VkDevice device = VK.Device();
+    for (Slot& slot : m_slots)
+    {
+        vkDestroyBuffer(device, slot.buffer, nullptr);
+        vkFreeMemory(device, slot.memory, nullptr);
+    }
+    m_slots.clear();
+}
+
+uint32_t ReadbackRing::Acquire()
+{
+    uint32_t slot = m_nextSlot;
+    m_nextSlot    = (m_nextSlot + 1) % SlotCount();
+
+    if (m_slots[slot].copyPending)
+    {
+        VK.WaitForTimelineValue(m_slots[slot].timelineValue);
+        Dispatch(slot);
+    }
+    WaitForConsumer(slot);
+
+    return slot;
+}
+
+void ReadbackRing::RecordCopy(VkCommandBuffer commandBuffer, uint32_t slot, VkImage image, VkExtent2D extent) const
+{
+    assert(static_cast<VkDeviceSize>(extent.width) * extent.height * 4 <= m_slotSize);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent      = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_slots[slot].buffer, 1, &region);
+
+    // Make the copy visible to host reads once the submission has signaled the timeline.
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = m_slots[slot].buffer;
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void ReadbackRing::Submit(uint32_t slot, uint64_t timelineValue, Consumer consumer)
+{
+    assert(!m_slots[slot].copyPending);
+
+    m_slots[slot].timelineValue = timelineValue;
+    m_slots[slot].consumer      = std::move(consumer);
+    m_slots[slot].copyPending   = true;
+}
+
+void ReadbackRing::Poll()
+{
+    // Oldest slot first, so a single worker consumes the slots in submission order.
+    uint64_t completed = VK.CompletedTimelineValue();
+    for (uint32_t i = 0; i < SlotCount(); i++)
+    {
+        uint32_t slot = (m_nextSlot + i) % SlotCount();
+        if (m_slots[slot].copyPending && (m_slots[slot].timelineValue <= completed))
+        {
+            Dispatch(slot);
+        }
+    }
+}
+
+void ReadbackRing::Flush()
+{
+    for (uint32_t i = 0; i < SlotCount(); i++)
+    {
+        uint32_t slot = (m_nextSlot + i) % SlotCount();
+        if (m_slots[slot].copyPending)
+        {
+            VK.WaitForTimelineValue(m_slots[slot].timelineValue);
+            Dispatch(slot);
+        }
+    }
+    for (uint32_t slot = 0; slot < SlotCount(); slot++)
+    {
+        WaitForConsumer(slot);
+    }
+}
+
+void ReadbackRing::Dispatch(uint32_t slot)
+{
+    Slot& readback = m_slots[slot];
+    readback.copyPending = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        readback.consuming = true;
+    }
+
+    ///@note The job only captures the slot, so queuing it does not allocate. The consumer stays in the
+    ///      slot, which is not touched again before the consumer has returned.
+    m_pThreadPool->Enqueue([this, slot]()
+    {
+        Slot& consumed = m_slots[slot];
+        if (!m_coherent)
+        {
+            VkMappedMemoryRange range{};
+            range.sType  = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+            range.memory = consumed.memory;
+            range.offset = 0;
+            range.size   = VK_WHOLE_SIZE;
+            vkInvalidateMappedMemoryRanges(VK.Device(), 1, &range);
+        }
+
+        // The slot is released even when the consumer throws, so Flush() does not wait for it forever;
+        // the exception then goes on to the thread pool.
+        std::exception_ptr error;
+        try
+        {
+            consumed.consumer(consumed.pMapped);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            consumed.consuming = false;
+            m_consumed.notify_all();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    });
+}
+
+void ReadbackRing::WaitForConsumer(uint32_t slot)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_consumed.wait(lock, [this, slot]() { return !m_slots[slot].consuming; });
+}
@@ -0,0 +1,117 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <cassert>
+
+static inline uint64_t MaskBits(uint64_t value, uint32_t bits)
+{
+    return value & ((1ull << bits) - 1);
+}
+
+uint64_t RenderQueue::MakeSortKey(ERenderPass pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float viewDepth, float farPlane)
+{
+    assert(pipeline < (1u << PipelineBits));
+    assert(material < (1u << MaterialBits));
+    assert(mesh < (1u << MeshBits));
+
+    // Quantize the view-space depth to a fixed point value in [0, 2^DepthBits - 1].
+    constexpr uint64_t maxDepth = (1ull << DepthBits) - 1;
+    float    normalizedDepth    = std::clamp(viewDepth / farPlane, 0.0f, 1.0f);
+    uint64_t depth              = static_cast<uint64_t>(normalizedDepth * static_cast<float>(maxDepth));
+
+    uint64_t sortKey = MaskBits(pass, PassBits) << (64 - PassBits);
+
+    if (pass == ERenderPass::Transparent)
+    {
+        sortKey |= MaskBits(maxDepth - depth, DepthBits) << (MeshBits + MaterialBits + PipelineBits);
+        sortKey |= MaskBits(pipeline, PipelineBits)      << (MeshBits + MaterialBits);
+        sortKey |= MaskBits(material, MaterialBits)      << MeshBits;
+        sortKey |= MaskBits(mesh, MeshBits);
+    }
+    else
+    {
+        sortKey |= MaskBits(pipeline, PipelineBits) << (DepthBits + MeshBits + MaterialBits);
+        sortKey |= MaskBits(material, MaterialBits) << (DepthBits + MeshBits);
+        sortKey |= MaskBits(mesh, MeshBits)         << DepthBits;
+        sortKey |= MaskBits(depth, DepthBits);
+    }
+
+    return sortKey;
+}
+
+ERenderPass RenderQueue::PassOf(uint64_t sortKey)
+{
+    return static_cast<ERenderPass>(sortKey >> (64 - PassBits));
+}
+
+uint32_t RenderQueue::PipelineOf(uint64_t sortKey)
+{
+    uint32_t shift = (PassOf(sortKey) == ERenderPass::Transparent) ? (MeshBits + MaterialBits)
+                                                                    : (DepthBits + MeshBits + MaterialBits);
+    return static_cast<uint32_t>(MaskBits(sortKey >> shift, PipelineBits));
+}
+
+uint32_t RenderQueue::MaterialOf(uint64_t sortKey)
+{
+    uint32_t shift = (PassOf(sortKey) == ERenderPass::Transparent) ? MeshBits
+                                                                    : (DepthBits + MeshBits);
+    return static_cast<uint32_t>(MaskBits(sortKey >> shift, MaterialBits));
+}
+
+uint32_t RenderQueue::MeshOf(uint64_t sortKey)
+{
+    uint32_t shift = (PassOf(sortKey) == ERenderPass::Transparent) ? 0 : DepthBits;
+    return static_cast<uint32_t>(MaskBits(sortKey >> shift, MeshBits));
+}
+
+void RenderQueue::Sort()
+{
+    const size_t count = m_packets.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    m_scratch.resize(count);
+
+    DrawPacket* pSrc = m_packets.data();
+    DrawPacket* pDst = m_scratch.data();
+
+    // LSD radix sort, one byte of the key per pass. It is stable, so the order established by the
+    // lower bytes is kept when sorting by the higher ones.
+    for (uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {};
+        for (size_t i = 0; i < count; i++)
+        {
+            histogram[(pSrc[i].sortKey >> shift) & 0xFF]++;
+        }
+
+        ///@note Most bytes are identical for all packets of a frame (e.g. the pass and the unused
+        ///      high pipeline bits), so skip the scatter when a single bucket holds everything.
+        if (histogram[(pSrc[0].sortKey >> shift) & 0xFF] == count)
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& bucket : histogram)
+        {
+            size_t bucketSize = bucket;
+            bucket  = offset;
+            offset += bucketSize;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            pDst[histogram[(pSrc[i].sortKey >> shift) & 0xFF]++] = pSrc[i];
+        }
+
+        std::swap(pSrc, pDst);
+    }
+
+    if (pSrc != m_packets.data())
+    {
+        std::copy(pSrc, pSrc + count, m_packets.data());
+    }
+}
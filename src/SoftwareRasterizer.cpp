@@ -0,0 +1,618 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iterator>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define RASTERIZER_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define RASTERIZER_USE_SSE 0
+#endif
+
+// Pixels along each side of a tile; a multiple of the four pixels rasterized at once.
+static const uint32_t TILE_SIZE = 64;
+
+// Setup jobs per thread, so threads that get cheap draws pick up more of them.
+static const uint32_t CHUNKS_PER_THREAD = 4;
+
+// The color the frame is cleared to, in linear space like the clear value of the color attachment.
+static const glm::vec3 CLEAR_COLOR = glm::vec3(0.25f, 0.0f, 0.0f);
+
+// The board glyphs of shader.frag: 3x5 pixels of the file letters a-h and the rank digits 1-8.
+static const uint32_t GLYPHS[16] =
+{
+    0x6B70u, 0x3B59u, 0x6270u, 0x6B74u, 0x63EAu, 0x12CEu, 0x39AEu, 0x5B59u,
+    0x749Au, 0x72A3u, 0x38A3u, 0x49EDu, 0x38CFu, 0x2ACEu, 0x24A7u, 0x2AAAu,
+};
+
+// Size of a glyph pixel, in squares.
+static const float GLYPH_PIXEL = 0.07f;
+
+static inline float EvaluatePlane(const glm::vec3& plane, float x, float y)
+{
+    return plane.x * x + plane.y * y + plane.z;
+}
+
+static inline glm::vec4 TransformPoint(const glm::mat4& matrix, const glm::vec3& point)
+{
+#if RASTERIZER_USE_SSE
+    // The columns of the matrix are contiguous, so every column is one load.
+    __m128 result = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&matrix[0][0]), _mm_set1_ps(point.x)),
+                                          _mm_mul_ps(_mm_loadu_ps(&matrix[1][0]), _mm_set1_ps(point.y))),
+                               _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&matrix[2][0]), _mm_set1_ps(point.z)),
+                                          _mm_loadu_ps(&matrix[3][0])));
+    glm::vec4 transformed;
+    _mm_storeu_ps(&transformed.x, result);
+    return transformed;
+#else
+    return matrix * glm::vec4(point, 1.0f);
+#endif
+}
+
+// True where the glyph, centered on center, has a lit pixel at point; both are in squares.
+static bool GlyphPixel(uint32_t glyph, glm::vec2 point, glm::vec2 center)
+{
+    int x = static_cast<int>(std::floor((point.x - center.x) / GLYPH_PIXEL + 1.5f));
+    int y = static_cast<int>(std::floor((point.y - center.y) / GLYPH_PIXEL + 2.5f));
+    if ((x < 0) || (y < 0) || (x >= 3) || (y >= 5))
+    {
+        return false;
+    }
+    return (GLYPHS[glyph] & (1u << ((4 - y) * 3 + x))) != 0;
+}
+
+void SoftwareRasterizer::Init(ThreadPool* pThreadPool)
+{
+    assert(pThreadPool != nullptr);
+    m_pThreadPool = pThreadPool;
+
+    // The textures and the frame are sRGB like on the GPU, so shading happens in linear space in between.
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        float value       = i / 255.0f;
+        m_srgbToLinear[i] = (value <= 0.04045f) ? (value / 12.92f) : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+    for (uint32_t i = 0; i < 4096; i++)
+    {
+        float value       = i / 4095.0f;
+        float encoded     = (value <= 0.0031308f) ? (value * 12.92f) : (1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f);
+        m_linearToSrgb[i] = static_cast<uint8_t>(encoded * 255.0f + 0.5f);
+    }
+}
+
+uint32_t SoftwareRasterizer::AddTexture(uint32_t width, uint32_t height, const uint8_t* pPixels)
+{
+    assert((width > 0) && (height > 0) && (pPixels != nullptr));
+
+    Texture texture;
+    texture.width  = width;
+    texture.height = height;
+    texture.texels.assign(pPixels, pPixels + static_cast<size_t>(width) * height * 4);
+
+    m_textures.push_back(std::move(texture));
+    return static_cast<uint32_t>(m_textures.size() - 1);
+}
+
+void SoftwareRasterizer::Resize(uint32_t width, uint32_t height)
+{
+    if ((width == m_width) && (height == m_height))
+    {
+        return;
+    }
+
+    m_width       = width;
+    m_height      = height;
+    m_depthStride = (width + 3) & ~3u;
+    m_tilesX      = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tilesY      = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    m_pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+    m_depth.assign(static_cast<size_t>(m_depthStride) * height, 1.0f);
+}
+
+void SoftwareRasterizer::Render(const glm::mat4& viewProj, const BoardData* pBoards, const std::vector<SoftwareDraw>& draws)
+{
+    assert(m_pThreadPool != nullptr);
+
+    if ((m_width == 0) || (m_height == 0))
+    {
+        return;
+    }
+
+    m_pDraws  = &draws;
+    m_pBoards = pBoards;
+
+    // Split the draws into runs of consecutive draws, one per setup job.
+    uint32_t drawCount     = static_cast<uint32_t>(draws.size());
+    uint32_t jobCount      = (m_pThreadPool->ThreadCount() + 1) * CHUNKS_PER_THREAD;
+    uint32_t drawsPerChunk = std::max(1u, (drawCount + jobCount - 1) / jobCount);
+    m_chunkCount = (drawCount + drawsPerChunk - 1) / drawsPerChunk;
+    if (m_chunks.size() < m_chunkCount)
+    {
+        m_chunks.resize(m_chunkCount);
+    }
+
+    m_pThreadPool->ParallelFor(m_chunkCount, 1, [&](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t chunk = begin; chunk < end; chunk++)
+        {
+            uint32_t firstDraw = chunk * drawsPerChunk;
+            SetUpDraws(m_chunks[chunk], firstDraw, std::min(firstDraw + drawsPerChunk, drawCount), viewProj);
+        }
+    });
+
+    ///@note The setup is done before any tile starts, so the tiles only read the chunks.
+    m_pThreadPool->ParallelFor(m_tilesX * m_tilesY, 1, [this](uint32_t begin, uint32_t end)
+    {
+        for (uint32_t tile = begin; tile < end; tile++)
+        {
+            RasterizeTile(tile);
+        }
+    });
+
+    m_setUpTriangles = 0;
+    for (uint32_t chunk = 0; chunk < m_chunkCount; chunk++)
+    {
+        m_setUpTriangles += m_chunks[chunk].triangles.size();
+    }
+
+    m_pDraws  = nullptr;
+    m_pBoards = nullptr;
+}
+
+void SoftwareRasterizer::SetUpDraws(Chunk& chunk, uint32_t firstDraw, uint32_t endDraw, const glm::mat4& viewProj) const
+{
+    chunk.triangles.clear();
+    chunk.bins.resize(m_tilesX * m_tilesY);
+    for (std::vector<uint32_t>& bin : chunk.bins)
+    {
+        bin.clear();
+    }
+
+    for (uint32_t drawIndex = firstDraw; drawIndex < endDraw; drawIndex++)
+    {
+        const SoftwareDraw& draw = (*m_pDraws)[drawIndex];
+
+        // shader.vert: the board's tile scales and offsets the clip space position.
+        const glm::vec4& tile       = m_pBoards[draw.board].tile;
+        glm::mat4        tileMatrix = glm::mat4(1.0f);
+        tileMatrix[0][0] = tile.x;
+        tileMatrix[1][1] = tile.y;
+        tileMatrix[3][0] = tile.z;
+        tileMatrix[3][1] = tile.w;
+        glm::mat4 clipFromModel = tileMatrix * viewProj * draw.world;
+
+        // Like the wireframe pipeline, wireframes show their back faces too.
+        bool cullBackFaces = (draw.variant != EPipelineVariant::Wireframe);
+
+        for (uint32_t index = 0; index + 2 < draw.indexCount; index += 3)
+        {
+            ClipVertex corners[3];
+            uint32_t   outside[6] = {};
+            uint32_t   behind     = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const Vertex& vertex = draw.pVertices[draw.pIndices[index + corner]];
+                ClipVertex&   clip   = corners[corner];
+                clip.position      = TransformPoint(clipFromModel, vertex.pos);
+                clip.attributes[0] = vertex.texCoord.x;
+                clip.attributes[1] = vertex.texCoord.y;
+                clip.attributes[2] = vertex.color.r;
+                clip.attributes[3] = vertex.color.g;
+                clip.attributes[4] = vertex.color.b;
+
+                const glm::vec4& p = clip.position;
+                outside[0] += (p.x < -p.w) ? 1 : 0;
+                outside[1] += (p.x >  p.w) ? 1 : 0;
+                outside[2] += (p.y < -p.w) ? 1 : 0;
+                outside[3] += (p.y >  p.w) ? 1 : 0;
+                outside[4] += (p.z >  p.w) ? 1 : 0;
+                outside[5] += (p.z < 0.0f) ? 1 : 0;
+            }
+
+            // Triangles entirely outside one plane of the view volume are dropped.
+            if (std::find(std::begin(outside), std::end(outside), 3u) != std::end(outside))
+            {
+                continue;
+            }
+
+            if (outside[5] == 0)
+            {
+                SetUpTriangle(corners, drawIndex, cullBackFaces, chunk);
+                continue;
+            }
+
+            // Clip against the near plane, z = 0 in Vulkan's depth range, which leaves up to four corners.
+            // The other planes are left to the bounds of the tiles.
+            ClipVertex polygon[4];
+            uint32_t   polygonCorners = 0;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                const ClipVertex& a = corners[corner];
+                const ClipVertex& b = corners[(corner + 1) % 3];
+                if (a.position.z >= 0.0f)
+                {
+                    polygon[polygonCorners++] = a;
+                }
+                if ((a.position.z >= 0.0f) != (b.position.z >= 0.0f))
+                {
+                    float       t       = a.position.z / (a.position.z - b.position.z);
+                    ClipVertex& between = polygon[polygonCorners++];
+                    between.position = glm::mix(a.position, b.position, t);
+                    for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++)
+                    {
+                        between.attributes[i] = a.attributes[i] + (b.attributes[i] - a.attributes[i]) * t;
+                    }
+                }
+            }
+
+            for (uint32_t corner = 1; corner + 1 < polygonCorners; corner++)
+            {
+                ClipVertex fan[3] = { polygon[0], polygon[corner], polygon[corner + 1] };
+                SetUpTriangle(fan, drawIndex, cullBackFaces, chunk);
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::SetUpTriangle(const ClipVertex* pCorners, uint32_t draw, bool cullBackFaces, Chunk& chunk) const
+{
+    // The viewport transform; framebuffer y points down like clip space y after the projection's flip.
+    glm::vec2 screen[3];
+    float     depth[3];
+    float     inverseW[3];
+    for (uint32_t corner = 0; corner < 3; corner++)
+    {
+        const glm::vec4& position = pCorners[corner].position;
+        inverseW[corner] = 1.0f / position.w;
+        screen[corner]   = glm::vec2((position.x * inverseW[corner] * 0.5f + 0.5f) * m_width,
+                                     (position.y * inverseW[corner] * 0.5f + 0.5f) * m_height);
+        depth[corner]    = position.z * inverseW[corner];
+    }
+
+    // Twice the signed area. The pipelines take counter-clockwise triangles as front faces, which makes it
+    // negative in framebuffer coordinates.
+    float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+    if ((area == 0.0f) || (cullBackFaces && (area > 0.0f)))
+    {
+        return;
+    }
+
+    // The pixel centers within the bounds, clamped to the screen.
+    float   minX   = std::min(std::min(screen[0].x, screen[1].x), screen[2].x);
+    float   maxX   = std::max(std::max(screen[0].x, screen[1].x), screen[2].x);
+    float   minY   = std::min(std::min(screen[0].y, screen[1].y), screen[2].y);
+    float   maxY   = std::max(std::max(screen[0].y, screen[1].y), screen[2].y);
+    int32_t firstX = std::max(static_cast<int32_t>(std::ceil(minX - 0.5f)), 0);
+    int32_t lastX  = std::min(static_cast<int32_t>(std::floor(maxX - 0.5f)), static_cast<int32_t>(m_width) - 1);
+    int32_t firstY = std::max(static_cast<int32_t>(std::ceil(minY - 0.5f)), 0);
+    int32_t lastY  = std::min(static_cast<int32_t>(std::floor(maxY - 0.5f)), static_cast<int32_t>(m_height) - 1);
+    if ((firstX > lastX) || (firstY > lastY))
+    {
+        return;
+    }
+
+    chunk.triangles.emplace_back();
+    Triangle& triangle = chunk.triangles.back();
+    triangle.minX         = firstX;
+    triangle.minY         = firstY;
+    triangle.maxX         = lastX;
+    triangle.maxY         = lastY;
+    triangle.draw         = draw;
+    triangle.topLeftEdges = 0;
+
+    // Edge i runs from corner i + 1 to corner i + 2 and is positive on the side of corner i, where it
+    // equals the area. An edge is a left edge when it grows to the right, and a top edge when it is
+    // horizontal and grows downwards.
+    float sign = (area > 0.0f) ? 1.0f : -1.0f;
+    for (uint32_t edge = 0; edge < 3; edge++)
+    {
+        const glm::vec2& from = screen[(edge + 1) % 3];
+        const glm::vec2& to   = screen[(edge + 2) % 3];
+        float            a    = (from.y - to.y) * sign;
+        float            b    = (to.x - from.x) * sign;
+        triangle.edges[edge]  = glm::vec3(a, b, -(a * from.x + b * from.y));
+
+        if ((a > 0.0f) || ((a == 0.0f) && (b > 0.0f)))
+        {
+            triangle.topLeftEdges |= 1u << edge;
+        }
+    }
+
+    // The barycentric coordinate of corner i is edge i over the area, so a value interpolated over the
+    // triangle is the sum of the edges weighted with the corners' values.
+    float inverseArea = 1.0f / std::abs(area);
+    auto  plane       = [&](float value0, float value1, float value2)
+    {
+        return (triangle.edges[0] * value0 + triangle.edges[1] * value1 + triangle.edges[2] * value2) * inverseArea;
+    };
+
+    triangle.depth    = plane(depth[0], depth[1], depth[2]);
+    triangle.inverseW = plane(inverseW[0], inverseW[1], inverseW[2]);
+    for (uint32_t i = 0; i < ATTRIBUTE_COUNT; i++)
+    {
+        triangle.attributes[i] = plane(pCorners[0].attributes[i] * inverseW[0],
+                                       pCorners[1].attributes[i] * inverseW[1],
+                                       pCorners[2].attributes[i] * inverseW[2]);
+    }
+
+    uint32_t triangleIndex = static_cast<uint32_t>(chunk.triangles.size() - 1);
+    for (uint32_t tileY = firstY / TILE_SIZE; tileY <= lastY / TILE_SIZE; tileY++)
+    {
+        for (uint32_t tileX = firstX / TILE_SIZE; tileX <= lastX / TILE_SIZE; tileX++)
+        {
+            chunk.bins[tileY * m_tilesX + tileX].push_back(triangleIndex);
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTile(uint32_t tile)
+{
+    int32_t tileX = static_cast<int32_t>((tile % m_tilesX) * TILE_SIZE);
+    int32_t tileY = static_cast<int32_t>((tile / m_tilesX) * TILE_SIZE);
+    int32_t endX  = std::min(tileX + static_cast<int32_t>(TILE_SIZE), static_cast<int32_t>(m_width));
+    int32_t endY  = std::min(tileY + static_cast<int32_t>(TILE_SIZE), static_cast<int32_t>(m_height));
+
+    // Every tile clears its own pixels, so clearing is spread over the threads as well.
+    uint8_t clear[4] =
+    {
+        m_linearToSrgb[static_cast<uint32_t>(CLEAR_COLOR.r * 4095.0f + 0.5f)],
+        m_linearToSrgb[static_cast<uint32_t>(CLEAR_COLOR.g * 4095.0f + 0.5f)],
+        m_linearToSrgb[static_cast<uint32_t>(CLEAR_COLOR.b * 4095.0f + 0.5f)],
+        255,
+    };
+    for (int32_t y = tileY; y < endY; y++)
+    {
+        uint8_t* pRow = &m_pixels[(static_cast<size_t>(y) * m_width + tileX) * 4];
+        for (int32_t x = tileX; x < endX; x++, pRow += 4)
+        {
+            pRow[0] = clear[0];
+            pRow[1] = clear[1];
+            pRow[2] = clear[2];
+            pRow[3] = clear[3];
+        }
+        std::fill_n(&m_depth[static_cast<size_t>(y) * m_depthStride + tileX], endX - tileX, 1.0f);
+    }
+
+    // The chunks hold consecutive draws, so going through them in order keeps the draw order.
+    for (uint32_t chunk = 0; chunk < m_chunkCount; chunk++)
+    {
+        const Chunk& source = m_chunks[chunk];
+        for (uint32_t triangleIndex : source.bins[tile])
+        {
+            RasterizeTriangle(source.triangles[triangleIndex], tileX, tileY, endX, endY);
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTriangle(const Triangle& triangle, int32_t tileX, int32_t tileY, int32_t endX, int32_t endY)
+{
+    // Blocks of four pixels start at multiples of four, so they never reach into the next tile.
+    int32_t firstX = std::max(triangle.minX, tileX) & ~3;
+    int32_t lastX  = std::min(triangle.maxX, endX - 1);
+    int32_t firstY = std::max(triangle.minY, tileY);
+    int32_t lastY  = std::min(triangle.maxY, endY - 1);
+
+    const SoftwareDraw& draw      = (*m_pDraws)[triangle.draw];
+    bool                wireframe = (draw.variant == EPipelineVariant::Wireframe);
+
+#if RASTERIZER_USE_SSE
+    const __m128 zero        = _mm_setzero_ps();
+    const __m128 laneOffsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    const __m128 lastX4      = _mm_set1_ps(static_cast<float>(lastX));
+
+    __m128 edgeA[3];
+    __m128 edgeStep[3];
+    for (uint32_t edge = 0; edge < 3; edge++)
+    {
+        edgeA[edge]    = _mm_set1_ps(triangle.edges[edge].x);
+        edgeStep[edge] = _mm_set1_ps(triangle.edges[edge].x * 4.0f);
+    }
+    const __m128 depthA    = _mm_set1_ps(triangle.depth.x);
+    const __m128 depthStep = _mm_set1_ps(triangle.depth.x * 4.0f);
+#endif
+
+    for (int32_t y = firstY; y <= lastY; y++)
+    {
+        float    centerY   = y + 0.5f;
+        float*   pDepthRow = &m_depth[static_cast<size_t>(y) * m_depthStride];
+        uint8_t* pPixelRow = &m_pixels[static_cast<size_t>(y) * m_width * 4];
+
+#if RASTERIZER_USE_SSE
+        // The edges and the depth at the centers of the first block, then stepped four pixels at a time.
+        __m128 x4        = _mm_add_ps(_mm_set1_ps(static_cast<float>(firstX)), laneOffsets);
+        __m128 centerX4  = _mm_add_ps(x4, _mm_set1_ps(0.5f));
+        __m128 edges[3];
+        for (uint32_t edge = 0; edge < 3; edge++)
+        {
+            float rowValue = triangle.edges[edge].y * centerY + triangle.edges[edge].z;
+            edges[edge]    = _mm_add_ps(_mm_mul_ps(edgeA[edge], centerX4), _mm_set1_ps(rowValue));
+        }
+        __m128 depth = _mm_add_ps(_mm_mul_ps(depthA, centerX4), _mm_set1_ps(triangle.depth.y * centerY + triangle.depth.z));
+#endif
+
+        for (int32_t x = firstX; x <= lastX; x += 4)
+        {
+            int   mask;
+            float depths[4];
+
+#if RASTERIZER_USE_SSE
+            // Lanes past the last pixel of the block's range are never written.
+            __m128 covered = _mm_cmple_ps(x4, lastX4);
+            for (uint32_t edge = 0; edge < 3; edge++)
+            {
+                __m128 inside = (triangle.topLeftEdges & (1u << edge)) ? _mm_cmpge_ps(edges[edge], zero) : _mm_cmpgt_ps(edges[edge], zero);
+                covered       = _mm_and_ps(covered, inside);
+            }
+
+            mask = _mm_movemask_ps(covered);
+            if (mask != 0)
+            {
+                mask = _mm_movemask_ps(_mm_and_ps(covered, _mm_cmplt_ps(depth, _mm_loadu_ps(pDepthRow + x))));
+                _mm_storeu_ps(depths, depth);
+            }
+
+            x4 = _mm_add_ps(x4, _mm_set1_ps(4.0f));
+            for (uint32_t edge = 0; edge < 3; edge++)
+            {
+                edges[edge] = _mm_add_ps(edges[edge], edgeStep[edge]);
+            }
+            depth = _mm_add_ps(depth, depthStep);
+#else
+            mask = 0;
+            for (int32_t lane = 0; (lane < 4) && (x + lane <= lastX); lane++)
+            {
+                float centerX = x + lane + 0.5f;
+                bool  inside  = true;
+                for (uint32_t edge = 0; edge < 3; edge++)
+                {
+                    float value = EvaluatePlane(triangle.edges[edge], centerX, centerY);
+                    inside     &= (triangle.topLeftEdges & (1u << edge)) ? (value >= 0.0f) : (value > 0.0f);
+                }
+                depths[lane] = EvaluatePlane(triangle.depth, centerX, centerY);
+                if (inside && (depths[lane] < pDepthRow[x + lane]))
+                {
+                    mask |= 1 << lane;
+                }
+            }
+#endif
+
+            // The fragment shader only runs for the pixels that passed the depth test.
+            for (int32_t lane = 0; mask != 0; lane++, mask >>= 1)
+            {
+                if ((mask & 1) == 0)
+                {
+                    continue;
+                }
+
+                float centerX = x + lane + 0.5f;
+                if (wireframe)
+                {
+                    // Only the pixels within a pixel of an edge, measured across the edge.
+                    bool nearEdge = false;
+                    for (uint32_t edge = 0; edge < 3; edge++)
+                    {
+                        const glm::vec3& plane = triangle.edges[edge];
+                        nearEdge |= EvaluatePlane(plane, centerX, centerY) < std::sqrt(plane.x * plane.x + plane.y * plane.y);
+                    }
+                    if (!nearEdge)
+                    {
+                        continue;
+                    }
+                }
+
+                pDepthRow[x + lane] = depths[lane];
+
+                glm::vec3 color  = glm::clamp(Shade(triangle, draw, centerX, centerY), 0.0f, 1.0f);
+                uint8_t*  pPixel = pPixelRow + static_cast<size_t>(x + lane) * 4;
+                pPixel[0] = m_linearToSrgb[static_cast<uint32_t>(color.r * 4095.0f + 0.5f)];
+                pPixel[1] = m_linearToSrgb[static_cast<uint32_t>(color.g * 4095.0f + 0.5f)];
+                pPixel[2] = m_linearToSrgb[static_cast<uint32_t>(color.b * 4095.0f + 0.5f)];
+                pPixel[3] = 255;
+            }
+        }
+    }
+}
+
+glm::vec3 SoftwareRasterizer::Shade(const Triangle& triangle, const SoftwareDraw& draw, float x, float y) const
+{
+    // Perspective correct interpolation, as for the fragment shader's inputs.
+    float     w        = 1.0f / EvaluatePlane(triangle.inverseW, x, y);
+    glm::vec2 texCoord = glm::vec2(EvaluatePlane(triangle.attributes[0], x, y), EvaluatePlane(triangle.attributes[1], x, y)) * w;
+
+    switch (draw.variant)
+    {
+    case EPipelineVariant::VertexColor:
+        return glm::vec3(EvaluatePlane(triangle.attributes[2], x, y), EvaluatePlane(triangle.attributes[3], x, y), EvaluatePlane(triangle.attributes[4], x, y)) * w;
+    case EPipelineVariant::Wireframe:
+        return glm::vec3(0.9f);
+    case EPipelineVariant::Board:
+        return BoardColor(draw, texCoord);
+    case EPipelineVariant::Highlight:
+        return glm::mix(Sample(draw.textureIndex, texCoord), glm::vec3(1.0f, 0.8f, 0.2f), 0.4f);
+    default:
+        return Sample(draw.textureIndex, texCoord);
+    }
+}
+
+glm::vec3 SoftwareRasterizer::BoardColor(const SoftwareDraw& draw, glm::vec2 board) const
+{
+    // The same as BoardColor() in shader.frag: the texture coordinate is the position in squares.
+    glm::vec3 wood = Sample(draw.textureIndex, board / 8.0f);
+
+    if ((board.x < 0.0f) || (board.y < 0.0f) || (board.x >= 8.0f) || (board.y >= 8.0f))
+    {
+        glm::vec3 color = wood * glm::vec3(0.35f, 0.25f, 0.18f);
+        glm::vec3 ink   = glm::vec3(0.9f, 0.85f, 0.7f);
+        int       file  = static_cast<int>(std::floor(board.x));
+        int       rank  = static_cast<int>(std::floor(board.y));
+        if ((board.y < 0.0f) && (file >= 0) && (file < 8) && GlyphPixel(file, board, glm::vec2(file + 0.5f, -0.25f)))
+        {
+            color = ink;
+        }
+        if ((board.x < 0.0f) && (rank >= 0) && (rank < 8) && GlyphPixel(8 + rank, board, glm::vec2(-0.25f, rank + 0.5f)))
+        {
+            color = ink;
+        }
+        return color;
+    }
+
+    int       file  = static_cast<int>(board.x);
+    int       rank  = static_cast<int>(board.y);
+    bool      dark  = ((file + rank) & 1) == 0; // a1 is dark.
+    glm::vec3 color = (dark ? glm::vec3(0.55f, 0.36f, 0.22f) : glm::vec3(0.95f, 0.85f, 0.68f)) * (0.5f + wood);
+
+    uint32_t state = m_pBoards[draw.board].squares[rank * 8 + file];
+    if (state & ESquareFlag::SquareLastMove)
+    {
+        color = glm::mix(color, glm::vec3(0.8f, 0.85f, 0.3f), 0.35f);
+    }
+    if (state & ESquareFlag::SquareSelected)
+    {
+        color = glm::mix(color, glm::vec3(1.0f, 0.8f, 0.2f), 0.5f);
+    }
+    if ((state & ESquareFlag::SquareAttacked) && (glm::length(glm::fract(board) - 0.5f) < 0.15f))
+    {
+        color = glm::mix(color, glm::vec3(0.1f), 0.4f);
+    }
+    return color;
+}
+
+glm::vec3 SoftwareRasterizer::Sample(uint32_t textureIndex, glm::vec2 texCoord) const
+{
+    // Bilinear filtering with repeat addressing like the texture sampler. The texels are decoded
+    // before they are filtered, as for an sRGB image.
+    const Texture& texture = m_textures[textureIndex];
+    int32_t        width   = static_cast<int32_t>(texture.width);
+    int32_t        height  = static_cast<int32_t>(texture.height);
+
+    float   x      = texCoord.x * width - 0.5f;
+    float   y      = texCoord.y * height - 0.5f;
+    float   floorX = std::floor(x);
+    float   floorY = std::floor(y);
+    float   tx     = x - floorX;
+    float   ty     = y - floorY;
+    int32_t x0     = static_cast<int32_t>(floorX) % width;
+    int32_t y0     = static_cast<int32_t>(floorY) % height;
+    x0 += (x0 < 0) ? width : 0;
+    y0 += (y0 < 0) ? height : 0;
+    int32_t x1 = (x0 + 1 == width) ? 0 : (x0 + 1);
+    int32_t y1 = (y0 + 1 == height) ? 0 : (y0 + 1);
+
+    const uint8_t* pTexel00 = &texture.texels[(static_cast<size_t>(y0) * width + x0) * 4];
+    const uint8_t* pTexel10 = &texture.texels[(static_cast<size_t>(y0) * width + x1) * 4];
+    const uint8_t* pTexel01 = &texture.texels[(static_cast<size_t>(y1) * width + x0) * 4];
+    const uint8_t* pTexel11 = &texture.texels[(static_cast<size_t>(y1) * width + x1) * 4];
+
+    glm::vec3 color;
+    for (int channel = 0; channel < 3; channel++)
+    {
+        float top    = m_srgbToLinear[pTexel00[channel]] + (m_srgbToLinear[pTexel10[channel]] - m_srgbToLinear[pTexel00[channel]]) * tx;
+        float bottom = m_srgbToLinear[pTexel01[channel]] + (m_srgbToLinear[pTexel11[channel]] - m_srgbToLinear[pTexel01[channel]]) * tx;
+        color[channel] = top + (bottom - top) * ty;
+    }
+    return color;
+}
@@ -0,0 +1,179 @@
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+void ThreadPool::Start(uint32_t threadCount)
+{
+    assert(m_threads.empty());
+    assert(threadCount > 0);
+
+    m_stopping = false;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+void ThreadPool::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    for (std::thread& thread : m_threads)
+    {
+        thread.join();
+    }
+    m_threads.clear();
+}
+
+void ThreadPool::Enqueue(std::function<void()> job)
+{
+    assert(!m_threads.empty());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push(std::move(job));
+    }
+    m_jobAvailable.notify_one();
+}
+
+void ThreadPool::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this] { return m_jobs.empty() && (m_activeJobs == 0); });
+
+    if (m_error)
+    {
+        std::exception_ptr error = m_error;
+        m_error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body)
+{
+    assert(grainSize > 0);
+
+    uint32_t chunkCount = (count + grainSize - 1) / grainSize;
+    if ((chunkCount <= 1) || m_threads.empty())
+    {
+        if (count > 0)
+        {
+            body(0, count);
+        }
+        return;
+    }
+
+    ///@note Helpers may only start after every range is done; they then find nothing left and return
+    ///      without touching body, so the shared state is all they need to outlive this call.
+    struct Batch
+    {
+        std::atomic<uint32_t>   nextChunk{ 0 };
+        std::atomic<uint32_t>   doneChunks{ 0 };
+        std::mutex              mutex;
+        std::condition_variable done;
+        std::exception_ptr      error; // First exception thrown by body, guarded by mutex.
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+
+    auto work = [batch, count, grainSize, chunkCount, body]()
+    {
+        for (uint32_t chunk = batch->nextChunk++; chunk < chunkCount; chunk = batch->nextChunk++)
+        {
+            // A range that throws still counts as done, or the calling thread would wait for it forever.
+            uint32_t begin = chunk * grainSize;
+            try
+            {
+                body(begin, std::min(count, begin + grainSize));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                if (!batch->error)
+                {
+                    batch->error = std::current_exception();
+                }
+            }
+
+            if (++batch->doneChunks == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(batch->mutex);
+                batch->done.notify_all();
+            }
+        }
+    };
+
+    uint32_t helperCount = std::min(ThreadCount(), chunkCount - 1);
+    for (uint32_t i = 0; i < helperCount; i++)
+    {
+        Enqueue(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch, chunkCount] { return batch->doneChunks == chunkCount; });
+
+    if (batch->error)
+    {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+uint32_t ThreadPool::DefaultThreadCount()
+{
+    // Leave one hardware thread for the render loop.
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    return std::max(1u, (hardwareThreads > 1) ? (hardwareThreads - 1) : 1u);
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_jobAvailable.wait(lock, [this] { return m_stopping || !m_jobs.empty(); });
+
+            ///@note Pending jobs are drained before the workers exit.
+            if (m_jobs.empty())
+            {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+            m_activeJobs++;
+        }
+
+        // The job is counted as finished either way, so WaitIdle() still returns.
+        std::exception_ptr error;
+        try
+        {
+            job();
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error)
+            {
+                m_error = error;
+            }
+            m_activeJobs--;
+            if (m_jobs.empty() && (m_activeJobs == 0))
+            {
+                m_idle.notify_all();
+            }
+        }
+    }
+}
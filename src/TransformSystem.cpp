@@ -0,0 +1,231 @@
+#include "TransformSystem.h"
+#include "ThreadPool.h"
+
+#include <cassert>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#define TRANSFORM_USE_SSE 1
+#include <xmmintrin.h>
+#else
+#define TRANSFORM_USE_SSE 0
+#endif
+
+// Levels with fewer nodes are updated on the calling thread; splitting them costs more than it saves.
+static const uint32_t PARALLEL_MIN_NODES = 1024;
+
+// Nodes per job of a parallel level.
+static const uint32_t PARALLEL_GRAIN_SIZE = 256;
+
+// result = a * b for column-major matrices; result may not alias a or b.
+static inline void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& result)
+{
+#if TRANSFORM_USE_SSE
+    __m128 a0 = _mm_loadu_ps(&a[0][0]);
+    __m128 a1 = _mm_loadu_ps(&a[1][0]);
+    __m128 a2 = _mm_loadu_ps(&a[2][0]);
+    __m128 a3 = _mm_loadu_ps(&a[3][0]);
+    for (int column = 0; column < 4; column++)
+    {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[column][0]));
+        r        = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(b[column][1])));
+        r        = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(b[column][2])));
+        r        = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(b[column][3])));
+        _mm_storeu_ps(&result[column][0], r);
+    }
+#else
+    result = a * b;
+#endif
+}
+
+uint32_t TransformSystem::Create(uint32_t parent)
+{
+    assert((parent == NO_PARENT) || (parent < Count()));
+
+    uint32_t node = Count();
+
+    m_positionX.push_back(0.0f);
+    m_positionY.push_back(0.0f);
+    m_positionZ.push_back(0.0f);
+    m_rotationX.push_back(0.0f);
+    m_rotationY.push_back(0.0f);
+    m_rotationZ.push_back(0.0f);
+    m_rotationW.push_back(1.0f);
+    m_scaleX.push_back(1.0f);
+    m_scaleY.push_back(1.0f);
+    m_scaleZ.push_back(1.0f);
+
+    m_parents.push_back(parent);
+    m_localDirty.push_back(1);
+    m_worldChanged.push_back(0);
+    m_worldMatrices.push_back(glm::mat4(1.0f));
+
+    m_hierarchyDirty = true;
+    return node;
+}
+
+void TransformSystem::Clear()
+{
+    m_positionX.clear();
+    m_positionY.clear();
+    m_positionZ.clear();
+    m_rotationX.clear();
+    m_rotationY.clear();
+    m_rotationZ.clear();
+    m_rotationW.clear();
+    m_scaleX.clear();
+    m_scaleY.clear();
+    m_scaleZ.clear();
+
+    m_parents.clear();
+    m_localDirty.clear();
+    m_worldChanged.clear();
+    m_worldMatrices.clear();
+
+    m_depthOrder.clear();
+    m_levelStarts.clear();
+    m_hierarchyDirty = false;
+}
+
+void TransformSystem::SetParent(uint32_t node, uint32_t parent)
+{
+    assert((parent == NO_PARENT) || (parent < Count()));
+
+    m_parents[node]    = parent;
+    m_localDirty[node] = 1;
+    m_hierarchyDirty   = true;
+}
+
+void TransformSystem::SetPosition(uint32_t node, const glm::vec3& position)
+{
+    m_positionX[node]  = position.x;
+    m_positionY[node]  = position.y;
+    m_positionZ[node]  = position.z;
+    m_localDirty[node] = 1;
+}
+
+void TransformSystem::SetRotation(uint32_t node, const glm::quat& rotation)
+{
+    m_rotationX[node]  = rotation.x;
+    m_rotationY[node]  = rotation.y;
+    m_rotationZ[node]  = rotation.z;
+    m_rotationW[node]  = rotation.w;
+    m_localDirty[node] = 1;
+}
+
+void TransformSystem::SetScale(uint32_t node, const glm::vec3& scale)
+{
+    m_scaleX[node]     = scale.x;
+    m_scaleY[node]     = scale.y;
+    m_scaleZ[node]     = scale.z;
+    m_localDirty[node] = 1;
+}
+
+void TransformSystem::SortByDepth()
+{
+    uint32_t count = Count();
+
+    // A node's depth is one more than its parent's. Parents may have been created after their children,
+    // so follow each chain until a node of known depth.
+    std::vector<uint32_t> depths(count, UINT32_MAX);
+    std::vector<uint32_t> chain;
+    uint32_t              maxDepth = 0;
+    for (uint32_t node = 0; node < count; node++)
+    {
+        uint32_t current = node;
+        while ((current != NO_PARENT) && (depths[current] == UINT32_MAX))
+        {
+            chain.push_back(current);
+            current = m_parents[current];
+            assert(chain.size() <= count); // A cycle.
+        }
+
+        uint32_t depth = (current == NO_PARENT) ? 0 : (depths[current] + 1);
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it, depth++)
+        {
+            depths[*it] = depth;
+            maxDepth    = std::max(maxDepth, depth);
+        }
+        chain.clear();
+    }
+
+    // Counting sort by depth.
+    m_levelStarts.assign(maxDepth + 2, 0);
+    for (uint32_t node = 0; node < count; node++)
+    {
+        m_levelStarts[depths[node] + 1]++;
+    }
+    for (uint32_t level = 1; level < m_levelStarts.size(); level++)
+    {
+        m_levelStarts[level] += m_levelStarts[level - 1];
+    }
+
+    m_depthOrder.resize(count);
+    std::vector<uint32_t> next(m_levelStarts.begin(), m_levelStarts.end() - 1);
+    for (uint32_t node = 0; node < count; node++)
+    {
+        m_depthOrder[next[depths[node]]++] = node;
+    }
+
+    m_hierarchyDirty = false;
+}
+
+void TransformSystem::UpdateRange(const uint32_t* nodes, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t node   = nodes[i];
+        uint32_t parent = m_parents[node];
+
+        bool changed = (m_localDirty[node] != 0) || ((parent != NO_PARENT) && (m_worldChanged[parent] != 0));
+        m_worldChanged[node] = changed ? 1 : 0;
+        if (!changed)
+        {
+            continue;
+        }
+        m_localDirty[node] = 0;
+
+        // Local matrix: translation * rotation * scale.
+        glm::quat rotation(m_rotationW[node], m_rotationX[node], m_rotationY[node], m_rotationZ[node]);
+        glm::mat4 local = glm::mat4_cast(rotation);
+        local[0]       *= m_scaleX[node];
+        local[1]       *= m_scaleY[node];
+        local[2]       *= m_scaleZ[node];
+        local[3]        = glm::vec4(m_positionX[node], m_positionY[node], m_positionZ[node], 1.0f);
+
+        if (parent == NO_PARENT)
+        {
+            m_worldMatrices[node] = local;
+        }
+        else
+        {
+            MultiplyMatrices(m_worldMatrices[parent], local, m_worldMatrices[node]);
+        }
+    }
+}
+
+void TransformSystem::Update(ThreadPool* pThreadPool)
+{
+    if (m_hierarchyDirty)
+    {
+        SortByDepth();
+    }
+
+    for (uint32_t level = 0; level + 1 < m_levelStarts.size(); level++)
+    {
+        const uint32_t* nodes = m_depthOrder.data() + m_levelStarts[level];
+        uint32_t        count = m_levelStarts[level + 1] - m_levelStarts[level];
+
+        if ((pThreadPool == nullptr) || (count < PARALLEL_MIN_NODES))
+        {
+            UpdateRange(nodes, count);
+        }
+        else
+        {
+            pThreadPool->ParallelFor(count, PARALLEL_GRAIN_SIZE, [this, nodes](uint32_t begin, uint32_t end)
+            {
+                UpdateRange(nodes + begin, end - begin);
+            });
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "Utils.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <cstdint>
+#include <chrono>
+
+double ProcessCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+    {
+        return 0.0;
+    }
+
+    // FILETIME counts 100 ns intervals.
+    auto toSeconds = [](const FILETIME& time)
+    {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;
+    };
+    return toSeconds(kernelTime) + toSeconds(userTime);
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0.0;
+    }
+
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+double MonotonicTime()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool VulkanLoaderAvailable()
+{
+#ifdef _WIN32
+    // The delay load helper loads the library again on the first call, so this reference can be dropped.
+    HMODULE vulkanLoader = LoadLibraryA("vulkan-1.dll");
+    if (vulkanLoader == nullptr)
+    {
+        return false;
+    }
+    FreeLibrary(vulkanLoader);
+    return true;
+#else
+    // Elsewhere the loader is linked normally, so the process would not have started without it.
+    return true;
+#endif
+}
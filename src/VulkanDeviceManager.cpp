@@ -2,6 +2,10 @@
 #include "MemoryTracker.h"
 
 #include <set>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
 
 VulkanDeviceManager* g_pVk = nullptr;
 
@@ -77,6 +81,23 @@ void VulkanDeviceManager::EnableDeviceExtensions(const std::vector<const char*>*
     }
 }
 
+void VulkanDeviceManager::EnableOptionalDeviceExtensions(const std::vector<const char*>* pDeviceExtensions)
+{
+    assert(m_device == VK_NULL_HANDLE);
+
+    m_optionalDeviceExtensions.clear();
+
+    if (pDeviceExtensions != nullptr)
+    {
+        m_optionalDeviceExtensions.assign(pDeviceExtensions->begin(), pDeviceExtensions->end());
+    }
+}
+
+bool VulkanDeviceManager::IsDeviceExtensionEnabled(const char* extensionName) const
+{
+    return m_enabledDeviceExtensions.count(extensionName) > 0;
+}
+
 void VulkanDeviceManager::CreateGlfwWindow(int width, int height)
 {
     m_pSurfaceManager = new VulkanSurfaceManager(this);
@@ -88,6 +109,14 @@ void VulkanDeviceManager::CreateSurface()
     m_pSurfaceManager->CreateSurface();
 }
 
+void VulkanDeviceManager::CreateHeadlessTarget(int width, int height)
+{
+    assert(m_headless);
+
+    m_pSurfaceManager = new VulkanSurfaceManager(this);
+    m_pSurfaceManager->InitHeadless(width, height);
+}
+
 QueueFamilyIndices VulkanDeviceManager::FindQueueFamilies(VkPhysicalDevice device)
 {
     QueueFamilyIndices indices;
@@ -106,12 +135,20 @@ QueueFamilyIndices VulkanDeviceManager::FindQueueFamilies(VkPhysicalDevice devic
             indices.graphicsFamily = i;
         }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_pSurfaceManager->Surface(), &presentSupport);
-
-        if (presentSupport)
+        // Headless frames are read back instead of presented, so the graphics queue stands in for the present queue.
+        if (m_headless)
         {
-            indices.presentFamily = i;
+            indices.presentFamily = indices.graphicsFamily;
+        }
+        else
+        {
+            VkBool32 presentSupport = false;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_pSurfaceManager->Surface(), &presentSupport);
+
+            if (presentSupport)
+            {
+                indices.presentFamily = i;
+            }
         }
 
         if (indices.isComplete())
@@ -149,17 +186,44 @@ bool VulkanDeviceManager::IsDeviceSuitable(VkPhysicalDevice device)
 
     bool extensionsSupported = CheckDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported)
+    bool swapChainAdequate = m_headless;
+    if (extensionsSupported && !m_headless)
     {
         SwapChainSupportDetails swapChainSupport = m_pSurfaceManager->QuerySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
-    VkPhysicalDeviceFeatures supportedFeatures;
-    vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device, &properties);
+
+    ///@note Rendering is recorded with dynamic rendering, which is core in Vulkan 1.3.
+    if (properties.apiVersion < VK_API_VERSION_1_3)
+    {
+        return false;
+    }
 
-    return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+    VkPhysicalDeviceVulkan13Features supportedFeatures13{};
+    supportedFeatures13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+    VkPhysicalDeviceVulkan12Features supportedFeatures12{};
+    supportedFeatures12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    supportedFeatures12.pNext = &supportedFeatures13;
+
+    VkPhysicalDeviceFeatures2 supportedFeatures{};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    supportedFeatures.pNext = &supportedFeatures12;
+    vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+    // Bindless textures are a runtime sized, partially bound array that is updated after binding.
+    bool descriptorIndexingSupported = supportedFeatures12.descriptorIndexing &&
+                                       supportedFeatures12.runtimeDescriptorArray &&
+                                       supportedFeatures12.descriptorBindingPartiallyBound &&
+                                       supportedFeatures12.descriptorBindingSampledImageUpdateAfterBind &&
+                                       supportedFeatures12.shaderSampledImageArrayNonUniformIndexing;
+
+    return indices.isComplete() && extensionsSupported && swapChainAdequate &&
+           supportedFeatures.features.samplerAnisotropy && supportedFeatures13.dynamicRendering &&
+           descriptorIndexingSupported;
 }
 
 void VulkanDeviceManager::PickPhysicalDevice()
@@ -208,19 +272,101 @@ void VulkanDeviceManager::CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures{};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.samplerAnisotropy         = VK_TRUE;
+    deviceFeatures.fillModeNonSolid          = supportedFeatures.fillModeNonSolid;          // Optional, for wireframe pipelines.
+    deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance; // Optional, for occlusion culling.
+    deviceFeatures.multiDrawIndirect         = supportedFeatures.multiDrawIndirect;         // Optional, batches indirect draws.
+
+    VkPhysicalDeviceVulkan13Features deviceFeatures13{};
+    deviceFeatures13.sType            = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    deviceFeatures13.dynamicRendering = VK_TRUE;
+
+    VkPhysicalDeviceVulkan12Features deviceFeatures12{};
+    deviceFeatures12.sType                                        = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    deviceFeatures12.pNext                                        = &deviceFeatures13;
+    deviceFeatures12.descriptorIndexing                           = VK_TRUE;
+    deviceFeatures12.runtimeDescriptorArray                       = VK_TRUE;
+    deviceFeatures12.descriptorBindingPartiallyBound              = VK_TRUE;
+    deviceFeatures12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    deviceFeatures12.shaderSampledImageArrayNonUniformIndexing    = VK_TRUE;
+    deviceFeatures12.timelineSemaphore                            = VK_TRUE;
+
+    // Optional extensions are enabled when the device supports them; the required ones were checked when picking the device.
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    std::set<std::string> supportedExtensions;
+    for (const auto& extension : availableExtensions)
+    {
+        supportedExtensions.insert(extension.extensionName);
+    }
+
+    std::vector<const char*> enabledExtensions(m_deviceExtensions.begin(), m_deviceExtensions.end());
+    for (const std::string& extension : m_optionalDeviceExtensions)
+    {
+        if (supportedExtensions.count(extension) > 0)
+        {
+            enabledExtensions.push_back(extension.c_str());
+        }
+    }
+
+    ///@note Present wait needs present id, and both need their feature bits on top of the extensions.
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    presentIdFeatures.pNext = &presentWaitFeatures;
+
+    auto isEnabled = [&enabledExtensions](const char* extensionName)
+    {
+        return std::find_if(enabledExtensions.begin(), enabledExtensions.end(),
+                            [extensionName](const char* name) { return strcmp(name, extensionName) == 0; }) != enabledExtensions.end();
+    };
+
+    if (isEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) || isEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+
+        bool presentWait = isEnabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) && isEnabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+                           presentIdFeatures.presentId && presentWaitFeatures.presentWait;
+        if (presentWait)
+        {
+            deviceFeatures13.pNext = &presentIdFeatures;
+        }
+        else
+        {
+            enabledExtensions.erase(std::remove_if(enabledExtensions.begin(), enabledExtensions.end(),
+                                                   [](const char* name)
+                                                   {
+                                                       return (strcmp(name, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0) ||
+                                                              (strcmp(name, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0);
+                                                   }),
+                                    enabledExtensions.end());
+        }
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &deviceFeatures12;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(m_deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (m_enableValidationLayers)
     {
@@ -237,16 +383,102 @@ void VulkanDeviceManager::CreateLogicalDevice()
         throw std::runtime_error("failed to create logical device!");
     }
 
+    m_enabledFeatures = deviceFeatures;
+    m_enabledDeviceExtensions.clear();
+    m_enabledDeviceExtensions.insert(enabledExtensions.begin(), enabledExtensions.end());
+
     assert(m_graphicsQueue == VK_NULL_HANDLE);
     assert(m_presentQueue == VK_NULL_HANDLE);
     vkGetDeviceQueue(m_device, indices.graphicsFamily.value(), 0, &m_graphicsQueue);
     vkGetDeviceQueue(m_device, indices.presentFamily.value(), 0, &m_presentQueue);
+
+    VkSemaphoreTypeCreateInfo timelineCreateInfo{};
+    timelineCreateInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    timelineCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    timelineCreateInfo.initialValue  = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &timelineCreateInfo;
+
+    if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_timelineSemaphore) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+    m_timelineValue = 0;
+}
+
+uint64_t VulkanDeviceManager::CompletedTimelineValue() const
+{
+    uint64_t value = 0;
+    if (vkGetSemaphoreCounterValue(m_device, m_timelineSemaphore, &value) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to read timeline semaphore!");
+    }
+    return value;
+}
+
+void VulkanDeviceManager::WaitForTimelineValue(uint64_t value) const
+{
+    if (value == 0)
+    {
+        return;
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &m_timelineSemaphore;
+    waitInfo.pValues        = &value;
+
+    if (vkWaitSemaphores(m_device, &waitInfo, UINT64_MAX) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to wait for timeline semaphore!");
+    }
+}
+
+void VulkanDeviceManager::DeferDestruction(std::function<void()> destroy)
+{
+    DeferDestruction(std::move(destroy), m_timelineValue + 1);
+}
+
+void VulkanDeviceManager::DeferDestruction(std::function<void()> destroy, uint64_t timelineValue)
+{
+    // Values are almost always retired in increasing order, so the insertion point is at the back.
+    auto position = m_retiredResources.end();
+    while ((position != m_retiredResources.begin()) && (std::prev(position)->timelineValue > timelineValue))
+    {
+        --position;
+    }
+    m_retiredResources.insert(position, { timelineValue, std::move(destroy) });
+}
+
+void VulkanDeviceManager::DestroyRetiredResources()
+{
+    if (m_retiredResources.empty())
+    {
+        return;
+    }
+
+    uint64_t completedValue = CompletedTimelineValue();
+    while (!m_retiredResources.empty() && (m_retiredResources.front().timelineValue <= completedValue))
+    {
+        m_retiredResources.front().destroy();
+        m_retiredResources.pop_front();
+    }
 }
 
 void VulkanDeviceManager::DestroyLogicalDevice()
 {
     if (m_device != VK_NULL_HANDLE)
     {
+
+        if (m_timelineSemaphore != VK_NULL_HANDLE)
+        {
+            vkDestroySemaphore(m_device, m_timelineSemaphore, nullptr);
+            m_timelineSemaphore = VK_NULL_HANDLE;
+        }
+
         vkDestroyDevice(m_device, nullptr);
         m_device = VK_NULL_HANDLE;
     }
@@ -294,11 +526,17 @@ bool VulkanDeviceManager::CheckValidationLayerSupport(const std::vector<const ch
 
 std::vector<const char*> VulkanDeviceManager::GetRequiredExtensions()
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    // Without a window there is no surface, so GLFW is not initialized and no surface extension is needed.
+    if (!m_headless)
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (m_enableValidationLayers)
     {
@@ -332,7 +570,7 @@ void VulkanDeviceManager::CreateInstance()
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_3;
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -422,13 +660,24 @@ void VulkanDeviceManager::DestroyDebugUtilsMessengerEXT(VkInstance instance, VkD
 
 void VulkanDeviceManager::Destroy()
 {
+    ///@note The device is idle at this point, so nothing that was retired is in use anymore.
+    ///      Retired command buffers are freed here, before their pool goes away.
+    while (!m_retiredResources.empty())
+    {
+        m_retiredResources.front().destroy();
+        m_retiredResources.pop_front();
+    }
+
     DestroyCommandPool();
 
     DestroyLogicalDevice();
 
     DestroyDeviceExtensionNames();
 
-    glfwDestroyWindow(m_pSurfaceManager->Window());
+    if (m_pSurfaceManager->Window() != nullptr)
+    {
+        glfwDestroyWindow(m_pSurfaceManager->Window());
+    }
 
     delete m_pSurfaceManager;
     m_pSurfaceManager = nullptr;
@@ -440,7 +689,11 @@ void VulkanDeviceManager::Destroy()
     DestroyInstance();
 
     DestroyValidationLayerNames();
-    glfwTerminate();
+
+    if (!m_headless)
+    {
+        glfwTerminate();
+    }
 }
 
 VkImageView VulkanDeviceManager::CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags)
@@ -11,9 +11,14 @@ void VulkanSurfaceManager::InitWindow(int width, int height)
 
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
+    ///@note The application owns the window user pointer and the input callbacks.
     m_window = glfwCreateWindow(width, height, "Vulkan", nullptr, nullptr);
-    glfwSetWindowUserPointer(m_window, this);
-    //glfwSetFramebufferSizeCallback(m_window, framebufferResizeCallback);
+}
+
+void VulkanSurfaceManager::InitHeadless(int width, int height)
+{
+    m_headless       = true;
+    m_headlessExtent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
 }
 
 void VulkanSurfaceManager::CreateSurface()
@@ -79,13 +84,19 @@ VkSurfaceFormatKHR VulkanSurfaceManager::ChooseSwapSurfaceFormat(const std::vect
     return availableFormats[0];
 }
 
+void VulkanSurfaceManager::SetSwapChainPreferences(const std::vector<VkPresentModeKHR>& presentModes, uint32_t imageCount)
+{
+    m_preferredPresentModes = presentModes;
+    m_preferredImageCount   = imageCount;
+}
+
 VkPresentModeKHR VulkanSurfaceManager::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 {
-    for (const auto& availablePresentMode : availablePresentModes)
+    for (VkPresentModeKHR preferredPresentMode : m_preferredPresentModes)
     {
-        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
+        if (std::find(availablePresentModes.begin(), availablePresentModes.end(), preferredPresentMode) != availablePresentModes.end())
         {
-            return availablePresentMode;
+            return preferredPresentMode;
         }
     }
 
@@ -116,15 +127,79 @@ VkExtent2D VulkanSurfaceManager::ChooseSwapExtent(const VkSurfaceCapabilitiesKHR
     }
 }
 
+void VulkanSurfaceManager::CreateHeadlessImages()
+{
+    VkDevice device = m_pDeviceManager->Device();
+
+    // Nothing holds an image on screen, so the preferred count is one image per frame in flight.
+    uint32_t imageCount = (m_preferredImageCount > 0) ? m_preferredImageCount : 2;
+
+    m_swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    m_swapChainExtent      = m_headlessExtent;
+    m_swapChainImages.resize(imageCount);
+    m_headlessImageMemory.resize(imageCount);
+    m_swapChainImageViews.resize(imageCount);
+
+    for (uint32_t i = 0; i < imageCount; i++)
+    {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width  = m_swapChainExtent.width;
+        imageInfo.extent.height = m_swapChainExtent.height;
+        imageInfo.extent.depth  = 1;
+        imageInfo.mipLevels     = 1;
+        imageInfo.arrayLayers   = 1;
+        imageInfo.format        = m_swapChainImageFormat;
+        imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // The scene is blitted in as it is into a swap chain image, then copied out for readback.
+        imageInfo.usage         = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+
+        if (vkCreateImage(device, &imageInfo, nullptr, &m_swapChainImages[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create headless image!");
+        }
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, m_swapChainImages[i], &memRequirements);
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = memRequirements.size;
+        allocInfo.memoryTypeIndex = FindMemoryType(m_pDeviceManager->PhysicalDevice(), memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &m_headlessImageMemory[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate headless image memory!");
+        }
+
+        vkBindImageMemory(device, m_swapChainImages[i], m_headlessImageMemory[i], 0);
+
+        m_swapChainImageViews[i] = m_pDeviceManager->CreateImageView(m_swapChainImages[i], m_swapChainImageFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+}
+
 void VulkanSurfaceManager::CreateSwapChain()
 {
+    if (m_headless)
+    {
+        CreateHeadlessImages();
+        return;
+    }
+
     SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(m_pDeviceManager->PhysicalDevice());
 
     VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
     VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+    ///@note One image is on screen while the others are queued or rendered to, so the preferred count
+    ///      is usually the number of frames in flight plus one.
+    uint32_t imageCount = (m_preferredImageCount > 0) ? std::max(m_preferredImageCount, swapChainSupport.capabilities.minImageCount)
+                                                      : (swapChainSupport.capabilities.minImageCount + 1);
     if (swapChainSupport.capabilities.maxImageCount > 0 && imageCount > swapChainSupport.capabilities.maxImageCount)
     {
         imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -139,7 +214,13 @@ void VulkanSurfaceManager::CreateSwapChain()
     createInfo.imageColorSpace = surfaceFormat.colorSpace;
     createInfo.imageExtent = extent;
     createInfo.imageArrayLayers = 1;
-    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // The scene is blitted into the swap chain images, which frame capture copies out when it can.
+    createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    m_swapChainReadable   = (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) != 0;
+    if (m_swapChainReadable)
+    {
+        createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
 
     QueueFamilyIndices indices = m_pDeviceManager->FindQueueFamilies(m_pDeviceManager->PhysicalDevice());
     uint32_t queueFamilyIndices[] = { indices.graphicsFamily.value(), indices.presentFamily.value() };
@@ -160,14 +241,32 @@ void VulkanSurfaceManager::CreateSwapChain()
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
 
+    ///@note Handing over the current swap chain lets the presentation engine reuse its resources and keep
+    ///      showing its images until the new swap chain presents, so a resize does not stall or flicker.
+    createInfo.oldSwapchain = m_swapChain;
+
     VkDevice device = m_pDeviceManager->Device();
 
-    assert(m_swapChain == VK_NULL_HANDLE);
-    if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &m_swapChain) != VK_SUCCESS)
+    VkSwapchainKHR newSwapChain = VK_NULL_HANDLE;
+    if (vkCreateSwapchainKHR(device, &createInfo, nullptr, &newSwapChain) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create swap chain!");
     }
 
+    // The old swap chain is retired; frames that are still in flight may render to or present its images,
+    // so it is kept until MarkImageAcquired() releases it.
+    if (m_swapChain != VK_NULL_HANDLE)
+    {
+        RetiredSwapChain retired;
+        retired.swapChain         = m_swapChain;
+        retired.imageViews        = m_swapChainImageViews;
+        retired.presentSemaphores = m_retiredPresentSemaphores;
+        retired.acquiresLeft      = m_framesInFlight;
+        m_retiredSwapChains.push_back(std::move(retired));
+        m_retiredPresentSemaphores.clear();
+    }
+    m_swapChain = newSwapChain;
+
     // Image
     vkGetSwapchainImagesKHR(device, m_swapChain, &imageCount, nullptr);
     m_swapChainImages.resize(imageCount);
@@ -175,6 +274,7 @@ void VulkanSurfaceManager::CreateSwapChain()
 
     m_swapChainImageFormat = surfaceFormat.format;
     m_swapChainExtent = extent;
+    m_presentMode = presentMode;
 
     // Image view
     m_swapChainImageViews.resize(m_swapChainImages.size());
@@ -189,8 +289,77 @@ void VulkanSurfaceManager::DestroySwapChain()
 {
     VkDevice device = m_pDeviceManager->Device();
 
-    vkDestroySwapchainKHR(device, m_swapChain, nullptr);
-    m_swapChain = VK_NULL_HANDLE;
+    for (VkImageView imageView : m_swapChainImageViews)
+    {
+        vkDestroyImageView(device, imageView, nullptr);
+    }
+    m_swapChainImageViews.clear();
+
+    if (m_headless)
+    {
+        for (uint32_t i = 0; i < m_swapChainImages.size(); i++)
+        {
+            vkDestroyImage(device, m_swapChainImages[i], nullptr);
+            vkFreeMemory(device, m_headlessImageMemory[i], nullptr);
+        }
+        m_swapChainImages.clear();
+        m_headlessImageMemory.clear();
+    }
+    else
+    {
+        vkDestroySwapchainKHR(device, m_swapChain, nullptr);
+        m_swapChain = VK_NULL_HANDLE;
+    }
+
+    for (VkSemaphore semaphore : m_retiredPresentSemaphores)
+    {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+    m_retiredPresentSemaphores.clear();
+
+    ///@note Only called once the device is idle, so the replaced swap chains can go as well.
+    for (const RetiredSwapChain& retired : m_retiredSwapChains)
+    {
+        DestroyRetiredSwapChain(retired);
+    }
+    m_retiredSwapChains.clear();
+}
+
+void VulkanSurfaceManager::MarkImageAcquired()
+{
+    for (auto it = m_retiredSwapChains.begin(); it != m_retiredSwapChains.end();)
+    {
+        if (--it->acquiresLeft > 0)
+        {
+            ++it;
+            continue;
+        }
+
+        // The frame about to be submitted uses the last acquired image; the old one goes once it has completed.
+        m_pDeviceManager->DeferDestruction([this, retired = std::move(*it)]() { DestroyRetiredSwapChain(retired); });
+        it = m_retiredSwapChains.erase(it);
+    }
+}
+
+void VulkanSurfaceManager::DestroyRetiredSwapChain(const RetiredSwapChain& retired) const
+{
+    VkDevice device = m_pDeviceManager->Device();
+
+    for (VkImageView imageView : retired.imageViews)
+    {
+        vkDestroyImageView(device, imageView, nullptr);
+    }
+    vkDestroySwapchainKHR(device, retired.swapChain, nullptr);
+
+    for (VkSemaphore semaphore : retired.presentSemaphores)
+    {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+}
+
+void VulkanSurfaceManager::RetirePresentSemaphores(const std::vector<VkSemaphore>& semaphores)
+{
+    m_retiredPresentSemaphores.insert(m_retiredPresentSemaphores.end(), semaphores.begin(), semaphores.end());
 }
 
 void VulkanSurfaceManager::GetGlfwFrameBufferSize(int* pWidth, int* pHeight)
@@ -198,6 +367,13 @@ void VulkanSurfaceManager::GetGlfwFrameBufferSize(int* pWidth, int* pHeight)
     assert(pWidth != nullptr);
     assert(pHeight != nullptr);
 
+    if (m_headless)
+    {
+        *pWidth  = static_cast<int>(m_headlessExtent.width);
+        *pHeight = static_cast<int>(m_headlessExtent.height);
+        return;
+    }
+
     glfwGetFramebufferSize(m_window, pWidth, pHeight);
 
     while ((*pWidth) == 0 || (*pHeight == 0))
@@ -15,7 +15,11 @@
 #include <array>
 #include <fstream>
 #include <algorithm>
-#include <chrono>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
 
 #include "Types.h"
 #include "Utils.h"
@@ -52,6 +56,7 @@ enum EModel : unsigned int
     Rook   = 4,
     Pawn   = 5,
     Queen  = 6,
+    Board  = 7, // The quad the squares are drawn on, generated in LoadModel().
 };
 
 enum ETexture : unsigned int
@@ -64,6 +69,8 @@ enum EShader : unsigned int
 {
     Vert = 0,
     Frag = 1,
+    Hiz  = 2,
+    Cull = 3,
 };
 
 static inline std::string GetModelPaths(enum EModel index)
@@ -99,6 +106,8 @@ static inline std::string GetShaderPaths(enum EShader index)
     {
         "vert.spv",
         "frag.spv",
+        "hiz.spv",
+        "cull.spv",
     };
 
     return COMPILED_SHADER_ROOT + std::string(shaderFileNames[index]);
@@ -108,15 +117,79 @@ struct UniformBufferObject
 {
     alignas(16) glm::mat4 view;
     alignas(16) glm::mat4 proj;
+    alignas(16) glm::mat4 viewProj;
 };
 
-const int MAX_FRAMES_IN_FLIGHT = 2;
+///@note Upper bound of the bindless texture array; clamped to the device limits at runtime.
+const uint32_t MAX_BINDLESS_TEXTURES = 1024;
+const uint32_t MAX_OBJECTS           = 16384; // A full spectator wall has 34 objects per board, plus promotions.
+const uint32_t MAX_WALL_BOARDS       = 256;
+
+// Initial capacity of each per-frame descriptor allocator; it grows on demand.
+const uint32_t FRAME_DESCRIPTOR_SETS = 64;
+
+// Longest wait for events while nothing is drawn, so the usage stats in the title stay current.
+const double IDLE_WAIT_TIMEOUT = 1.0;
+
+// Format of the object id attachment used by GPU picking.
+const VkFormat ID_FORMAT = VK_FORMAT_R32_UINT;
+
+// The id attachment holds the object index + 1 in the bits below this one, and on the squares of a board
+// the square index + 1 from this bit up. Must match PICK_SQUARE_SHIFT in shader.frag.
+const uint32_t PICK_SQUARE_SHIFT = 24;
+static_assert(MAX_OBJECTS < (1u << PICK_SQUARE_SHIFT), "object ids must fit below the picked square");
+
+const float CAMERA_NEAR_PLANE = 0.1f;
+const float CAMERA_FAR_PLANE  = 10.0f;
+const float CAMERA_FOV        = 45.0f; // Vertical, in degrees.
+
+// The wall camera frames a sphere around the board that holds the pieces, their hops and the rows of
+// captured pieces beside it, so nothing a board draws leaves its tile.
+const glm::vec3 WALL_BOARD_CENTER = glm::vec3(0.0f, 0.15f, 0.0f);
+const float     WALL_BOARD_RADIUS = 2.0f;
+
+// Board layout in world units. The board is centered on the origin with its top face at y = 0,
+// white on the side of the camera.
+const float SQUARE_SIZE     = 0.25f;
+const float BOARD_THICKNESS = 0.1f;
+const float PIECE_SCALE     = 0.25f; // The king, the tallest piece, ends up twice this high.
+const float BOARD_BASE_GAP  = 0.002f; // Between the board quad and the top of the base, against z-fighting.
+
+// Degrees per second the board turns while the animation runs.
+const float TURNTABLE_SPEED = 20.0f;
+
+// Center of a square on the top face of the board; file and rank count from 0 at a1.
+static inline glm::vec3 SquareCenter(int file, int rank)
+{
+    return glm::vec3((file - 3.5f) * SQUARE_SIZE, 0.0f, (3.5f - rank) * SQUARE_SIZE);
+}
+
+// A move takes this many seconds plus the second term for every square it travels.
+const float MOVE_DURATION            = 0.3f;
+const float MOVE_DURATION_PER_SQUARE = 0.05f;
+
+// Height of the arc of a move above the straight path. Knights hop higher, over the pieces in between, and turn once on the way.
+const float MOVE_ARC_HEIGHT   = 0.1f;
+const float KNIGHT_HOP_HEIGHT = 0.3f;
+
+// Largest error, in pixels of the render resolution, a level of detail may show at a LOD bias of 0.
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// A coarser level is only picked once its error is this much below the limit, so objects near a threshold do not pop.
+const float LOD_HYSTERESIS = 0.25f;
 
 const std::vector<const char*> g_deviceExtensions =
 {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// Presentation feedback for frame pacing and latency measurement.
+const std::vector<const char*> g_optionalDeviceExtensions =
+{
+    VK_KHR_PRESENT_ID_EXTENSION_NAME,
+    VK_KHR_PRESENT_WAIT_EXTENSION_NAME
+};
+
 const std::vector<const char*> g_validationLayers =
 {
     "VK_LAYER_KHRONOS_validation"
@@ -133,26 +206,487 @@ WizardChess::~WizardChess()
 
 void WizardChess::run()
 {
-    InitVulkan();
+    Init();
     MainLoop();
-    Cleanup();
+    Shutdown();
+}
+
+void WizardChess::Init()
+{
+    ///@note Without the loader, the first Vulkan call of the delay loaded library would raise an exception
+    ///      that cannot be caught as a std::exception.
+    if (!m_softwareRendering && !VulkanLoaderAvailable())
+    {
+        std::cerr << "failed to load vulkan-1.dll! Falling back to software rendering." << std::endl;
+        m_softwareRendering = true;
+    }
+
+    if (!m_softwareRendering)
+    {
+        try
+        {
+            InitVulkan();
+            return;
+        }
+        catch (const std::exception& e)
+        {
+            ///@note Only machines without a usable device fall back; once the logical device exists, errors are bugs.
+            if ((g_pVk == nullptr) || (VK.Device() != VK_NULL_HANDLE))
+            {
+                throw;
+            }
+
+            std::cerr << e.what() << " Falling back to software rendering." << std::endl;
+            delete g_pVk;
+            g_pVk               = nullptr;
+            m_softwareRendering = true;
+        }
+    }
+
+    InitSoftware();
+}
+
+void WizardChess::Shutdown()
+{
+    if (m_softwareRendering)
+    {
+        CleanupSoftware();
+    }
+    else
+    {
+        Cleanup();
+    }
 }
 
 static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
     auto app = reinterpret_cast<WizardChess*>(glfwGetWindowUserPointer(window));
     app->SetFramebufferResized();
+    app->Invalidate();
+}
+
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    auto app = reinterpret_cast<WizardChess*>(glfwGetWindowUserPointer(window));
+    if ((key == GLFW_KEY_SPACE) && (action == GLFW_PRESS))
+    {
+        app->ToggleAnimation();
+    }
+    else if ((key == GLFW_KEY_LEFT_BRACKET) && (action != GLFW_RELEASE))
+    {
+        app->SetLodBias(app->LodBias() - 0.5f);
+    }
+    else if ((key == GLFW_KEY_RIGHT_BRACKET) && (action != GLFW_RELEASE))
+    {
+        app->SetLodBias(app->LodBias() + 0.5f);
+    }
+    app->Invalidate();
+}
+
+static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    auto app = reinterpret_cast<WizardChess*>(glfwGetWindowUserPointer(window));
+    if ((button == GLFW_MOUSE_BUTTON_LEFT) && (action == GLFW_PRESS))
+    {
+        double cursorX, cursorY;
+        glfwGetCursorPos(window, &cursorX, &cursorY);
+        app->Pick(cursorX, cursorY);
+    }
+    app->Invalidate();
+}
+
+static void scrollCallback(GLFWwindow* window, double xOffset, double yOffset)
+{
+    auto app = reinterpret_cast<WizardChess*>(glfwGetWindowUserPointer(window));
+    app->Invalidate();
+}
+
+static void windowRefreshCallback(GLFWwindow* window)
+{
+    // The window contents were damaged, e.g. by uncovering it.
+    auto app = reinterpret_cast<WizardChess*>(glfwGetWindowUserPointer(window));
+    app->Invalidate();
+}
+
+// Seconds between refreshes of the monitor that shows the largest part of the window; 60 Hz when unknown.
+static double DisplayRefreshInterval(GLFWwindow* window)
+{
+    int windowX, windowY, windowWidth, windowHeight;
+    glfwGetWindowPos(window, &windowX, &windowY);
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+    int           monitorCount = 0;
+    GLFWmonitor** monitors     = glfwGetMonitors(&monitorCount);
+    int           refreshRate  = 0;
+    int           bestOverlap  = -1;
+    for (int i = 0; i < monitorCount; i++)
+    {
+        const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
+        if (mode == nullptr)
+        {
+            continue;
+        }
+
+        int monitorX, monitorY;
+        glfwGetMonitorPos(monitors[i], &monitorX, &monitorY);
+        int overlapX = std::max(0, std::min(windowX + windowWidth, monitorX + mode->width) - std::max(windowX, monitorX));
+        int overlapY = std::max(0, std::min(windowY + windowHeight, monitorY + mode->height) - std::max(windowY, monitorY));
+        if (overlapX * overlapY > bestOverlap)
+        {
+            bestOverlap = overlapX * overlapY;
+            refreshRate = mode->refreshRate;
+        }
+    }
+
+    return 1.0 / ((refreshRate > 0) ? refreshRate : 60);
+}
+
+// Anything that changes what is on screen marks the frame dirty; the main loop sleeps otherwise.
+static void SetWindowCallbacks(GLFWwindow* window, WizardChess* app)
+{
+    glfwSetWindowUserPointer(window, app);
+    glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    glfwSetKeyCallback(window, keyCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    glfwSetScrollCallback(window, scrollCallback);
+    glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+}
+
+void WizardChess::Invalidate()
+{
+    m_frameDirty = true;
+
+    // Wake up the main loop if it is waiting for events; safe to call from any thread.
+    if (!m_headless)
+    {
+        glfwPostEmptyEvent();
+    }
+}
+
+void WizardChess::GetWindowSize(int* pWidth, int* pHeight) const
+{
+    if (m_headless && m_softwareRendering)
+    {
+        *pWidth  = m_width;
+        *pHeight = m_height;
+        return;
+    }
+
+    if (m_headless)
+    {
+        VkExtent2D extent = VK.SurfaceManager()->SwapChainExtent();
+        *pWidth  = static_cast<int>(extent.width);
+        *pHeight = static_cast<int>(extent.height);
+        return;
+    }
+
+    glfwGetWindowSize(Window(), pWidth, pHeight);
+}
+
+GLFWwindow* WizardChess::Window() const
+{
+    return m_softwareRendering ? m_softwareWindow : VK.SurfaceManager()->Window();
+}
+
+void WizardChess::ToggleAnimation()
+{
+    m_animating = !m_animating;
+}
+
+void WizardChess::Pick(double cursorX, double cursorY)
+{
+    // The boards of the wall all stand at the origin, seen through different tiles.
+    if (m_boards.size() > 1)
+    {
+        return;
+    }
+
+    double startTime = MonotonicTime();
+
+    if (m_gpuPicking)
+    {
+        // The next frame copies the id under the cursor; ResolvePickReadbacks() reads it when the frame has completed.
+        m_pickRequested = true;
+        m_pickCursorX   = cursorX;
+        m_pickCursorY   = cursorY;
+        m_pickStartTime = startTime;
+        return;
+    }
+
+    int windowWidth, windowHeight;
+    GetWindowSize(&windowWidth, &windowHeight);
+    if ((windowWidth == 0) || (windowHeight == 0))
+    {
+        return;
+    }
+
+    // Unproject the cursor onto the near and far planes. The projection flips y, so window and NDC y agree.
+    glm::vec2 ndc             = glm::vec2(2.0f * cursorX / windowWidth - 1.0f, 2.0f * cursorY / windowHeight - 1.0f);
+    glm::mat4 inverseViewProj = glm::inverse(m_projMatrix * m_viewMatrix);
+    glm::vec4 nearPoint       = inverseViewProj * glm::vec4(ndc, 0.0f, 1.0f);
+    glm::vec4 farPoint        = inverseViewProj * glm::vec4(ndc, 1.0f, 1.0f);
+    glm::vec3 origin          = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction       = glm::vec3(farPoint) / farPoint.w - origin;
+
+    // The objects move every frame, so the top level is rebuilt from their current world bounds.
+    // With one leaf per object this is far cheaper than refitting the mesh hierarchies.
+    std::vector<Aabb> objectBounds(m_objects.size());
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_objects.size()); i++)
+    {
+        const glm::mat4& world   = m_objectBuffer.WorldMatrix(i);
+        glm::vec3        center  = ObjectModel(i)->Center();
+        glm::vec3        extents = ObjectModel(i)->Extents();
+        for (int corner = 0; corner < 8; corner++)
+        {
+            glm::vec3 offset = glm::vec3((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            objectBounds[i].Grow(glm::vec3(world * glm::vec4(center + offset * extents, 1.0f)));
+        }
+    }
+    m_sceneBvh.Build(objectBounds);
+
+    // The ray is transformed into model space without normalizing it, so the hit distances of all objects compare.
+    BvhRay    ray(origin, direction);
+    float     tMax         = FLT_MAX;
+    glm::vec2 texCoord     = glm::vec2(0.0f);
+    uint32_t  pickedObject = UINT32_MAX;
+    m_sceneBvh.Traverse(ray, tMax, [&](uint32_t objectIndex, float& tClosest)
+    {
+        if (m_objects[objectIndex].hidden)
+        {
+            return false;
+        }
+
+        glm::mat4 worldToModel = glm::inverse(m_objectBuffer.WorldMatrix(objectIndex));
+        BvhRay    modelRay(glm::vec3(worldToModel * glm::vec4(origin, 1.0f)), glm::vec3(worldToModel * glm::vec4(direction, 0.0f)));
+        if (!ObjectModel(objectIndex)->Intersect(modelRay, tClosest, texCoord))
+        {
+            return false;
+        }
+        pickedObject = objectIndex;
+        return true;
+    });
+
+    m_pickedObject = pickedObject;
+    m_pickedSquare = -1;
+    if ((pickedObject != UINT32_MAX) && (m_objects[pickedObject].model == EModel::Board))
+    {
+        // The texture coordinate of the board quad is the position in squares; the border is outside 0 to 8.
+        int file = static_cast<int>(std::floor(texCoord.x));
+        int rank = static_cast<int>(std::floor(texCoord.y));
+        if ((file >= 0) && (file < 8) && (rank >= 0) && (rank < 8))
+        {
+            m_pickedSquare = rank * 8 + file;
+        }
+    }
+
+    m_pickTime = MonotonicTime() - startTime;
+    HandlePick();
+}
+
+void WizardChess::HandlePick()
+{
+    // Picking a piece stands for picking its square.
+    if ((m_pickedObject != UINT32_MAX) && (m_objects[m_pickedObject].square >= 0))
+    {
+        m_pickedSquare = m_objects[m_pickedObject].square;
+    }
+
+    if (m_pickedSquare < 0)
+    {
+        uint32_t deselectedBoard = (m_selectedPiece != UINT32_MAX) ? m_objects[m_selectedPiece].board : 0;
+        m_selectedPiece = UINT32_MAX;
+        UpdateBoardSquares(deselectedBoard);
+        return;
+    }
+
+    // Move the selected piece to an empty square or onto a piece of the other side; otherwise toggle the selection.
+    ///@note The moves are not checked against the rules.
+    uint32_t board  = m_objects[m_pickedObject].board;
+    uint32_t target = m_boards[board].squareObjects[m_pickedSquare];
+    if ((m_selectedPiece != UINT32_MAX) && ((target == UINT32_MAX) || (m_objects[target].black != m_objects[m_selectedPiece].black)))
+    {
+        MovePiece(m_selectedPiece, m_pickedSquare);
+        m_selectedPiece = UINT32_MAX;
+    }
+    else
+    {
+        m_selectedPiece = (target == m_selectedPiece) ? UINT32_MAX : target;
+    }
+    UpdateBoardSquares(board);
+}
+
+uint64_t WizardChess::AttackedSquares(uint32_t objectIndex) const
+{
+    static const int steps[8][2] =
+    {
+        { 1, 0 }, { 0, 1 }, { -1, 0 }, { 0, -1 },  // Orthogonal.
+        { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } // Diagonal.
+    };
+    static const int knightSteps[8][2] =
+    {
+        { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 }
+    };
+
+    const SceneObject& piece   = m_objects[objectIndex];
+    int                forward = piece.black ? -1 : 1;
+    const int          pawnSteps[2][2] = { { -1, forward }, { 1, forward } };
+
+    // Steps of the piece and whether it repeats them until it is blocked.
+    const int (*pieceSteps)[2] = steps;
+    int        stepCount       = 8;
+    bool       slides          = false;
+    switch (piece.model)
+    {
+    case EModel::Pawn:   pieceSteps = pawnSteps;   stepCount = 2; break;
+    case EModel::Knight: pieceSteps = knightSteps; break;
+    case EModel::Bishop: pieceSteps = steps + 4;   stepCount = 4; slides = true; break;
+    case EModel::Rook:   stepCount  = 4;           slides    = true; break;
+    case EModel::Queen:  slides     = true;        break;
+    default:             break;
+    }
+
+    ///@note Squares of the piece's own side and check are ignored; this marks where it could capture.
+    uint64_t attacked = 0;
+    for (int step = 0; step < stepCount; step++)
+    {
+        int file = piece.square % 8;
+        int rank = piece.square / 8;
+        for (;;)
+        {
+            file += pieceSteps[step][0];
+            rank += pieceSteps[step][1];
+            if ((file < 0) || (file >= 8) || (rank < 0) || (rank >= 8))
+            {
+                break;
+            }
+
+            uint32_t occupant = m_boards[piece.board].squareObjects[rank * 8 + file];
+            if ((occupant == UINT32_MAX) || (m_objects[occupant].black != piece.black))
+            {
+                attacked |= uint64_t(1) << (rank * 8 + file);
+            }
+            if (!slides || (occupant != UINT32_MAX))
+            {
+                break;
+            }
+        }
+    }
+    return attacked;
+}
+
+void WizardChess::UpdateBoardSquares(uint32_t board)
+{
+    const BoardState& state          = m_boards[board];
+    uint64_t          attacked       = 0;
+    int               selectedSquare = -1;
+    if ((m_selectedPiece != UINT32_MAX) && (m_objects[m_selectedPiece].board == board))
+    {
+        attacked       = AttackedSquares(m_selectedPiece);
+        selectedSquare = m_objects[m_selectedPiece].square;
+    }
+
+    // Only the entries that change are written to the buffers.
+    for (int square = 0; square < static_cast<int>(BOARD_SQUARES); square++)
+    {
+        uint32_t flags = 0;
+        flags |= (square == selectedSquare) ? ESquareFlag::SquareSelected : 0;
+        flags |= ((attacked >> square) & 1) ? ESquareFlag::SquareAttacked : 0;
+        flags |= ((square == state.lastMoveFrom) || (square == state.lastMoveTo)) ? ESquareFlag::SquareLastMove : 0;
+        m_boardBuffer.SetSquare(board, square, flags);
+    }
+}
+
+void WizardChess::MovePiece(uint32_t objectIndex, int square)
+{
+    double now = AnimationClock();
+
+    // Start from wherever the piece is, which is mid-air if it is still moving, and take the shorter way round
+    // to the yaw of its side, plus the given number of full turns.
+    auto animate = [&](const SceneObject& piece, const glm::vec3& to, float arcHeight, float turns)
+    {
+        glm::vec3 from     = m_transforms.Position(piece.transform);
+        glm::quat rotation = m_transforms.Rotation(piece.transform);
+        float     fromYaw  = 2.0f * std::atan2(rotation.y, rotation.w);
+        float     sideYaw  = piece.black ? glm::radians(180.0f) : 0.0f;
+        float     toYaw    = fromYaw + std::remainder(sideYaw - fromYaw, glm::radians(360.0f)) + turns * glm::radians(360.0f);
+        float     squares  = glm::length(glm::vec2(to.x - from.x, to.z - from.z)) / SQUARE_SIZE;
+        m_animations.Play(piece.transform, from, fromYaw, to, toYaw, arcHeight, now, MOVE_DURATION + MOVE_DURATION_PER_SQUARE * squares);
+    };
+
+    SceneObject& piece = m_objects[objectIndex];
+    BoardState&  board = m_boards[piece.board];
+
+    // A captured piece goes to the next place in the rows of its side beside the board.
+    uint32_t capturedIndex = board.squareObjects[square];
+    if (capturedIndex != UINT32_MAX)
+    {
+        SceneObject& captured = m_objects[capturedIndex];
+        uint32_t     slot     = board.capturedCounts[captured.black ? 1 : 0]++;
+        float        side     = captured.black ? -1.0f : 1.0f;
+        glm::vec3    place    = glm::vec3(side * (4.75f + (slot / 8)) * SQUARE_SIZE, PieceHalfHeight(captured.model), side * (3.5f - (slot % 8)) * SQUARE_SIZE);
+        animate(captured, place, MOVE_ARC_HEIGHT, 0.0f);
+        captured.square = -1;
+    }
+
+    board.lastMoveFrom                = piece.square;
+    board.lastMoveTo                  = square;
+    board.squareObjects[piece.square] = UINT32_MAX;
+    board.squareObjects[square]       = objectIndex;
+    piece.square                      = square;
+
+    bool knight = (piece.model == EModel::Knight);
+    animate(piece, SquareCenter(square % 8, square / 8) + glm::vec3(0.0f, PieceHalfHeight(piece.model), 0.0f),
+            knight ? KNIGHT_HOP_HEIGHT : MOVE_ARC_HEIGHT, knight ? 1.0f : 0.0f);
+}
+
+void WizardChess::ResolvePickReadbacks()
+{
+    uint64_t completedValue = VK.CompletedTimelineValue();
+    for (uint32_t frame = 0; frame < static_cast<uint32_t>(m_pickReadbackPending.size()); frame++)
+    {
+        if (!m_pickReadbackPending[frame] || (m_frameTimelineValues[frame] > completedValue))
+        {
+            continue;
+        }
+
+        uint32_t pickId   = *static_cast<const uint32_t*>(m_pickReadbackBuffersMapped[frame]);
+        uint32_t objectId = pickId & ((1u << PICK_SQUARE_SHIFT) - 1);
+        m_pickedObject    = (objectId != 0) ? (objectId - 1) : UINT32_MAX;
+        m_pickedSquare    = static_cast<int>(pickId >> PICK_SQUARE_SHIFT) - 1; // -1 off the squares.
+        m_pickTime        = MonotonicTime() - m_pickStartTime;
+
+        m_pickReadbackPending[frame] = false;
+        HandlePick();
+    }
+}
+
+bool WizardChess::NeedsRedraw() const
+{
+    // A pick needs a frame to copy the id, and frames to run until the copy has completed.
+    bool picking = m_pickRequested || (std::find(m_pickReadbackPending.begin(), m_pickReadbackPending.end(), true) != m_pickReadbackPending.end());
+    // A captured video needs a frame for every refresh, even when nothing moves.
+    return m_frameDirty || m_animating || picking || m_animations.Active() || m_frameCapture.Active();
 }
 
 void WizardChess::InitVulkan()
 {
     // Create a VulkanDeviceManager object to manage Vulkan-specific operations.
     g_pVk = new VulkanDeviceManager();
+    VK.SetHeadless(m_headless);
 
-    ///@note GLFW needs to be initialized before creating the Vulkan instance.
-    ///      This ensures GLFW performs its internal setups, including platform-specific windowing
-    ///      and registering Vulkan extensions required for rendering.
-    VK.CreateGlfwWindow(m_width, m_height);
+    if (m_headless)
+    {
+        // Offscreen images of the window size stand in for the swap chain; there is no window or surface.
+        VK.CreateHeadlessTarget(m_width, m_height);
+    }
+    else
+    {
+        ///@note GLFW needs to be initialized before creating the Vulkan instance.
+        ///      This ensures GLFW performs its internal setups, including platform-specific windowing
+        ///      and registering Vulkan extensions required for rendering.
+        VK.CreateGlfwWindow(m_width, m_height);
+        SetWindowCallbacks(VK.SurfaceManager()->Window(), this);
+    }
 
     // Enable validation layers for debugging and error checking (if enabled).
     // This registers the list of validation layers that will be used.
@@ -163,10 +697,15 @@ void WizardChess::InitVulkan()
 
     ///@note The surface must be created before selecting a physical device.
     ///      This ensures the selected device supports the swap chain, which is essential for rendering.
-    VK.CreateSurface();
+    if (!m_headless)
+    {
+        VK.CreateSurface();
+    }
 
     // Enable device extensions (e.g., swap chain support) before picking the physical device.
-    VK.EnableDeviceExtensions(&g_deviceExtensions);
+    // Headless rendering presents nothing, so it needs none of them.
+    VK.EnableDeviceExtensions(m_headless ? nullptr : &g_deviceExtensions);
+    VK.EnableOptionalDeviceExtensions(m_headless ? nullptr : &g_optionalDeviceExtensions);
 
     // Select an appropriate physical device (GPU) that meets the application's requirements.
     VK.PickPhysicalDevice();
@@ -175,35 +714,60 @@ void WizardChess::InitVulkan()
     VK.CreateLogicalDevice();
 
     // Set up the swap chain, which handles the presentation of rendered images to the window.
+    // The present mode and image count follow the latency profile. Headless, no image is held on screen,
+    // so one image per frame in flight is enough.
+    const LatencyProfileSettings& profile = GetLatencyProfileSettings(m_latencyProfile);
+    m_framePacer.Init(profile.framePacing);
+    VK.SurfaceManager()->SetSwapChainPreferences(profile.presentModes, m_headless ? m_framesInFlight : (m_framesInFlight + 1));
+    VK.SurfaceManager()->SetFramesInFlight(m_framesInFlight);
     VK.CreateSwapChain();
 
+    // The render resolution keeps the GPU time within a refresh of the display.
+    if (!m_headless)
+    {
+        m_refreshInterval = DisplayRefreshInterval(VK.SurfaceManager()->Window());
+    }
+
     // Create a command pool, which manages the memory for command buffers.
     VK.CreateCommandPool();
 
     // Allocate command buffers from the command pool for recording rendering commands.
-    m_commandBuffers.resize(MAX_FRAMES_IN_FLIGHT); // Resize to match the number of frames in flight.
+    m_commandBuffers.resize(m_framesInFlight); // Resize to match the number of frames in flight.
     VK.CreateCommandBuffers(m_commandBuffers.data(), m_commandBuffers.size());
 
-    // Create the render pass, defining how rendering operations interact with framebuffers.
-    CreateRenderPass();
+    // Create the GPU timers that drive the render resolution.
+    m_dynamicResolution.Init(m_framesInFlight);
 
     // Set up the descriptor set layout, which specifies how shaders access resources like uniforms and textures.
     CreateDescriptorSetLayout();
 
-    // Create the graphics pipeline, which configures shaders, input assembly, viewport, and other rendering states.
+    // Start the worker threads used for background work such as pipeline compilation.
+    m_threadPool.Start(ThreadPool::DefaultThreadCount());
+
+    // Create the graphics pipelines, which configure shaders, input assembly, viewport, and other rendering states.
     CreateGraphicsPipeline();
 
+    // Create the occlusion culling passes when the device can draw them indirectly.
+    ///@note The boards of a wall never cover each other and the pieces of a board hardly do, so the wall
+    ///      would only pay for the culling passes.
+    m_boardCount       = std::clamp(m_boardCount, 1u, MAX_WALL_BOARDS);
+    m_occlusionCulling = OcclusionCuller::IsSupported() && (m_boardCount == 1);
+    if (m_occlusionCulling)
+    {
+        m_occlusionCuller.Init(m_framesInFlight, MAX_OBJECTS, ReadFile(GetShaderPaths(EShader::Hiz)), ReadFile(GetShaderPaths(EShader::Cull)));
+    }
+
     // Create resources for depth buffering, allowing proper handling of 3D object occlusion.
+    ///@note Rendering uses dynamic rendering, so the attachments are bound when the command buffer
+    ///      is recorded and there are no render pass or framebuffer objects to create here.
+    CreateColorResources();
+    CreateIdResources();
     CreateDepthResources();
 
-    // Create framebuffers, which represent the render targets for each swap chain image.
-    CreateFramebuffers();
-
-    // Load and create a texture image from file.
-    CreateTextureImage();
-
-    // Create a Vulkan image view for the texture, allowing shaders to sample it.
-    CreateTextureImageView();
+    // Load the texture images from file. Each texture takes the next slot of the bindless texture array,
+    // so the slots match the ETexture values.
+    CreateTextureImage(GetTexturePaths(ETexture::ChessBoardWood));
+    CreateTextureImage(GetTexturePaths(ETexture::Oak));
 
     // Create a sampler for the texture, which defines how the texture is sampled in shaders.
     CreateTextureSampler();
@@ -214,71 +778,302 @@ void WizardChess::InitVulkan()
     // Create uniform buffers to hold per-frame data like transformation matrices.
     CreateUniformBuffers();
 
-    // Create a descriptor pool, which allocates resources for descriptor sets.
-    CreateDescriptorPool();
+    if (m_gpuPicking)
+    {
+        CreatePickReadbackBuffers();
+    }
+
+    // Create storage buffers holding the per-object data (world matrices, texture indices) read by the shaders.
+    m_objectBuffer.Create(m_framesInFlight, MAX_OBJECTS);
+    m_boardBuffer.Create(m_framesInFlight, m_boardCount);
+    LayOutWall();
+
+    // Create the descriptor allocators: one for the persistent sets and one per frame in flight for transient sets.
+    CreateDescriptorAllocators();
 
     // Allocate and configure descriptor sets, which link shaders to resources like textures and buffers.
     CreateDescriptorSets();
 
-    // Create synchronization objects (semaphores and fences) to manage rendering and presentation.
+    // Create synchronization objects (acquire and present semaphores) to manage rendering and presentation.
     CreateSyncObjects();
-}
 
+    m_statsStartTime      = MonotonicTime();
+    m_statsCpuTime        = ProcessCpuTime();
+    m_lastAnimationUpdate = m_statsStartTime;
 
-void WizardChess::MainLoop()
-{
-    while (!glfwWindowShouldClose(VK.SurfaceManager()->Window()))
+    // Headless frames are not redrawn once the background pipelines are ready, so wait for them up front.
+    if (m_headless)
     {
-        glfwPollEvents();
-        DrawFrame();
+        m_threadPool.WaitIdle();
     }
 
-    vkDeviceWaitIdle(VK.Device());
+    if (!m_capturePath.empty())
+    {
+        VulkanSurfaceManager* pSurfaceManager = VK.SurfaceManager();
+        if (!pSurfaceManager->SwapChainReadable())
+        {
+            throw std::runtime_error("failed to capture frames, the swap chain images cannot be copied!");
+        }
+
+        VkFormat imageFormat = pSurfaceManager->SwapChainImageFormat();
+        bool     bgra        = (imageFormat == VK_FORMAT_B8G8R8A8_SRGB) || (imageFormat == VK_FORMAT_B8G8R8A8_UNORM);
+        m_frameCapture.Start(m_capturePath, m_captureFormat, pSurfaceManager->SwapChainExtent(), bgra, m_captureFrameRate);
+        m_captureTime = m_lastAnimationUpdate;
+    }
 }
 
-void WizardChess::CleanupSwapChain()
+void WizardChess::InitSoftware()
 {
-    VkDevice device = VK.Device();
-    vkDestroyImageView(device, m_depthImageView, nullptr);
-    vkDestroyImage(device, m_depthImage, nullptr);
-    vkFreeMemory(device, m_depthImageMemory, nullptr);
+    ///@note The capture reads the swap chain images, which only exist with Vulkan.
+    if (!m_capturePath.empty())
+    {
+        throw std::runtime_error("failed to capture frames, software rendering has no swap chain!");
+    }
 
-    for (auto framebuffer : m_swapChainFramebuffers)
+    if (!m_headless)
     {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
+        // The frames are drawn with glDrawPixels, which every OpenGL driver has since version 1.0.
+        if (glfwInit() != GLFW_TRUE)
+        {
+            throw std::runtime_error("failed to initialize GLFW!");
+        }
+
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+        m_softwareWindow = glfwCreateWindow(m_width, m_height, "Software", nullptr, nullptr);
+        if (m_softwareWindow == nullptr)
+        {
+            glfwTerminate();
+            throw std::runtime_error("failed to create window!");
+        }
+
+        glfwMakeContextCurrent(m_softwareWindow);
+        glfwSwapInterval(1);
+        SetWindowCallbacks(m_softwareWindow, this);
     }
 
-    auto swapChainImageViews = VK.SurfaceManager()->SwapChainImageViews();
-    for (auto imageView : swapChainImageViews)
+    // There is no id image to pick with, so picks always use ray casts.
+    m_gpuPicking = false;
+    m_boardCount = std::clamp(m_boardCount, 1u, MAX_WALL_BOARDS);
+
+    // The worker threads set up and rasterize the tiles of every frame.
+    m_threadPool.Start(ThreadPool::DefaultThreadCount());
+    m_softwareRasterizer.Init(&m_threadPool);
+
+    // Like the bindless texture array, the textures are added in ETexture order.
+    for (ETexture texture : { ETexture::ChessBoardWood, ETexture::Oak })
     {
-        vkDestroyImageView(device, imageView, nullptr);
+        int      texWidth, texHeight, texChannels;
+        stbi_uc* pixels = stbi_load(GetTexturePaths(texture).c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+        if (!pixels)
+        {
+            throw std::runtime_error("failed to load texture image!");
+        }
+
+        m_softwareRasterizer.AddTexture(static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), pixels);
+        stbi_image_free(pixels);
     }
 
-    VK.SurfaceManager()->DestroySwapChain();
+    LoadModel();
+
+    // The rasterizer reads the CPU copies of the object and board data, so no buffers are created.
+    m_objectBuffer.Create(0, MAX_OBJECTS);
+    m_boardBuffer.Create(0, m_boardCount);
+    LayOutWall();
+
+    m_statsStartTime      = MonotonicTime();
+    m_statsCpuTime        = ProcessCpuTime();
+    m_lastAnimationUpdate = m_statsStartTime;
 }
 
-void WizardChess::Cleanup()
+
+void WizardChess::MainLoop()
 {
-    CleanupSwapChain();
+    RunMainLoop(std::numeric_limits<double>::infinity());
+}
 
-    VkDevice device = VK.Device();
-    vkDestroyPipeline(device, m_graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
-    vkDestroyRenderPass(device, m_renderPass, nullptr);
+WizardChess::UsageReport WizardChess::MeasureUsage(double seconds, bool animating)
+{
+    assert(!m_headless);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    if (m_animating != animating)
     {
-        vkDestroyBuffer(device, m_uniformBuffers[i], nullptr);
-        vkFreeMemory(device, m_uniformBuffersMemory[i], nullptr);
+        ToggleAnimation();
     }
 
-    vkDestroyDescriptorPool(device, m_descriptorPool, nullptr);
+    double   startTime   = MonotonicTime();
+    double   startCpu    = ProcessCpuTime();
+    double   startGpu    = m_softwareRendering ? 0.0 : m_dynamicResolution.TotalGpuTime();
+    uint64_t startFrames = m_drawnFrames;
 
-    vkDestroySampler(device, m_textureSampler, nullptr);
-    vkDestroyImageView(device, m_textureImageView, nullptr);
+    RunMainLoop(startTime + seconds);
 
-    vkDestroyImage(device, m_textureImage, nullptr);
-    vkFreeMemory(device, m_textureImageMemory, nullptr);
+    UsageReport usage;
+    double      elapsed = std::max(MonotonicTime() - startTime, 1e-9);
+    usage.frameRate     = (m_drawnFrames - startFrames) / elapsed;
+    usage.cpuUsage      = (ProcessCpuTime() - startCpu) / elapsed * 100.0;
+    if (!m_softwareRendering && m_dynamicResolution.HasGpuTime())
+    {
+        usage.gpuUsage = (m_dynamicResolution.TotalGpuTime() - startGpu) / elapsed * 100.0;
+    }
+    return usage;
+}
+
+void WizardChess::RunMainLoop(double endTime)
+{
+    double animationInterval = GetLatencyProfileSettings(m_latencyProfile).animationInterval;
+    double captureInterval   = 1.0 / m_captureFrameRate;
+    double lastFrameTime     = 0.0;
+    double nextCaptureTime   = 0.0;
+
+    while (!glfwWindowShouldClose(Window()) && (MonotonicTime() < endTime))
+    {
+        UpdateFrameStats();
+        if (!m_softwareRendering)
+        {
+            ResolvePickReadbacks();
+        }
+
+        if (!NeedsRedraw())
+        {
+            // A static board looks the same every frame, so sleep until something changes it.
+            // The gap is not a missed presentation for the frame pacer.
+            m_framePacer.Reset();
+            glfwWaitEventsTimeout(std::clamp(endTime - MonotonicTime(), 0.0, IDLE_WAIT_TIMEOUT));
+            continue;
+        }
+
+        if (m_frameCapture.Active())
+        {
+            // Every frame is a frame of the video, so they are spaced by the capture rate even when
+            // something asks for a redraw right away.
+            double now = MonotonicTime();
+            if (now < nextCaptureTime)
+            {
+                glfwWaitEventsTimeout(nextCaptureTime - now);
+                continue;
+            }
+
+            // A frame that is late by more than a whole interval restarts the schedule instead of
+            // being followed by a burst of frames that catch up.
+            nextCaptureTime += captureInterval;
+            if (nextCaptureTime < now)
+            {
+                nextCaptureTime = now + captureInterval;
+            }
+        }
+        else
+        {
+            // Capped animations wait for their next step, unless something else needs a redraw right away.
+            double nextAnimationTime = lastFrameTime + animationInterval;
+            if (!m_frameDirty && (MonotonicTime() < nextAnimationTime))
+            {
+                glfwWaitEventsTimeout(nextAnimationTime - MonotonicTime());
+                continue;
+            }
+        }
+
+        ///@note DrawFrame polls events itself, after the frame pacing and timeline waits.
+        lastFrameTime = MonotonicTime();
+        if (m_softwareRendering)
+        {
+            DrawSoftwareFrame();
+        }
+        else
+        {
+            DrawFrame();
+        }
+    }
+}
+
+void WizardChess::RetireSwapChainResources()
+{
+    ///@note Frames in flight may still render to the targets, so they are destroyed once the GPU has moved
+    ///      past them instead of waiting for the device here. Presents may still wait on the semaphores,
+    ///      which the timeline does not cover, so those stay with the swap chain they were presented to.
+    if (m_occlusionCulling)
+    {
+        m_occlusionCuller.DestroyDepthPyramid();
+    }
+
+    VK.DeferDestruction([colorImageView = m_colorImageView, colorImage = m_colorImage, colorImageMemory = m_colorImageMemory,
+                         idImageView = m_idImageView, idImage = m_idImage, idImageMemory = m_idImageMemory,
+                         depthImageView = m_depthImageView, depthImage = m_depthImage, depthImageMemory = m_depthImageMemory]()
+    {
+        VkDevice device = VK.Device();
+
+        vkDestroyImageView(device, depthImageView, nullptr);
+        vkDestroyImage(device, depthImage, nullptr);
+        vkFreeMemory(device, depthImageMemory, nullptr);
+
+        vkDestroyImageView(device, idImageView, nullptr);
+        vkDestroyImage(device, idImage, nullptr);
+        vkFreeMemory(device, idImageMemory, nullptr);
+
+        vkDestroyImageView(device, colorImageView, nullptr);
+        vkDestroyImage(device, colorImage, nullptr);
+        vkFreeMemory(device, colorImageMemory, nullptr);
+    });
+
+    VK.SurfaceManager()->RetirePresentSemaphores(m_renderFinishedSemaphores);
+    m_renderFinishedSemaphores.clear();
+}
+
+void WizardChess::Cleanup()
+{
+    ///@note Shutting down is the only place that waits for the whole device; resources released while
+    ///      running go through the retire queue instead.
+    vkDeviceWaitIdle(VK.Device());
+
+    m_frameCapture.Stop();
+    RetireSwapChainResources();
+    VK.SurfaceManager()->DestroySwapChain();
+
+    VkDevice device = VK.Device();
+    m_pipelineManager.Destroy();
+    m_threadPool.Stop();
+    vkDestroyPipelineLayout(device, m_pipelineLayout, nullptr);
+
+    for (size_t i = 0; i < m_framesInFlight; i++)
+    {
+        vkDestroyBuffer(device, m_uniformBuffers[i], nullptr);
+        vkFreeMemory(device, m_uniformBuffersMemory[i], nullptr);
+    }
+    for (size_t i = 0; i < m_pickReadbackBuffers.size(); i++)
+    {
+        vkDestroyBuffer(device, m_pickReadbackBuffers[i], nullptr);
+        vkFreeMemory(device, m_pickReadbackBuffersMemory[i], nullptr);
+    }
+    m_readbackRing.Destroy();
+    if (m_headlessReadbackBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(device, m_headlessReadbackBuffer, nullptr);
+        vkFreeMemory(device, m_headlessReadbackMemory, nullptr);
+    }
+    m_objectBuffer.Destroy();
+    m_boardBuffer.Destroy();
+    m_dynamicResolution.Destroy();
+
+    if (m_occlusionCulling)
+    {
+        m_occlusionCuller.Destroy();
+    }
+
+    m_globalDescriptorAllocator.Destroy();
+    for (DescriptorAllocator& allocator : m_frameDescriptorAllocators)
+    {
+        allocator.Destroy();
+    }
+    m_frameDescriptorAllocators.clear();
+
+    vkDestroySampler(device, m_textureSampler, nullptr);
+
+    for (Texture& texture : m_textures)
+    {
+        vkDestroyImageView(device, texture.imageView, nullptr);
+        vkDestroyImage(device, texture.image, nullptr);
+        vkFreeMemory(device, texture.imageMemory, nullptr);
+    }
+    m_textures.clear();
 
     vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, nullptr);
 
@@ -288,12 +1083,33 @@ void WizardChess::Cleanup()
         pModel = nullptr;
     }
     m_models.clear();
+    m_objects.clear();
+    m_transforms.Clear();
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (size_t i = 0; i < m_framesInFlight; i++)
     {
-        vkDestroySemaphore(device, m_renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, m_imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device, m_inFlightFences[i], nullptr);
+    }
+}
+
+void WizardChess::CleanupSoftware()
+{
+    m_threadPool.Stop();
+
+    for (Model*& pModel : m_models)
+    {
+        delete pModel;
+        pModel = nullptr;
+    }
+    m_models.clear();
+    m_objects.clear();
+    m_transforms.Clear();
+
+    if (m_softwareWindow != nullptr)
+    {
+        glfwDestroyWindow(m_softwareWindow);
+        m_softwareWindow = nullptr;
+        glfwTerminate();
     }
 }
 
@@ -302,77 +1118,43 @@ void WizardChess::RecreateSwapChain()
     int width = 0, height = 0;
     VK.SurfaceManager()->GetGlfwFrameBufferSize(&width, &height);
 
-    vkDeviceWaitIdle(VK.Device());
+    // The window may have moved to another monitor.
+    m_refreshInterval = DisplayRefreshInterval(VK.SurfaceManager()->Window());
 
-    CleanupSwapChain();
+    // Nothing waits for the GPU here: the old swap chain is handed to the new one and everything
+    // that depends on its size is destroyed once the frames using it have completed.
+    RetireSwapChainResources();
+    m_framePacer.Reset();
 
+    ///@note Only the swap chain images and the color, id and depth targets depend on the window size.
+    ///      The pipeline stays valid because the attachment formats do not change.
     VK.CreateSwapChain();
+    CreateRenderFinishedSemaphores();
+    CreateColorResources();
+    CreateIdResources();
     CreateDepthResources();
-    CreateFramebuffers();
-}
-
-void WizardChess::CreateRenderPass()
-{
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format          = VK.SurfaceManager()->SwapChainImageFormat();
-    colorAttachment.samples         = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp          = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp         = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format          = FindDepthFormat();
-    depthAttachment.samples         = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp          = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp         = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.stencilLoadOp   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout   = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment   = 0;
-    colorAttachmentRef.layout       = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment   = 1;
-    depthAttachmentRef.layout       = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint       = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount    = 1;
-    subpass.pColorAttachments       = &colorAttachmentRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass           = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass           = 0;
-    dependency.srcStageMask         = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask        = 0;
-    dependency.dstStageMask         = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask        = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
-    std::array<VkAttachmentDescription, 2> attachments = { colorAttachment, depthAttachment };
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType            = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount  = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments     = attachments.data();
-    renderPassInfo.subpassCount     = 1;
-    renderPassInfo.pSubpasses       = &subpass;
-    renderPassInfo.dependencyCount  = 1;
-    renderPassInfo.pDependencies    = &dependency;
-
-    if (vkCreateRenderPass(VK.Device(), &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS)
-    {
-        throw std::runtime_error("failed to create render pass!");
-    }
+
+    // Nothing has been drawn into the new swap chain yet.
+    m_frameDirty = true;
 }
 
 void WizardChess::CreateDescriptorSetLayout()
 {
+    // Clamp the bindless texture array to what the device can keep in a single update-after-bind set.
+    VkPhysicalDeviceVulkan12Properties properties12{};
+    properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties.pNext = &properties12;
+    vkGetPhysicalDeviceProperties2(VK.PhysicalDevice(), &properties);
+
+    m_maxBindlessTextures = std::min({ MAX_BINDLESS_TEXTURES,
+                                       properties12.maxDescriptorSetUpdateAfterBindSampledImages,
+                                       properties12.maxDescriptorSetUpdateAfterBindSamplers,
+                                       properties12.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                       properties12.maxPerStageDescriptorUpdateAfterBindSamplers });
+
     VkDescriptorSetLayoutBinding uboLayoutBinding{};
     uboLayoutBinding.binding                = 0;
     uboLayoutBinding.descriptorCount        = 1;
@@ -382,14 +1164,46 @@ void WizardChess::CreateDescriptorSetLayout()
 
     VkDescriptorSetLayoutBinding samplerLayoutBinding{};
     samplerLayoutBinding.binding            = 1;
-    samplerLayoutBinding.descriptorCount    = 1;
+    samplerLayoutBinding.descriptorCount    = m_maxBindlessTextures;
     samplerLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     samplerLayoutBinding.pImmutableSamplers = nullptr;
     samplerLayoutBinding.stageFlags         = VK_SHADER_STAGE_FRAGMENT_BIT;
 
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = { uboLayoutBinding, samplerLayoutBinding };
+    VkDescriptorSetLayoutBinding objectLayoutBinding{};
+    objectLayoutBinding.binding             = 2;
+    objectLayoutBinding.descriptorCount     = 1;
+    objectLayoutBinding.descriptorType      = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    objectLayoutBinding.pImmutableSamplers  = nullptr;
+    objectLayoutBinding.stageFlags          = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutBinding boardLayoutBinding{};
+    boardLayoutBinding.binding              = 3;
+    boardLayoutBinding.descriptorCount      = 1;
+    boardLayoutBinding.descriptorType       = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    boardLayoutBinding.pImmutableSamplers   = nullptr;
+    boardLayoutBinding.stageFlags           = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    std::array<VkDescriptorSetLayoutBinding, 4> bindings = { uboLayoutBinding, samplerLayoutBinding, objectLayoutBinding, boardLayoutBinding };
+
+    ///@note The texture array does not need to be fully populated, and new textures can be written
+    ///      while the set is bound by command buffers that are still in flight.
+    std::array<VkDescriptorBindingFlags, 4> bindingFlags =
+    {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT,
+        0,
+        0
+    };
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType                  = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount           = static_cast<uint32_t>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags          = bindingFlags.data();
+
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType                        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext                        = &bindingFlagsInfo;
+    layoutInfo.flags                        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
     layoutInfo.bindingCount                 = static_cast<uint32_t>(bindings.size());
     layoutInfo.pBindings                    = bindings.data();
 
@@ -401,167 +1215,82 @@ void WizardChess::CreateDescriptorSetLayout()
 
 void WizardChess::CreateGraphicsPipeline()
 {
-    auto vertShaderCode = ReadFile(GetShaderPaths(EShader::Vert));
-    auto fragShaderCode = ReadFile(GetShaderPaths(EShader::Frag));
-
-    VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
-    VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
-
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage  = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName  = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage  = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName  = "main";
-
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
-
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    auto bindingDescription    = Vertex::GetBindingDescription();
-    auto attributeDescriptions = Vertex::GetAttributeDescriptions();
-
-    vertexInputInfo.vertexBindingDescriptionCount   = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions      = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions    = attributeDescriptions.data();
-
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType                  = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology               = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType         = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount  = 1;
-
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
-    rasterizer.sType                    = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizer.depthClampEnable         = VK_FALSE;
-    rasterizer.rasterizerDiscardEnable  = VK_FALSE;
-    rasterizer.polygonMode              = VK_POLYGON_MODE_FILL;
-    rasterizer.lineWidth                = 1.0f;
-    rasterizer.cullMode                 = VK_CULL_MODE_BACK_BIT;
-    rasterizer.frontFace                = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    rasterizer.depthBiasEnable          = VK_FALSE;
-
-    VkPipelineMultisampleStateCreateInfo multisampling{};
-    multisampling.sType                 = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampling.sampleShadingEnable   = VK_FALSE;
-    multisampling.rasterizationSamples  = VK_SAMPLE_COUNT_1_BIT;
-
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType                  = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable        = VK_TRUE;
-    depthStencil.depthWriteEnable       = VK_TRUE;
-    depthStencil.depthCompareOp         = VK_COMPARE_OP_LESS;
-    depthStencil.depthBoundsTestEnable  = VK_FALSE;
-    depthStencil.stencilTestEnable      = VK_FALSE;
-
-    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendAttachment.blendEnable    = VK_FALSE;
-
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
-    colorBlending.sType                 = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlending.logicOpEnable         = VK_FALSE;
-    colorBlending.logicOp               = VK_LOGIC_OP_COPY;
-    colorBlending.attachmentCount       = 1;
-    colorBlending.pAttachments          = &colorBlendAttachment;
-    colorBlending.blendConstants[0]     = 0.0f;
-    colorBlending.blendConstants[1]     = 0.0f;
-    colorBlending.blendConstants[2]     = 0.0f;
-    colorBlending.blendConstants[3]     = 0.0f;
-
-    std::vector<VkDynamicState> dynamicStates =
-    {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    VkPipelineDynamicStateCreateInfo dynamicState{};
-    dynamicState.sType              = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
-    dynamicState.dynamicStateCount  = static_cast<uint32_t>(dynamicStates.size());
-    dynamicState.pDynamicStates     = dynamicStates.data();
-
-    VkPushConstantRange pushConstantRange{};
-    pushConstantRange.offset        = 0;
-    pushConstantRange.size          = sizeof(ModelPushConstants);
-    pushConstantRange.stageFlags    = VK_SHADER_STAGE_VERTEX_BIT;
-
+    ///@note Per-object transforms are read from the object buffer, so the layout has no push constant ranges.
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType                    = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount           = 1;
     pipelineLayoutInfo.pSetLayouts              = &m_descriptorSetLayout;
-    pipelineLayoutInfo.pushConstantRangeCount   = 1;
-    pipelineLayoutInfo.pPushConstantRanges      = &pushConstantRange;
+    pipelineLayoutInfo.pushConstantRangeCount   = 0;
+    pipelineLayoutInfo.pPushConstantRanges      = nullptr;
 
     if (vkCreatePipelineLayout(VK.Device(), &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to create pipeline layout!");
     }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.sType                  = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount             = 2;
-    pipelineInfo.pStages                = shaderStages;
-    pipelineInfo.pVertexInputState      = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState    = &inputAssembly;
-    pipelineInfo.pViewportState         = &viewportState;
-    pipelineInfo.pRasterizationState    = &rasterizer;
-    pipelineInfo.pMultisampleState      = &multisampling;
-    pipelineInfo.pDepthStencilState     = &depthStencil;
-    pipelineInfo.pColorBlendState       = &colorBlending;
-    pipelineInfo.pDynamicState          = &dynamicState;
-    pipelineInfo.layout                 = m_pipelineLayout;
-    pipelineInfo.renderPass             = m_renderPass;
-    pipelineInfo.subpass                = 0;
-    pipelineInfo.basePipelineHandle     = VK_NULL_HANDLE;
+    auto vertShaderCode = ReadFile(GetShaderPaths(EShader::Vert));
+    auto fragShaderCode = ReadFile(GetShaderPaths(EShader::Frag));
+
+    // Compile the fallback pipeline now, then the other variants on the worker threads.
+    // Draws of a variant use the fallback until the variant is ready, so the frame loop never waits on compilation.
+    m_pipelineManager.Init(&m_threadPool, m_pipelineLayout, vertShaderCode, fragShaderCode, VK.SurfaceManager()->SwapChainImageFormat(),
+                           m_gpuPicking ? ID_FORMAT : VK_FORMAT_UNDEFINED, FindDepthFormat());
+    m_pipelineManager.RequestAllVariants();
+}
+
+void WizardChess::CreateColorResources()
+{
+    VkFormat colorFormat = VK.SurfaceManager()->SwapChainImageFormat();
+
+    ///@note The target has the full swap chain size; lower resolutions only use its top-left part,
+    ///      so changing the resolution does not reallocate anything.
+    auto extent = VK.SurfaceManager()->SwapChainExtent();
+    CreateImage(extent.width, extent.height, colorFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_colorImage, m_colorImageMemory);
+    m_colorImageView = VK.CreateImageView(m_colorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT);
+
+    m_dynamicResolution.SetFullExtent(extent);
+
+    // Upscale with bilinear filtering when the format supports it.
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(VK.PhysicalDevice(), colorFormat, &formatProperties);
+
+    VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if ((formatProperties.optimalTilingFeatures & blitFeatures) != blitFeatures)
+    {
+        throw std::runtime_error("failed to find blit support for the swap chain format!");
+    }
+
+    bool linearBlit = (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != 0;
+    m_upscaleFilter = linearBlit ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+}
 
-    if (vkCreateGraphicsPipelines(VK.Device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+void WizardChess::CreateIdResources()
+{
+    if (!m_gpuPicking)
     {
-        throw std::runtime_error("failed to create graphics pipeline!");
+        return;
     }
 
-    vkDestroyShaderModule(VK.Device(), fragShaderModule, nullptr);
-    vkDestroyShaderModule(VK.Device(), vertShaderModule, nullptr);
+    // Same size as the color target; only the part at the render resolution is drawn to.
+    auto extent = VK.SurfaceManager()->SwapChainExtent();
+    CreateImage(extent.width, extent.height, ID_FORMAT, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_idImage, m_idImageMemory);
+    m_idImageView = VK.CreateImageView(m_idImage, ID_FORMAT, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
-void WizardChess::CreateFramebuffers()
+void WizardChess::CreatePickReadbackBuffers()
 {
-    auto swapChainImageViews = VK.SurfaceManager()->SwapChainImageViews();
+    VkDeviceSize bufferSize = sizeof(uint32_t);
 
-    m_swapChainFramebuffers.resize(swapChainImageViews.size());
+    m_pickReadbackBuffers.resize(m_framesInFlight);
+    m_pickReadbackBuffersMemory.resize(m_framesInFlight);
+    m_pickReadbackBuffersMapped.resize(m_framesInFlight);
+    m_pickReadbackPending.assign(m_framesInFlight, false);
 
-    for (size_t i = 0; i < swapChainImageViews.size(); i++)
+    for (size_t i = 0; i < m_framesInFlight; i++)
     {
-        std::array<VkImageView, 2> attachments =
-        {
-            swapChainImageViews[i],
-            m_depthImageView
-        };
-
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass      = m_renderPass;
-        framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-        framebufferInfo.pAttachments    = attachments.data();
-
-        auto extent = VK.SurfaceManager()->SwapChainExtent();
-        framebufferInfo.width   = extent.width;
-        framebufferInfo.height  = extent.height;
-        framebufferInfo.layers  = 1;
-
-        if (vkCreateFramebuffer(VK.Device(), &framebufferInfo, nullptr, &m_swapChainFramebuffers[i]) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create framebuffer!");
-        }
+        CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_pickReadbackBuffers[i], m_pickReadbackBuffersMemory[i]);
+
+        vkMapMemory(VK.Device(), m_pickReadbackBuffersMemory[i], 0, bufferSize, 0, &m_pickReadbackBuffersMapped[i]);
     }
 }
 
@@ -570,8 +1299,14 @@ void WizardChess::CreateDepthResources()
     VkFormat depthFormat = FindDepthFormat();
 
     auto extent = VK.SurfaceManager()->SwapChainExtent();
-    CreateImage(extent.width, extent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory);
+    // The depth buffer is sampled when the depth pyramid is built from it.
+    CreateImage(extent.width, extent.height, depthFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_depthImage, m_depthImageMemory);
     m_depthImageView = VK.CreateImageView(m_depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    if (m_occlusionCulling)
+    {
+        m_occlusionCuller.CreateDepthPyramid(extent);
+    }
 }
 
 VkFormat WizardChess::FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
@@ -599,7 +1334,7 @@ VkFormat WizardChess::FindDepthFormat()
     return FindSupportedFormat(
         { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
         VK_IMAGE_TILING_OPTIMAL,
-        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT
     );
 }
 
@@ -608,10 +1343,15 @@ bool WizardChess::HasStencilComponent(VkFormat format)
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
-void WizardChess::CreateTextureImage()
+uint32_t WizardChess::CreateTextureImage(const std::string& fileName)
 {
+    if (m_textures.size() >= m_maxBindlessTextures)
+    {
+        throw std::runtime_error("too many textures for the bindless texture array!");
+    }
+
     int texWidth, texHeight, texChannels;
-    stbi_uc* pixels = stbi_load(GetTexturePaths(ETexture::ChessBoardWood).c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+    stbi_uc* pixels = stbi_load(fileName.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
     VkDeviceSize imageSize = texWidth * texHeight * 4;
 
     if (!pixels)
@@ -632,19 +1372,32 @@ void WizardChess::CreateTextureImage()
 
     stbi_image_free(pixels);
 
-    CreateImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_textureImage, m_textureImageMemory);
+    Texture texture{};
 
-    TransitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    CopyBufferToImage(stagingBuffer, m_textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
-    TransitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    CreateImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.imageMemory);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    TransitionImageLayout(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    uint64_t copyValue = CopyBufferToImage(stagingBuffer, texture.image, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    TransitionImageLayout(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // The upload is not waited for; the staging buffer goes away once the copy has completed.
+    VK.DeferDestruction([device, stagingBuffer, stagingBufferMemory]()
+    {
+        vkDestroyBuffer(device, stagingBuffer, nullptr);
+        vkFreeMemory(device, stagingBufferMemory, nullptr);
+    }, copyValue);
+
+    // Create a Vulkan image view for the texture, allowing shaders to sample it.
+    CreateTextureImageView(texture);
+
+    // The texture's index in m_textures is its slot in the bindless texture array.
+    m_textures.push_back(texture);
+    return static_cast<uint32_t>(m_textures.size() - 1);
 }
 
-void WizardChess::CreateTextureImageView()
+void WizardChess::CreateTextureImageView(Texture& texture)
 {
-    m_textureImageView = VK.CreateImageView(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
+    texture.imageView = VK.CreateImageView(texture.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
 }
 
 void WizardChess::CreateTextureSampler()
@@ -763,282 +1516,1175 @@ void WizardChess::TransitionImageLayout(VkImage image, VkFormat format, VkImageL
         1, &barrier
     );
 
-    VK.EndSingleTimeCommands(commandBuffer);
+    // Later submissions to the queue are ordered after the barrier, so there is nothing to wait for.
+    VK.SubmitSingleTimeCommands(commandBuffer);
 }
 
 void WizardChess::LoadModel()
 {
-    constexpr EModel firstModelIndex = EModel::Cube;
-    constexpr EModel lastModelIndex  = EModel::Cube;
-    constexpr int    numModels       = lastModelIndex - firstModelIndex + 1;
-    constexpr float  x_offset        = 0.0f;
-    constexpr float  theta           = 360.0f / numModels;
-    float            maxScale        = 0.0f;
-    for (int i = firstModelIndex; i <= lastModelIndex; i++)
+    // One model per mesh. Objects refer to them, so the pieces of a kind share their buffers.
+    float maxPieceScale = 0.0f;
+    for (int i = EModel::Cube; i <= EModel::Queen; i++)
     {
         Model* pModel = new Model(GetModelPaths(static_cast<EModel>(i)));
 
-        pModel->Rotate(theta * i, glm::vec3(0.0f, 1.0f, 0.0f));
-        pModel->Translate(glm::vec3(x_offset, 0.0f, 0.0f));
+        // The cube is the wooden base under the board quad.
+        pModel->SetTextureIndex(ETexture::Oak);
 
         ///@note Originally the model was along z-axis.
         ///      Rotate -90 degree along x-axis to make it point to the y-axis.
         pModel->Rotate(-90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
 
-        maxScale = std::max(maxScale, pModel->MaxScale());
+        if (i != EModel::Cube)
+        {
+            maxPieceScale = std::max(maxPieceScale, pModel->MaxScale());
+        }
         m_models.push_back(pModel);
     }
 
-    for (auto& pModel : m_models)
+    // The pieces keep their relative sizes; the tallest is two units high before the piece scale.
+    for (int i = EModel::Bishop; i <= EModel::Queen; i++)
     {
-        pModel->RescaleNormalizeMatrix(1.0f / maxScale);
+        m_models[i]->RescaleNormalizeMatrix(1.0f / maxPieceScale);
     }
-}
-
-void WizardChess::CreateUniformBuffers()
-{
-    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-    m_uniformBuffers.resize(MAX_FRAMES_IN_FLIGHT);
-    m_uniformBuffersMemory.resize(MAX_FRAMES_IN_FLIGHT);
-    m_uniformBuffersMapped.resize(MAX_FRAMES_IN_FLIGHT);
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    // The board is a single quad from -1 to 1 in the z = 0 plane of the model space of the other meshes.
+    // The fragment shader draws the squares, so its texture coordinate is the position in squares:
+    // 0 to 8 over the playing area plus half a square of border on every side.
     {
-        CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniformBuffers[i], m_uniformBuffersMemory[i]);
+        const float           border  = 0.5f;
+        std::vector<Vertex>   vertices;
+        std::vector<uint32_t> indices = { 0, 1, 2, 2, 3, 0 };
+        for (int corner = 0; corner < 4; corner++)
+        {
+            glm::vec2 position = glm::vec2(((corner == 1) || (corner == 2)) ? 1.0f : -1.0f, (corner >= 2) ? 1.0f : -1.0f);
+            vertices.push_back({ glm::vec3(position, 0.0f), glm::vec3(1.0f), (position + 1.0f) * (4.0f + border) - border });
+        }
 
-        vkMapMemory(VK.Device(), m_uniformBuffersMemory[i], 0, bufferSize, 0, &m_uniformBuffersMapped[i]);
+        Model* pBoard = new Model(vertices, indices);
+        pBoard->SetTextureIndex(ETexture::Oak);
+        pBoard->SetPipelineVariant(EPipelineVariant::Board);
+        pBoard->Rotate(-90.0f, glm::vec3(1.0f, 0.0f, 0.0f));
+        m_models.push_back(pBoard);
     }
-}
-
-void WizardChess::CreateDescriptorPool()
-{
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    poolSizes[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-    poolInfo.pPoolSizes    = poolSizes.data();
-    poolInfo.maxSets       = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
 
-    if (vkCreateDescriptorPool(VK.Device(), &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+    // The scene root carries the turntable rotation; the boards and the pieces hang below it.
+    m_sceneRoot = m_transforms.Create();
+    m_boards.assign(m_boardCount, BoardState());
+    for (BoardState& board : m_boards)
     {
-        throw std::runtime_error("failed to create descriptor pool!");
+        board.squareObjects.fill(UINT32_MAX);
     }
-}
-
-void WizardChess::CreateDescriptorSets()
-{
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, m_descriptorSetLayout);
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool     = m_descriptorPool;
-    allocInfo.descriptorSetCount = static_cast<uint32_t>(MAX_FRAMES_IN_FLIGHT);
-    allocInfo.pSetLayouts        = layouts.data();
 
-    m_descriptorSets.resize(MAX_FRAMES_IN_FLIGHT);
-    if (vkAllocateDescriptorSets(VK.Device(), &allocInfo, m_descriptorSets.data()) != VK_SUCCESS)
+    ///@note Each object is created for all boards in a row, so the copies of an object on the boards have
+    ///      consecutive indices and merge into one instanced draw.
+    for (uint32_t board = 0; board < m_boardCount; board++)
     {
-        throw std::runtime_error("failed to allocate descriptor sets!");
+        // The board quad lies at y = 0 and covers the squares and the border.
+        uint32_t boardNode = m_transforms.Create(m_sceneRoot);
+        m_transforms.SetScale(boardNode, glm::vec3(4.5f * SQUARE_SIZE, 1.0f, 4.5f * SQUARE_SIZE));
+        AddObject(EModel::Board, boardNode, board);
     }
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    for (uint32_t board = 0; board < m_boardCount; board++)
     {
-        VkDescriptorBufferInfo bufferInfo{};
-        bufferInfo.buffer = m_uniformBuffers[i];
-        bufferInfo.offset = 0;
-        bufferInfo.range  = sizeof(UniformBufferObject);
-
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView   = m_textureImageView;
-        imageInfo.sampler     = m_textureSampler;
-
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-        descriptorWrites[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet          = m_descriptorSets[i];
-        descriptorWrites[0].dstBinding      = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pBufferInfo     = &bufferInfo;
-
-        descriptorWrites[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet          = m_descriptorSets[i];
-        descriptorWrites[1].dstBinding      = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo      = &imageInfo;
+        // The base cube spans -1 to 1, so scale it to the board and put its top face just below the quad.
+        uint32_t baseNode = m_transforms.Create(m_sceneRoot);
+        m_transforms.SetPosition(baseNode, glm::vec3(0.0f, -0.5f * BOARD_THICKNESS - BOARD_BASE_GAP, 0.0f));
+        m_transforms.SetScale(baseNode, glm::vec3(4.5f * SQUARE_SIZE, 0.5f * BOARD_THICKNESS, 4.5f * SQUARE_SIZE));
+        AddObject(EModel::Cube, baseNode, board);
+    }
 
-        vkUpdateDescriptorSets(VK.Device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    static const EModel backRank[8] =
+    {
+        EModel::Rook, EModel::Knight, EModel::Bishop, EModel::Queen, EModel::King, EModel::Bishop, EModel::Knight, EModel::Rook
+    };
+    static const int ranks[4] = { 0, 1, 6, 7 };
+    for (int file = 0; file < 8; file++)
+    {
+        for (int rank : ranks)
+        {
+            EModel model = ((rank == 1) || (rank == 6)) ? EModel::Pawn : backRank[file];
+            for (uint32_t board = 0; board < m_boardCount; board++)
+            {
+                AddPiece(model, file, rank, rank >= 6, board);
+            }
+        }
     }
 }
 
-void WizardChess::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+uint32_t WizardChess::AddObject(uint32_t model, uint32_t transform, uint32_t board)
 {
-    // Begin recording commands into the command buffer.
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    uint32_t objectIndex = static_cast<uint32_t>(m_objects.size());
+    m_objects.push_back({ model, transform });
+    m_objects[objectIndex].board = board;
 
-    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    if (m_occlusionCulling)
     {
-        throw std::runtime_error("failed to begin recording command buffer!");
+        m_occlusionCuller.SetObjectBounds(objectIndex, m_models[model]->Center(), m_models[model]->Extents());
     }
+    return objectIndex;
+}
 
-    // Get the current swap chain extent for setting up the render area.
-    auto swapChainExtent = VK.SurfaceManager()->SwapChainExtent();
-
-    // Configure the render pass begin info.
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = m_renderPass; // The render pass to use.
-    renderPassInfo.framebuffer = m_swapChainFramebuffers[imageIndex]; // Framebuffer for the current swap chain image.
-    renderPassInfo.renderArea.offset = { 0, 0 }; // Render area starts at the top-left corner.
-    renderPassInfo.renderArea.extent = swapChainExtent; // Render area size matches the swap chain extent.
-
-    // Clear values for the color and depth buffer.
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = { {0.25f, 0.0f, 0.0f, 1.0f} }; // Clear color to a dark red.
-    clearValues[1].depthStencil = { 1.0f, 0 }; // Clear depth to 1.0 and stencil to 0.
-
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
-
-    // Begin the render pass, specifying that commands will be submitted inline.
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // Bind the graphics pipeline to the command buffer.
-    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
+float WizardChess::PieceHalfHeight(uint32_t model) const
+{
+    return PIECE_SCALE * m_models[model]->Extents().z * glm::length(glm::vec3(m_models[model]->NormalizeMatrix()[0]));
+}
 
-    // Set the viewport, defining the dimensions and depth range of the render area.
-    VkViewport viewport{};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = (float)swapChainExtent.width;
-    viewport.height = (float)swapChainExtent.height;
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+uint32_t WizardChess::AddPiece(uint32_t model, int file, int rank, bool black, uint32_t board)
+{
+    uint32_t node = m_transforms.Create(m_sceneRoot);
+    m_transforms.SetScale(node, glm::vec3(PIECE_SCALE));
 
-    // Set the scissor rectangle to restrict drawing to the swap chain extent.
-    VkRect2D scissor{};
-    scissor.offset = { 0, 0 };
-    scissor.extent = swapChainExtent;
-    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    uint32_t objectIndex         = AddObject(model, node, board);
+    m_objects[objectIndex].black = black;
+    PlacePiece(objectIndex, rank * 8 + file);
+    return objectIndex;
+}
 
-    // Bind the descriptor set for the current frame, providing shader resources like textures and uniform buffers.
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSets[m_currentFrame], 0, nullptr);
+void WizardChess::PlacePiece(uint32_t objectIndex, int square)
+{
+    SceneObject& piece = m_objects[objectIndex];
 
-    // Calculate elapsed time to create a dynamic rotation effect for models.
-    static auto startTime = std::chrono::high_resolution_clock::now();
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+    // The normalized piece is centered on the origin, so lift it by half its height to stand on the board.
+    // Black pieces face the other side, which matters for the knights.
+    float yaw = piece.black ? glm::radians(180.0f) : 0.0f;
+    m_transforms.SetPosition(piece.transform, SquareCenter(square % 8, square / 8) + glm::vec3(0.0f, PieceHalfHeight(piece.model), 0.0f));
+    m_transforms.SetRotation(piece.transform, glm::angleAxis(yaw, glm::vec3(0.0f, 1.0f, 0.0f)));
 
-    // Create push constants for passing small amounts of dynamic data to shaders.
-    ModelPushConstants constants{};
+    piece.square                              = square;
+    piece.hidden                              = false;
+    m_boards[piece.board].squareObjects[square] = objectIndex;
+}
 
-    // Render each model in the scene.
-    for (auto& model : m_models)
+void WizardChess::LayOutWall()
+{
+    // Pick the grid that gives the boards the largest tiles, measured by their shorter side.
+    int width, height;
+    GetWindowSize(&width, &height);
+
+    m_wallColumns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_boardCount))));
+    m_wallRows    = (m_boardCount + m_wallColumns - 1) / m_wallColumns;
+    float bestSize = 0.0f;
+    for (uint32_t columns = 1; columns <= m_boardCount; columns++)
     {
-        // Initialize the model matrix and apply dynamic rotation.
-        constants.model = glm::mat4(1.0);
-        constants.model = glm::rotate(constants.model, time * glm::radians(90.0f), glm::vec3(2.0f, 3.0f, 5.0f));
-        constants.model = constants.model * model->ModelMatrix();
-
-        // Bind the vertex buffer for the current model.
-        VkBuffer vertexBuffers[] = { model->VertexBuffer() };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-
-        // Bind the index buffer for the current model.
-        vkCmdBindIndexBuffer(commandBuffer, model->IndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-        // Pass the normalization matrix to the shaders.
-        constants.normailzeMatrix = model->NormalizeMatrix();
-        vkCmdPushConstants(commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(ModelPushConstants), &constants);
-
-        // Issue a draw command for the indexed geometry of the model.
-        vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(model->Indices()), 1, 0, 0, 0);
+        uint32_t rows = (m_boardCount + columns - 1) / columns;
+        float    size = std::min(width / static_cast<float>(columns), height / static_cast<float>(rows));
+        if (size > bestSize)
+        {
+            bestSize      = size;
+            m_wallColumns = columns;
+            m_wallRows    = rows;
+        }
     }
 
-    // End the render pass.
-    vkCmdEndRenderPass(commandBuffer);
-
-    // Finalize recording the command buffer.
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    // Each tile maps the whole clip space of the camera onto its part of the screen, row by row from the top left.
+    glm::vec2 scale = glm::vec2(1.0f / m_wallColumns, 1.0f / m_wallRows);
+    for (uint32_t board = 0; board < m_boardCount; board++)
     {
-        throw std::runtime_error("failed to record command buffer!");
+        glm::vec2 offset = glm::vec2(-1.0f + (2 * (board % m_wallColumns) + 1) * scale.x, -1.0f + (2 * (board / m_wallColumns) + 1) * scale.y);
+        m_boardBuffer.SetTile(board, glm::vec4(scale, offset));
     }
 }
 
-void WizardChess::CreateSyncObjects()
+// The model of a piece letter of a FEN placement, in lower case.
+static EModel PieceModel(char letter)
 {
-    m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    switch (letter)
     {
-        if (vkCreateSemaphore(VK.Device(), &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(VK.Device(), &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(VK.Device(), &fenceInfo, nullptr, &m_inFlightFences[i]) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create synchronization objects for a frame!");
-        }
+    case 'b': return EModel::Bishop;
+    case 'k': return EModel::King;
+    case 'n': return EModel::Knight;
+    case 'p': return EModel::Pawn;
+    case 'q': return EModel::Queen;
+    default:  return EModel::Rook;
     }
 }
 
-void WizardChess::UpdateUniformBuffer(uint32_t currentImage, int modelIndex)
-{
-    auto swapChainExtent = VK.SurfaceManager()->SwapChainExtent();
-
-    UniformBufferObject ubo{};
-    ubo.view = glm::lookAt(glm::vec3(0.0f, 1.0f, 5.0f),
-                           glm::vec3(0.0f, -0.5f, 0.0f),
-                           glm::vec3(0.0f, 1.0f, 0.0f));
-    ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float)swapChainExtent.height, 0.1f, 10.0f);
-
-    // Vulkan's y-axis is pointing downwards.
-    ubo.proj[1][1] *= -1;
-
-    memcpy(m_uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
-}
-
-void WizardChess::DrawFrame()
+bool WizardChess::LoadFen(const std::string& fen, uint32_t board)
 {
-    vkWaitForFences(VK.Device(), 1, &m_inFlightFences[m_currentFrame], VK_TRUE, UINT64_MAX);
-
-    VkSwapchainKHR swapChain = VK.SurfaceManager()->SwapChain();
-
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(VK.Device(), swapChain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+    if (board >= m_boards.size())
+    {
+        return false;
+    }
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    // The placement lists the ranks from 8 down to 1, each from the a-file to the h-file.
+    // Letters are pieces, upper case for white; digits are runs of empty squares.
+    std::array<char, 64> placement;
+    placement.fill(0);
+    int rank = 7;
+    int file = 0;
+    for (size_t i = 0; (i < fen.size()) && (fen[i] != ' '); i++)
     {
-        RecreateSwapChain();
-        return;
+        char letter = fen[i];
+        if (letter == '/')
+        {
+            if ((file != 8) || (rank == 0))
+            {
+                return false;
+            }
+            rank--;
+            file = 0;
+        }
+        else if ((letter >= '1') && (letter <= '8'))
+        {
+            file += letter - '0';
+            if (file > 8)
+            {
+                return false;
+            }
+        }
+        else if ((file < 8) && (std::strchr("bknpqrBKNPQR", letter) != nullptr))
+        {
+            placement[rank * 8 + file++] = letter;
+        }
+        else
+        {
+            return false;
+        }
     }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    if ((rank != 0) || (file != 8))
     {
-        throw std::runtime_error("failed to acquire swap chain image!");
+        return false;
     }
 
-    UpdateUniformBuffer(m_currentFrame, 0);
-
-    vkResetFences(VK.Device(), 1, &m_inFlightFences[m_currentFrame]);
+    // Reuse the existing objects of each kind and side on the board. A position with promoted pieces can need
+    // more than the starting set, which adds objects; the ones the position does not use are hidden.
+    std::vector<uint32_t> spares[2][EModel::Board];
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_objects.size()); i++)
+    {
+        const SceneObject& object = m_objects[i];
+        if ((object.board == board) && (object.model != EModel::Board) && (object.model != EModel::Cube))
+        {
+            spares[object.black ? 1 : 0][object.model].push_back(i);
+        }
+    }
+
+    // A placement like 64 queens needs many more objects than the starting set; reject it before touching
+    // the board when the new objects would not fit in the object buffers.
+    uint32_t needed[2][EModel::Board] = {};
+    for (char letter : placement)
+    {
+        if (letter != 0)
+        {
+            bool black = (letter >= 'a');
+            needed[black ? 1 : 0][PieceModel(black ? letter : static_cast<char>(letter - 'A' + 'a'))]++;
+        }
+    }
+    size_t addedObjects = 0;
+    for (uint32_t side = 0; side < 2; side++)
+    {
+        for (uint32_t model = 0; model < EModel::Board; model++)
+        {
+            addedObjects += (needed[side][model] > spares[side][model].size()) ? (needed[side][model] - spares[side][model].size()) : 0;
+        }
+    }
+    if (m_objects.size() + addedObjects > MAX_OBJECTS)
+    {
+        std::cerr << "failed to load " << fen << ", it needs more than " << MAX_OBJECTS << " objects!" << std::endl;
+        return false;
+    }
+
+    for (const auto& side : spares)
+    {
+        for (const std::vector<uint32_t>& pool : side)
+        {
+            for (uint32_t objectIndex : pool)
+            {
+                m_animations.Stop(m_objects[objectIndex].transform);
+            }
+        }
+    }
+
+    BoardState& state = m_boards[board];
+    state.squareObjects.fill(UINT32_MAX);
+    for (int square = 0; square < 64; square++)
+    {
+        char letter = placement[square];
+        if (letter == 0)
+        {
+            continue;
+        }
+
+        bool   black = (letter >= 'a');
+        EModel model = PieceModel(black ? letter : static_cast<char>(letter - 'A' + 'a'));
+
+        std::vector<uint32_t>& pool = spares[black ? 1 : 0][model];
+        if (pool.empty())
+        {
+            // Checked above to fit in MAX_OBJECTS.
+            assert(m_objects.size() < MAX_OBJECTS);
+            AddPiece(model, square % 8, square / 8, black, board);
+        }
+        else
+        {
+            PlacePiece(pool.back(), square);
+            pool.pop_back();
+        }
+    }
+
+    for (auto& side : spares)
+    {
+        for (const std::vector<uint32_t>& pool : side)
+        {
+            for (uint32_t objectIndex : pool)
+            {
+                m_objects[objectIndex].square = -1;
+                m_objects[objectIndex].hidden = true;
+            }
+        }
+    }
+
+    if ((m_selectedPiece != UINT32_MAX) && (m_objects[m_selectedPiece].board == board))
+    {
+        m_selectedPiece = UINT32_MAX;
+    }
+    state.capturedCounts[0] = 0;
+    state.capturedCounts[1] = 0;
+    state.lastMoveFrom      = -1;
+    state.lastMoveTo        = -1;
+    UpdateBoardSquares(board);
+    Invalidate();
+    return true;
+}
+
+bool WizardChess::PlayMove(const std::string& move, uint32_t board)
+{
+    // A promotion letter after the squares is ignored; the piece moves as it is.
+    if ((board >= m_boards.size()) || (move.size() < 4) ||
+        (move[0] < 'a') || (move[0] > 'h') || (move[1] < '1') || (move[1] > '8') ||
+        (move[2] < 'a') || (move[2] > 'h') || (move[3] < '1') || (move[3] > '8'))
+    {
+        return false;
+    }
+
+    int      from  = (move[1] - '1') * 8 + (move[0] - 'a');
+    int      to    = (move[3] - '1') * 8 + (move[2] - 'a');
+    uint32_t piece = m_boards[board].squareObjects[from];
+    if ((piece == UINT32_MAX) || (from == to))
+    {
+        return false;
+    }
+
+    if (m_selectedPiece == piece)
+    {
+        m_selectedPiece = UINT32_MAX;
+    }
+    MovePiece(piece, to);
+    UpdateBoardSquares(board);
+    Invalidate();
+    return true;
+}
+
+void WizardChess::CreateUniformBuffers()
+{
+    VkDeviceSize bufferSize = sizeof(UniformBufferObject);
+
+    m_uniformBuffers.resize(m_framesInFlight);
+    m_uniformBuffersMemory.resize(m_framesInFlight);
+    m_uniformBuffersMapped.resize(m_framesInFlight);
+
+    for (size_t i = 0; i < m_framesInFlight; i++)
+    {
+        CreateBuffer(bufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_uniformBuffers[i], m_uniformBuffersMemory[i]);
+
+        vkMapMemory(VK.Device(), m_uniformBuffersMemory[i], 0, bufferSize, 0, &m_uniformBuffersMapped[i]);
+    }
+}
+
+void WizardChess::CreateDescriptorAllocators()
+{
+    // The persistent sets hold the bindless texture array, so their pool must allow update-after-bind.
+    std::vector<DescriptorPoolRatio> globalPoolRatios =
+    {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         1.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<float>(m_maxBindlessTextures) },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         2.0f },
+    };
+    m_globalDescriptorAllocator.Init(m_framesInFlight, globalPoolRatios, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+    // Transient sets are allocated per frame and recycled wholesale once the frame has retired.
+    std::vector<DescriptorPoolRatio> framePoolRatios =
+    {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         1.0f },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         2.0f },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1.0f },
+    };
+    m_frameDescriptorAllocators.resize(m_framesInFlight);
+    for (DescriptorAllocator& allocator : m_frameDescriptorAllocators)
+    {
+        allocator.Init(FRAME_DESCRIPTOR_SETS, framePoolRatios);
+    }
+}
+
+void WizardChess::CreateDescriptorSets()
+{
+    m_descriptorSets.resize(m_framesInFlight);
+    for (size_t i = 0; i < m_framesInFlight; i++)
+    {
+        m_descriptorSets[i] = m_globalDescriptorAllocator.Allocate(m_descriptorSetLayout);
+    }
+
+    for (size_t i = 0; i < m_framesInFlight; i++)
+    {
+        VkDescriptorBufferInfo bufferInfo{};
+        bufferInfo.buffer = m_uniformBuffers[i];
+        bufferInfo.offset = 0;
+        bufferInfo.range  = sizeof(UniformBufferObject);
+
+        VkDescriptorBufferInfo objectBufferInfo{};
+        objectBufferInfo.buffer = m_objectBuffer.Buffer(static_cast<uint32_t>(i));
+        objectBufferInfo.offset = 0;
+        objectBufferInfo.range  = VK_WHOLE_SIZE;
+
+        VkDescriptorBufferInfo boardBufferInfo{};
+        boardBufferInfo.buffer = m_boardBuffer.Buffer(static_cast<uint32_t>(i));
+        boardBufferInfo.offset = 0;
+        boardBufferInfo.range  = m_boardBuffer.Size();
+
+        std::array<VkWriteDescriptorSet, 3> descriptorWrites{};
+
+        descriptorWrites[0].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[0].dstSet          = m_descriptorSets[i];
+        descriptorWrites[0].dstBinding      = 0;
+        descriptorWrites[0].dstArrayElement = 0;
+        descriptorWrites[0].descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrites[0].descriptorCount = 1;
+        descriptorWrites[0].pBufferInfo     = &bufferInfo;
+
+        descriptorWrites[1].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[1].dstSet          = m_descriptorSets[i];
+        descriptorWrites[1].dstBinding      = 2;
+        descriptorWrites[1].dstArrayElement = 0;
+        descriptorWrites[1].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[1].descriptorCount = 1;
+        descriptorWrites[1].pBufferInfo     = &objectBufferInfo;
+
+        descriptorWrites[2].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[2].dstSet          = m_descriptorSets[i];
+        descriptorWrites[2].dstBinding      = 3;
+        descriptorWrites[2].dstArrayElement = 0;
+        descriptorWrites[2].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorWrites[2].descriptorCount = 1;
+        descriptorWrites[2].pBufferInfo     = &boardBufferInfo;
+
+        vkUpdateDescriptorSets(VK.Device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    }
+
+    // Publish the textures that were loaded so far in the bindless texture array.
+    WriteBindlessTextures(0, static_cast<uint32_t>(m_textures.size()));
+}
+
+void WizardChess::WriteBindlessTextures(uint32_t firstTexture, uint32_t textureCount)
+{
+    if (textureCount == 0)
+    {
+        return;
+    }
+
+    assert(firstTexture + textureCount <= m_textures.size());
+
+    std::vector<VkDescriptorImageInfo> imageInfos(textureCount);
+    for (uint32_t i = 0; i < textureCount; i++)
+    {
+        imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfos[i].imageView   = m_textures[firstTexture + i].imageView;
+        imageInfos[i].sampler     = m_textureSampler;
+    }
+
+    ///@note The binding is update-after-bind, so this is also valid while the sets are in use
+    ///      by frames in flight as long as those frames do not sample the slots being written.
+    std::vector<VkWriteDescriptorSet> descriptorWrites(m_descriptorSets.size());
+    for (size_t i = 0; i < m_descriptorSets.size(); i++)
+    {
+        descriptorWrites[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrites[i].dstSet          = m_descriptorSets[i];
+        descriptorWrites[i].dstBinding      = 1;
+        descriptorWrites[i].dstArrayElement = firstTexture;
+        descriptorWrites[i].descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrites[i].descriptorCount = textureCount;
+        descriptorWrites[i].pImageInfo      = imageInfos.data();
+    }
+
+    vkUpdateDescriptorSets(VK.Device(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
+
+void WizardChess::BeginRendering(VkCommandBuffer commandBuffer, VkAttachmentLoadOp loadOp)
+{
+    // Render into the top-left part of the targets that matches the current render resolution.
+    auto renderExtent = m_dynamicResolution.RenderExtent();
+
+    // Configure the color attachment, cleared to a dark red.
+    VkRenderingAttachmentInfo colorAttachment{};
+    colorAttachment.sType                   = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    colorAttachment.imageView               = m_colorImageView;
+    colorAttachment.imageLayout             = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.loadOp                  = loadOp;
+    colorAttachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.clearValue.color        = { {0.25f, 0.0f, 0.0f, 1.0f} };
+
+    // Configure the depth attachment, cleared to 1.0.
+    // Occlusion culling builds the depth pyramid from it, so then it has to be stored.
+    VkRenderingAttachmentInfo depthAttachment{};
+    depthAttachment.sType                   = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    depthAttachment.imageView               = m_depthImageView;
+    depthAttachment.imageLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.loadOp                  = loadOp;
+    depthAttachment.storeOp                 = m_occlusionCulling ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.clearValue.depthStencil = { 1.0f, 0 };
+
+    // Configure the object id attachment of GPU picking, cleared to 0 for the background.
+    VkRenderingAttachmentInfo idAttachment{};
+    idAttachment.sType                      = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+    idAttachment.imageView                  = m_idImageView;
+    idAttachment.imageLayout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    idAttachment.loadOp                     = loadOp;
+    idAttachment.storeOp                    = VK_ATTACHMENT_STORE_OP_STORE;
+    idAttachment.clearValue.color.uint32[0] = 0;
+
+    VkRenderingAttachmentInfo colorAttachments[] = { colorAttachment, idAttachment };
+
+    VkRenderingInfo renderingInfo{};
+    renderingInfo.sType                 = VK_STRUCTURE_TYPE_RENDERING_INFO;
+    renderingInfo.renderArea.offset     = { 0, 0 }; // Render area starts at the top-left corner.
+    renderingInfo.renderArea.extent     = renderExtent;
+    renderingInfo.layerCount            = 1;
+    renderingInfo.colorAttachmentCount  = m_gpuPicking ? 2 : 1;
+    renderingInfo.pColorAttachments     = colorAttachments;
+    renderingInfo.pDepthAttachment      = &depthAttachment;
+
+    // Begin rendering into the offscreen targets.
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+
+    // Set the viewport, defining the dimensions and depth range of the render area.
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float)renderExtent.width;
+    viewport.height = (float)renderExtent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+    // Set the scissor rectangle to restrict drawing to the render area.
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = renderExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    // Bind the descriptor set for the current frame, providing shader resources like textures and uniform buffers.
+    // All textures live in the bindless array of this set, so this is the only descriptor set bind of the frame.
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &m_descriptorSets[m_currentFrame], 0, nullptr);
+}
+
+void WizardChess::SelectLods(uint32_t renderHeight)
+{
+    m_objectLods.resize(m_objects.size(), 0);
+    m_frameTriangles = 0;
+
+    // Pixels covered by one world unit at a distance of one unit from the camera; on a wall, a board only has its tile.
+    float     pixelsPerUnit  = 0.5f * renderHeight / m_wallRows * std::abs(m_projMatrix[1][1]);
+    float     maxError       = LOD_PIXEL_ERROR * std::exp2(m_lodBias);
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(m_viewMatrix)[3]);
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_objects.size()); i++)
+    {
+        const Model*     model = ObjectModel(i);
+        const glm::mat4& world = m_objectBuffer.WorldMatrix(i);
+
+        // The error is measured at the point of the bounding sphere closest to the camera.
+        float     worldScale = std::sqrt(std::max(std::max(glm::dot(world[0], world[0]), glm::dot(world[1], world[1])), glm::dot(world[2], world[2])));
+        glm::vec3 center     = glm::vec3(world * glm::vec4(model->Center(), 1.0f));
+        float     radius     = glm::length(model->Extents()) * worldScale;
+        float     distance   = std::max(glm::length(center - cameraPosition) - radius, CAMERA_NEAR_PLANE);
+        float     pixelScale = pixelsPerUnit * worldScale / distance; // Pixels per unit of model space.
+
+        // Refine while the current level is too coarse, then coarsen while the next level is well within the limit.
+        uint32_t level = std::min(m_objectLods[i], model->LodCount() - 1);
+        while ((level > 0) && (model->Lod(level).error * pixelScale > maxError))
+        {
+            level--;
+        }
+        while ((level + 1 < model->LodCount()) && (model->Lod(level + 1).error * pixelScale < maxError * (1.0f - LOD_HYSTERESIS)))
+        {
+            level++;
+        }
+
+        m_objectLods[i]   = level;
+        m_frameTriangles += model->Lod(level).indexCount / 3;
+    }
+}
+
+void WizardChess::BuildRenderQueue()
+{
+    // Collect one draw packet per object. The sort key groups draws by pipeline, material and mesh,
+    // and orders them front-to-back inside each group. Objects sharing a model share the mesh.
+    m_renderQueue.Clear();
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_objects.size()); i++)
+    {
+        if (m_objects[i].hidden)
+        {
+            continue;
+        }
+
+        ///@note On a wall, the copies of an object on the boards only merge into one instanced draw while they
+        ///      stay in object order, so they are not sorted by depth; the tiles are too small to gain much from it.
+        const Model* model     = ObjectModel(i);
+        glm::vec4    center    = m_objectBuffer.WorldMatrix(i) * glm::vec4(model->Center(), 1.0f);
+        float        viewDepth = (m_boards.size() > 1) ? 0.0f : -(m_viewMatrix * center).z;
+        uint32_t     pipeline  = (i == m_selectedPiece) ? EPipelineVariant::Highlight : model->PipelineVariant();
+
+        m_renderQueue.Submit(RenderQueue::MakeSortKey(ERenderPass::Opaque, pipeline, model->TextureIndex(), m_objects[i].model, viewDepth, CAMERA_FAR_PLANE), i);
+    }
+    m_renderQueue.Sort();
+}
+
+void WizardChess::RecordDraws(VkCommandBuffer commandBuffer, VkBuffer drawCommandBuffer)
+{
+    // Render the models in sort key order, rebinding pipelines and buffers only when they change.
+    ///@note The first instance is the object index, so the shaders look up the object's data with gl_InstanceIndex.
+    ///      Without culling, consecutive packets of the same pipeline and mesh with consecutive object indices
+    ///      and level of detail are merged into one instanced draw. With culling, every packet has its own indirect draw command
+    ///      and packets sharing a pipeline and mesh are issued with a single indirect call.
+    const std::vector<DrawPacket>& packets = m_renderQueue.Packets();
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    uint32_t   boundMesh     = UINT32_MAX;
+    for (size_t first = 0; first < packets.size();)
+    {
+        const DrawPacket& packet = packets[first];
+        Model*            model  = ObjectModel(packet.objectIndex);
+
+        ///@note Variants that are still compiling resolve to the fallback pipeline, which may already be bound.
+        VkPipeline pipeline = m_pipelineManager.Get(static_cast<EPipelineVariant>(RenderQueue::PipelineOf(packet.sortKey)));
+        if (pipeline != boundPipeline)
+        {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+            boundPipeline = pipeline;
+        }
+
+        uint32_t mesh = RenderQueue::MeshOf(packet.sortKey);
+        if (mesh != boundMesh)
+        {
+            // Bind the vertex buffer for the current model.
+            VkBuffer vertexBuffers[] = { model->VertexBuffer() };
+            VkDeviceSize offsets[] = { 0 };
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+
+            // Bind the index buffer for the current model.
+            vkCmdBindIndexBuffer(commandBuffer, model->IndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+            boundMesh = mesh;
+        }
+
+        uint32_t count = 1;
+        while ((first + count < packets.size()) &&
+               (drawCommandBuffer != VK_NULL_HANDLE || ((packets[first + count].objectIndex == packet.objectIndex + count) &&
+                                                         (m_objectLods[packet.objectIndex + count] == m_objectLods[packet.objectIndex]))) &&
+               (RenderQueue::MeshOf(packets[first + count].sortKey) == mesh) &&
+               (RenderQueue::PipelineOf(packets[first + count].sortKey) == RenderQueue::PipelineOf(packet.sortKey)))
+        {
+            count++;
+        }
+
+        if (drawCommandBuffer == VK_NULL_HANDLE)
+        {
+            // Issue a draw command for the selected level of detail of the model.
+            const MeshLod& lod = model->Lod(m_objectLods[packet.objectIndex]);
+            vkCmdDrawIndexed(commandBuffer, lod.indexCount, count, lod.firstIndex, 0, packet.objectIndex);
+        }
+        else if (VK.EnabledFeatures().multiDrawIndirect)
+        {
+            vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, first * sizeof(VkDrawIndexedIndirectCommand), count, sizeof(VkDrawIndexedIndirectCommand));
+        }
+        else
+        {
+            for (uint32_t i = 0; i < count; i++)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffer, drawCommandBuffer, (first + i) * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+
+        first += count;
+    }
+}
+
+void WizardChess::RecordPickReadback(VkCommandBuffer commandBuffer)
+{
+    m_pickRequested = false;
+
+    int windowWidth, windowHeight;
+    GetWindowSize(&windowWidth, &windowHeight);
+    if ((windowWidth == 0) || (windowHeight == 0))
+    {
+        return;
+    }
+
+    // The rendered part of the id image is stretched over the whole window.
+    VkExtent2D renderExtent = m_dynamicResolution.RenderExtent();
+    int32_t    x            = std::clamp(static_cast<int32_t>(m_pickCursorX / windowWidth * renderExtent.width), 0, static_cast<int32_t>(renderExtent.width) - 1);
+    int32_t    y            = std::clamp(static_cast<int32_t>(m_pickCursorY / windowHeight * renderExtent.height), 0, static_cast<int32_t>(renderExtent.height) - 1);
+
+    RecordImageBarrier(commandBuffer, m_idImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageOffset      = { x, y, 0 };
+    region.imageExtent      = { 1, 1, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, m_idImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_pickReadbackBuffers[m_currentFrame], 1, &region);
+
+    // Make the copy visible to the host once the frame's timeline value has been reached.
+    VkMemoryBarrier hostBarrier{};
+    hostBarrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+    m_pickReadbackPending[m_currentFrame] = true;
+}
+
+void WizardChess::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    // Begin recording commands into the command buffer.
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to begin recording command buffer!");
+    }
+
+    VkImage swapChainImage = VK.SurfaceManager()->SwapChainImages()[imageIndex];
+
+    m_dynamicResolution.RecordFrameStart(commandBuffer, m_currentFrame);
+
+    VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    if (HasStencilComponent(FindDepthFormat()))
+    {
+        depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+
+    // Transition the color and depth targets into attachment layouts.
+    // The previous contents are discarded since both attachments are cleared.
+    RecordImageBarrier(commandBuffer, m_colorImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    if (m_gpuPicking)
+    {
+        RecordImageBarrier(commandBuffer, m_idImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    }
+    RecordImageBarrier(commandBuffer, m_depthImage, depthAspect,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                       VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+    SelectLods(m_dynamicResolution.RenderExtent().height);
+    BuildRenderQueue();
+
+    if (!m_occlusionCulling)
+    {
+        BeginRendering(commandBuffer, VK_ATTACHMENT_LOAD_OP_CLEAR);
+        RecordDraws(commandBuffer, VK_NULL_HANDLE);
+        vkCmdEndRendering(commandBuffer);
+    }
+    else
+    {
+        // One indirect draw per packet, in sort order. The culling passes fill in the instance counts.
+        m_drawCommands.clear();
+        for (const DrawPacket& packet : m_renderQueue.Packets())
+        {
+            const MeshLod& lod = ObjectModel(packet.objectIndex)->Lod(m_objectLods[packet.objectIndex]);
+
+            VkDrawIndexedIndirectCommand drawCommand{};
+            drawCommand.indexCount    = lod.indexCount;
+            drawCommand.instanceCount = 0;
+            drawCommand.firstIndex    = lod.firstIndex;
+            drawCommand.vertexOffset  = 0;
+            drawCommand.firstInstance = packet.objectIndex;
+            m_drawCommands.push_back(drawCommand);
+        }
+        m_occlusionCuller.WriteDrawCommands(m_currentFrame, m_drawCommands);
+
+        DescriptorAllocator& descriptorAllocator = m_frameDescriptorAllocators[m_currentFrame];
+        VkBuffer             objectBuffer        = m_objectBuffer.Buffer(m_currentFrame);
+        glm::mat4            viewProj            = m_projMatrix * m_viewMatrix;
+
+        VkExtent2D renderExtent  = m_dynamicResolution.RenderExtent();
+        VkExtent2D fullExtent    = m_dynamicResolution.FullExtent();
+        glm::vec2  viewportScale = glm::vec2(renderExtent.width / (float)fullExtent.width, renderExtent.height / (float)fullExtent.height);
+
+        // Early phase: draw what was visible according to the previous frame's depth pyramid.
+        m_occlusionCuller.RecordCull(commandBuffer, m_currentFrame, ECullPhase::Early, descriptorAllocator, objectBuffer, viewProj, viewportScale);
+
+        BeginRendering(commandBuffer, VK_ATTACHMENT_LOAD_OP_CLEAR);
+        RecordDraws(commandBuffer, m_occlusionCuller.DrawCommandBuffer(m_currentFrame, ECullPhase::Early));
+        vkCmdEndRendering(commandBuffer);
+
+        // Rebuild the depth pyramid from what has been drawn so far.
+        RecordImageBarrier(commandBuffer, m_depthImage, depthAspect,
+                           VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+
+        m_occlusionCuller.RecordBuildDepthPyramid(commandBuffer, descriptorAllocator, m_depthImageView);
+
+        RecordImageBarrier(commandBuffer, m_depthImage, depthAspect,
+                           VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                           VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+
+        // The color attachment is loaded again by the late phase.
+        RecordImageBarrier(commandBuffer, m_colorImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+        if (m_gpuPicking)
+        {
+            RecordImageBarrier(commandBuffer, m_idImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                               VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                               VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                               VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+        }
+
+        // Late phase: draw what the early phase culled but the new pyramid shows as visible.
+        m_occlusionCuller.RecordCull(commandBuffer, m_currentFrame, ECullPhase::Late, descriptorAllocator, objectBuffer, viewProj, viewportScale);
+
+        BeginRendering(commandBuffer, VK_ATTACHMENT_LOAD_OP_LOAD);
+        RecordDraws(commandBuffer, m_occlusionCuller.DrawCommandBuffer(m_currentFrame, ECullPhase::Late));
+        vkCmdEndRendering(commandBuffer);
+    }
+
+    if (m_pickRequested)
+    {
+        RecordPickReadback(commandBuffer);
+    }
+
+    // Upscale the rendered part of the color target into the whole swap chain image.
+    RecordImageBarrier(commandBuffer, m_colorImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+    RecordImageBarrier(commandBuffer, swapChainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                       VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+    VkExtent2D renderExtent    = m_dynamicResolution.RenderExtent();
+    VkExtent2D swapChainExtent = VK.SurfaceManager()->SwapChainExtent();
+
+    VkImageBlit blit{};
+    blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.srcOffsets[1]  = { static_cast<int32_t>(renderExtent.width), static_cast<int32_t>(renderExtent.height), 1 };
+    blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    blit.dstOffsets[1]  = { static_cast<int32_t>(swapChainExtent.width), static_cast<int32_t>(swapChainExtent.height), 1 };
+    vkCmdBlitImage(commandBuffer,
+                   m_colorImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1, &blit, m_upscaleFilter);
+
+    if (m_headless)
+    {
+        // Keep the image ready for ReadPixels(), which copies it out in a later submission.
+        RecordImageBarrier(commandBuffer, swapChainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+        if (m_captureSlot != UINT32_MAX)
+        {
+            m_readbackRing.RecordCopy(commandBuffer, m_captureSlot, swapChainImage, swapChainExtent);
+        }
+        if (m_captureFrame)
+        {
+            m_frameCapture.RecordCopy(commandBuffer, swapChainImage);
+        }
+    }
+    else if (m_captureFrame)
+    {
+        // Copy the image out before presenting it; the copy only reads, so presenting needs no access to wait for.
+        RecordImageBarrier(commandBuffer, swapChainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        m_frameCapture.RecordCopy(commandBuffer, swapChainImage);
+        RecordImageBarrier(commandBuffer, swapChainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                           VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    }
+    else
+    {
+        // Hand the swap chain image over to the presentation engine.
+        RecordImageBarrier(commandBuffer, swapChainImage, VK_IMAGE_ASPECT_COLOR_BIT,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    }
+
+    m_dynamicResolution.RecordFrameEnd(commandBuffer, m_currentFrame);
+
+    // Finalize recording the command buffer.
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to record command buffer!");
+    }
+}
+
+void WizardChess::CreateRenderFinishedSemaphores()
+{
+    ///@note The presentation engine waits on these, and a swap chain image is not acquired again until
+    ///      its previous presentation is done. Indexing them by image rather than by frame in flight
+    ///      keeps a semaphore from being signaled again while a present still waits on it, which
+    ///      matters most with a single frame in flight.
+    m_renderFinishedSemaphores.resize(VK.SurfaceManager()->SwapChainImages().size());
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (VkSemaphore& semaphore : m_renderFinishedSemaphores)
+    {
+        if (vkCreateSemaphore(VK.Device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create synchronization objects for a swap chain image!");
+        }
+    }
+}
+
+void WizardChess::CreateSyncObjects()
+{
+    m_imageAvailableSemaphores.resize(m_framesInFlight);
+
+    ///@note Frame completion is tracked on the device timeline semaphore. The acquire and present semaphores
+    ///      stay binary because the swap chain does not accept timeline semaphores.
+    m_frameTimelineValues.assign(m_framesInFlight, 0);
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    for (size_t i = 0; i < m_framesInFlight; i++)
+    {
+        if (vkCreateSemaphore(VK.Device(), &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+
+    CreateRenderFinishedSemaphores();
+}
+
+void WizardChess::UpdateCamera(VkExtent2D extent)
+{
+    if (m_boards.size() == 1)
+    {
+        m_viewMatrix = glm::lookAt(glm::vec3(0.0f, 2.2f, 2.6f),
+                                   glm::vec3(0.0f, 0.0f, 0.1f),
+                                   glm::vec3(0.0f, 1.0f, 0.0f));
+        m_projMatrix = glm::perspective(glm::radians(CAMERA_FOV), extent.width / (float)extent.height, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+    }
+    else
+    {
+        // Every board of the wall is seen by the same camera through its own tile. The camera looks from the
+        // direction of the single board camera, just far enough away that the board's sphere fits the tile.
+        float     tileAspect = (extent.width / (float)m_wallColumns) / (extent.height / (float)m_wallRows);
+        float     halfFov    = 0.5f * glm::radians(CAMERA_FOV);
+        float     distance   = WALL_BOARD_RADIUS / std::sin(std::min(halfFov, std::atan(std::tan(halfFov) * tileAspect)));
+        glm::vec3 direction  = glm::normalize(glm::vec3(0.0f, 2.2f, 2.5f));
+        m_viewMatrix = glm::lookAt(WALL_BOARD_CENTER + direction * distance,
+                                   WALL_BOARD_CENTER,
+                                   glm::vec3(0.0f, 1.0f, 0.0f));
+        m_projMatrix = glm::perspective(glm::radians(CAMERA_FOV), tileAspect, distance - WALL_BOARD_RADIUS, distance + WALL_BOARD_RADIUS);
+    }
+
+    // Vulkan's y-axis is pointing downwards.
+    m_projMatrix[1][1] *= -1;
+}
+
+void WizardChess::UpdateUniformBuffer(uint32_t currentImage, int modelIndex)
+{
+    // The camera is kept around for sorting the draws of this frame.
+    UpdateCamera(VK.SurfaceManager()->SwapChainExtent());
+
+    UniformBufferObject ubo{};
+    ubo.view     = m_viewMatrix;
+    ubo.proj     = m_projMatrix;
+    ubo.viewProj = ubo.proj * ubo.view;
+
+    memcpy(m_uniformBuffersMapped[currentImage], &ubo, sizeof(ubo));
+}
+
+double WizardChess::AnimationClock() const
+{
+    ///@note Captured frames show the scene at whole steps of the video frame rate, however long they
+    ///      took to render and write, so the video neither speeds up nor loses time.
+    return m_frameCapture.Active() ? m_captureTime : MonotonicTime();
+}
+
+void WizardChess::UpdateObjects()
+{
+    assert(m_objects.size() <= MAX_OBJECTS);
+
+    // Advance the turntable only while the animation runs, so it resumes where it stopped.
+    double now = AnimationClock();
+    if (m_animating)
+    {
+        m_animationTime += now - m_lastAnimationUpdate;
+
+        float angle = static_cast<float>(m_animationTime) * glm::radians(TURNTABLE_SPEED);
+        m_transforms.SetRotation(m_sceneRoot, glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+    m_lastAnimationUpdate = now;
+
+    // The moves run on the animation clock, also while the turntable is paused.
+    m_animations.Update(now, m_transforms);
+    m_transforms.Update(&m_threadPool);
+
+    // Only entries whose value changed are written to the mapped buffer of this frame.
+    for (uint32_t i = 0; i < static_cast<uint32_t>(m_objects.size()); i++)
+    {
+        const SceneObject& object = m_objects[i];
+        const Model*       model  = m_models[object.model];
+        if (m_transforms.WorldChanged(object.transform))
+        {
+            m_objectBuffer.SetWorldMatrix(i, m_transforms.WorldMatrix(object.transform) * model->ModelMatrix() * model->NormalizeMatrix());
+        }
+        m_objectBuffer.SetTextureIndex(i, model->TextureIndex());
+        m_objectBuffer.SetBoard(i, object.board);
+    }
+}
+
+void WizardChess::UpdateObjectBuffer(uint32_t currentImage)
+{
+    UpdateObjects();
+    m_objectBuffer.Flush(currentImage);
+    m_boardBuffer.Flush(currentImage);
+}
+
+void WizardChess::UpdateFrameStats()
+{
+    // Headless, there is no window title to show them in.
+    if (m_headless)
+    {
+        return;
+    }
+
+    // Refresh the window title about once per second.
+    double now     = MonotonicTime();
+    double elapsed = now - m_statsStartTime;
+    if (elapsed < 1.0)
+    {
+        return;
+    }
+
+    // Usage is the share of one core, or of the GPU, that the last second took.
+    double cpuTime  = ProcessCpuTime();
+    int    cpuUsage = static_cast<int>((cpuTime - m_statsCpuTime) / elapsed * 100.0 + 0.5);
+
+    if (m_softwareRendering)
+    {
+        std::string title = "Software | " + std::to_string(static_cast<int>(m_statsFrames / elapsed + 0.5)) + " fps";
+        title += NeedsRedraw() ? "" : " (idle)";
+        title += " | cpu " + std::to_string(cpuUsage) + "% (" + std::to_string(m_threadPool.ThreadCount() + 1) + " threads)";
+        title += " | " + std::to_string(m_softwareRasterizer.SetUpTriangles()) + "/" + std::to_string(m_frameTriangles) + " tris";
+        title += " | " + std::to_string(m_softwareRasterizer.Width()) + "x" + std::to_string(m_softwareRasterizer.Height());
+        glfwSetWindowTitle(m_softwareWindow, title.c_str());
+
+        m_statsStartTime = now;
+        m_statsFrames    = 0;
+        m_statsCpuTime   = cpuTime;
+        return;
+    }
+
+    VulkanSurfaceManager* pSurfaceManager = VK.SurfaceManager();
+
+    double gpuTime  = m_dynamicResolution.TotalGpuTime();
+    int    gpuUsage = static_cast<int>((gpuTime - m_statsGpuTime) / elapsed * 100.0 + 0.5);
+
+    std::string title = "Vulkan | " + std::to_string(static_cast<int>(m_statsFrames / elapsed + 0.5)) + " fps";
+    title += NeedsRedraw() ? "" : " (idle)";
+    title += " | cpu " + std::to_string(cpuUsage) + "%";
+    if (m_dynamicResolution.HasGpuTime())
+    {
+        title += " gpu " + std::to_string(gpuUsage) + "%";
+    }
+    title += " | " + std::string(GetLatencyProfileSettings(m_latencyProfile).name);
+    title += " (" + std::to_string(m_framesInFlight) + " in flight, " + PresentModeName(pSurfaceManager->PresentMode());
+    title += ", " + std::to_string(pSurfaceManager->SwapChainImages().size()) + " images)";
+    if (m_occlusionCulling)
+    {
+        title += " | culled " + std::to_string(m_occlusionCuller.CulledObjects()) + "/" + std::to_string(m_objects.size());
+    }
+    char lodBias[32];
+    snprintf(lodBias, sizeof(lodBias), "%+.1f", m_lodBias);
+    title += " | " + std::to_string(m_frameTriangles) + " tris (lod bias " + std::string(lodBias) + ")";
+    if (m_pickedSquare >= 0)
+    {
+        title += " | picked " + std::string(1, static_cast<char>('a' + m_pickedSquare % 8)) + std::to_string(m_pickedSquare / 8 + 1);
+    }
+    else if (m_pickedObject != UINT32_MAX)
+    {
+        title += " | picked object " + std::to_string(m_pickedObject);
+    }
+    if (m_pickedObject != UINT32_MAX)
+    {
+        title += " (" + std::to_string(static_cast<int>(m_pickTime * 1e6 + 0.5)) + " us)";
+    }
+    VkExtent2D renderExtent = m_dynamicResolution.RenderExtent();
+    title += " | " + std::to_string(renderExtent.width) + "x" + std::to_string(renderExtent.height);
+    title += " (" + std::to_string(static_cast<int>(m_dynamicResolution.Scale() * 100.0f + 0.5f)) + "%)";
+    if (m_dynamicResolution.HasGpuTime())
+    {
+        char gpuTime[32];
+        snprintf(gpuTime, sizeof(gpuTime), "%.1f", m_dynamicResolution.GpuTimeMs());
+        title += " | gpu " + std::string(gpuTime) + " ms";
+    }
+    if (m_framePacer.HasInputLatency())
+    {
+        char latency[32];
+        snprintf(latency, sizeof(latency), "%.1f", m_framePacer.InputLatencyMs());
+        title += " | latency " + std::string(latency) + " ms";
+    }
+    else
+    {
+        title += " | latency n/a";
+    }
+    glfwSetWindowTitle(pSurfaceManager->Window(), title.c_str());
+
+    m_statsStartTime = now;
+    m_statsFrames    = 0;
+    m_statsCpuTime   = cpuTime;
+    m_statsGpuTime   = gpuTime;
+}
+
+void WizardChess::SubmitFrame(uint32_t imageIndex, VkSemaphore waitSemaphore, VkSemaphore signalSemaphore)
+{
+    UpdateUniformBuffer(m_currentFrame, 0);
+    UpdateObjectBuffer(m_currentFrame);
+
+    // The frame's timeline value has been reached, so none of its transient descriptor sets are in use anymore.
+    m_frameDescriptorAllocators[m_currentFrame].Reset();
+
+    if (m_occlusionCulling)
+    {
+        m_occlusionCuller.BeginFrame(m_currentFrame);
+    }
+
+    // Pick the render resolution from the GPU time of the last frame that used this frame's queries.
+    // Headless frames have no display to keep up with, so they always render at full resolution.
+    ///@note The budget is the display refresh, not the measured present interval: with MAILBOX and
+    ///      IMMEDIATE that interval is the frame time itself, which shrinks with the scale.
+    double targetFrameTime = m_headless ? std::numeric_limits<double>::max() : m_refreshInterval;
+    m_dynamicResolution.SetTargetFrameTime(targetFrameTime);
+    m_dynamicResolution.BeginFrame(m_currentFrame);
+
+    // Waits for a free capture slot, so a slow writer slows the frames down instead of leaving them out of the video.
+    m_captureFrame = m_frameCapture.Active() && m_frameCapture.BeginFrame(VK.SurfaceManager()->SwapChainExtent());
 
     vkResetCommandBuffer(m_commandBuffers[m_currentFrame], /*VkCommandBufferResetFlagBits*/ 0);
     RecordCommandBuffer(m_commandBuffers[m_currentFrame], imageIndex);
@@ -1046,29 +2692,89 @@ void WizardChess::DrawFrame()
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = { m_imageAvailableSemaphores[m_currentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
+    VkSemaphore waitSemaphores[] = { waitSemaphore };
+    // The swap chain image is only written by the upscaling blit.
+    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_TRANSFER_BIT };
+    submitInfo.waitSemaphoreCount = (waitSemaphore != VK_NULL_HANDLE) ? 1 : 0;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &m_commandBuffers[m_currentFrame];
 
-    VkSemaphore signalSemaphores[] = { m_renderFinishedSemaphores[m_currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    m_frameTimelineValues[m_currentFrame] = VK.NextTimelineValue();
 
-    if (vkQueueSubmit(VK.GraphicsQueue(), 1, &submitInfo, m_inFlightFences[m_currentFrame]) != VK_SUCCESS)
+    // The timeline semaphore goes last, so the binary one can be left out.
+    VkSemaphore signalSemaphores[] = { signalSemaphore, VK.TimelineSemaphore() };
+    uint64_t    signalValues[]     = { 0, m_frameTimelineValues[m_currentFrame] };
+    uint32_t    firstSignal        = (signalSemaphore != VK_NULL_HANDLE) ? 0 : 1;
+    submitInfo.signalSemaphoreCount = 2 - firstSignal;
+    submitInfo.pSignalSemaphores = signalSemaphores + firstSignal;
+
+    // Values for binary semaphores are ignored.
+    uint64_t waitValues[] = { 0 };
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+    timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+    timelineInfo.pSignalSemaphoreValues = signalValues + firstSignal;
+    submitInfo.pNext = &timelineInfo;
+
+    if (vkQueueSubmit(VK.GraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 
+    if (m_captureFrame)
+    {
+        m_frameCapture.EndFrame(m_frameTimelineValues[m_currentFrame]);
+        m_captureFrame = false;
+
+        // Frames left out of the video, those of a resized window, do not advance its clock.
+        m_captureTime += 1.0 / m_captureFrameRate;
+    }
+}
+
+void WizardChess::DrawFrame()
+{
+    VkSwapchainKHR swapChain = VK.SurfaceManager()->SwapChain();
+
+    // Do all the waiting before input is sampled, so the frame shows the newest input possible.
+    m_framePacer.WaitForFrameStart(swapChain);
+
+    VK.WaitForTimelineValue(m_frameTimelineValues[m_currentFrame]);
+    VK.DestroyRetiredResources();
+    ResolvePickReadbacks();
+
+    uint32_t imageIndex;
+    VkResult result = vkAcquireNextImageKHR(VK.Device(), swapChain, UINT64_MAX, m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+    if (result == VK_ERROR_OUT_OF_DATE_KHR)
+    {
+        RecreateSwapChain();
+        return;
+    }
+    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+    {
+        throw std::runtime_error("failed to acquire swap chain image!");
+    }
+    VK.SurfaceManager()->MarkImageAcquired();
+
+    // Whatever invalidates the frame from here on needs another one.
+    m_frameDirty = false;
+    glfwPollEvents();
+    m_framePacer.MarkInputSampled();
+
+    SubmitFrame(imageIndex, m_imageAvailableSemaphores[m_currentFrame], m_renderFinishedSemaphores[imageIndex]);
+    m_framePacer.MarkSubmitted();
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &m_renderFinishedSemaphores[imageIndex];
 
     VkSwapchainKHR swapChains[] = { swapChain };
     presentInfo.swapchainCount = 1;
@@ -1076,7 +2782,19 @@ void WizardChess::DrawFrame()
 
     presentInfo.pImageIndices = &imageIndex;
 
+    uint64_t presentId = m_framePacer.NextPresentId();
+
+    VkPresentIdKHR presentIdInfo{};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+    if (presentId != 0)
+    {
+        presentInfo.pNext = &presentIdInfo;
+    }
+
     result = vkQueuePresentKHR(VK.PresentQueue(), &presentInfo);
+    m_framePacer.MarkPresented(presentId);
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_framebufferResized)
     {
@@ -1088,5 +2806,248 @@ void WizardChess::DrawFrame()
         throw std::runtime_error("failed to present swap chain image!");
     }
 
-    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_statsFrames++;
+    m_drawnFrames++;
+    m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+}
+
+void WizardChess::RenderSoftwareFrame()
+{
+    int width  = m_width;
+    int height = m_height;
+    if (!m_headless)
+    {
+        glfwGetFramebufferSize(m_softwareWindow, &width, &height);
+    }
+
+    // A minimized window has nothing to draw into.
+    if ((width <= 0) || (height <= 0))
+    {
+        return;
+    }
+
+    VkExtent2D extent = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+    m_softwareRasterizer.Resize(extent.width, extent.height);
+    UpdateCamera(extent);
+    UpdateObjects();
+    SelectLods(extent.height);
+    BuildRenderQueue();
+
+    // The draws keep the order of the render queue, so the nearer objects of a pipeline come first and
+    // the depth test skips the shading of what they hide.
+    m_softwareDraws.clear();
+    for (const DrawPacket& packet : m_renderQueue.Packets())
+    {
+        const Model*   model = ObjectModel(packet.objectIndex);
+        const MeshLod& lod   = model->Lod(m_objectLods[packet.objectIndex]);
+
+        SoftwareDraw draw;
+        draw.pVertices    = model->VertexData();
+        draw.pIndices     = model->IndexData() + lod.firstIndex;
+        draw.indexCount   = lod.indexCount;
+        draw.world        = m_objectBuffer.WorldMatrix(packet.objectIndex);
+        draw.textureIndex = model->TextureIndex();
+        draw.board        = m_objects[packet.objectIndex].board;
+        draw.variant      = static_cast<EPipelineVariant>(RenderQueue::PipelineOf(packet.sortKey));
+        m_softwareDraws.push_back(draw);
+    }
+
+    m_softwareRasterizer.Render(m_projMatrix * m_viewMatrix, m_boardBuffer.Data(), m_softwareDraws);
+}
+
+void WizardChess::DrawSoftwareFrame()
+{
+    // Whatever invalidates the frame from here on needs another one.
+    m_frameDirty = false;
+    glfwPollEvents();
+
+    RenderSoftwareFrame();
+
+    // The rows start at the top while OpenGL draws pixels upwards from the raster position, so they are
+    // drawn downwards from the top left corner instead.
+    glViewport(0, 0, static_cast<GLsizei>(m_softwareRasterizer.Width()), static_cast<GLsizei>(m_softwareRasterizer.Height()));
+    glRasterPos2f(-1.0f, 1.0f);
+    glPixelZoom(1.0f, -1.0f);
+    glDrawPixels(static_cast<GLsizei>(m_softwareRasterizer.Width()), static_cast<GLsizei>(m_softwareRasterizer.Height()), GL_RGBA, GL_UNSIGNED_BYTE, m_softwareRasterizer.Pixels().data());
+    glfwSwapBuffers(m_softwareWindow);
+
+    m_statsFrames++;
+    m_drawnFrames++;
+}
+
+void WizardChess::RenderFrame()
+{
+    assert(m_headless);
+
+    if (m_softwareRendering)
+    {
+        // The frame is complete when the rasterizer returns, so there is nothing to wait for.
+        m_frameDirty = false;
+        RenderSoftwareFrame();
+        m_lastRenderedImage = 0;
+        m_statsFrames++;
+        return;
+    }
+
+    VK.WaitForTimelineValue(m_frameTimelineValues[m_currentFrame]);
+    VK.DestroyRetiredResources();
+    ResolvePickReadbacks();
+
+    // Nothing is acquired or presented: each frame in flight renders into its own offscreen image.
+    m_frameDirty = false;
+    SubmitFrame(m_currentFrame, VK_NULL_HANDLE, VK_NULL_HANDLE);
+    m_lastRenderedImage = m_currentFrame;
+
+    m_statsFrames++;
+    m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
+}
+
+void WizardChess::ReadPixels(std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+{
+    assert(m_headless);
+    assert(m_lastRenderedImage != UINT32_MAX);
+
+    if (m_softwareRendering)
+    {
+        pixels = m_softwareRasterizer.Pixels();
+        width  = m_softwareRasterizer.Width();
+        height = m_softwareRasterizer.Height();
+        return;
+    }
+
+    VkExtent2D   extent     = VK.SurfaceManager()->SwapChainExtent();
+    VkDeviceSize bufferSize = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+    if (m_headlessReadbackBufferSize < bufferSize)
+    {
+        if (m_headlessReadbackBuffer != VK_NULL_HANDLE)
+        {
+            vkDestroyBuffer(VK.Device(), m_headlessReadbackBuffer, nullptr);
+            vkFreeMemory(VK.Device(), m_headlessReadbackMemory, nullptr);
+        }
+        CreateBuffer(bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, m_headlessReadbackBuffer, m_headlessReadbackMemory);
+        m_headlessReadbackBufferSize = bufferSize;
+    }
+
+    ///@note The frame left the image in TRANSFER_SRC_OPTIMAL, and its barrier orders the copy after the
+    ///      blit since the copy is submitted later to the same queue.
+    VkCommandBuffer commandBuffer = VK.BeginSingleTimeCommands();
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent      = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(commandBuffer, VK.SurfaceManager()->SwapChainImages()[m_lastRenderedImage], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_headlessReadbackBuffer, 1, &region);
+
+    // Make the copy visible to the host reads below once the submission has completed.
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = m_headlessReadbackBuffer;
+    barrier.offset              = 0;
+    barrier.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    VK.EndSingleTimeCommands(commandBuffer);
+
+    void* data;
+    vkMapMemory(VK.Device(), m_headlessReadbackMemory, 0, bufferSize, 0, &data);
+    pixels.resize(static_cast<size_t>(bufferSize));
+    memcpy(pixels.data(), data, static_cast<size_t>(bufferSize));
+    vkUnmapMemory(VK.Device(), m_headlessReadbackMemory);
+
+    width  = extent.width;
+    height = extent.height;
+}
+
+uint32_t WizardChess::RenderBatch(std::istream& positions, const std::string& outputPrefix, EImageFormat format)
+{
+    assert(m_headless);
+
+    // The images show the positions as they are, without the turntable.
+    m_animating = false;
+    m_transforms.SetRotation(m_sceneRoot, glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+
+    VkExtent2D extent = m_softwareRendering ? VkExtent2D{ static_cast<uint32_t>(m_width), static_cast<uint32_t>(m_height) } : VK.SurfaceManager()->SwapChainExtent();
+    if (!m_softwareRendering && (m_readbackRing.SlotCount() == 0))
+    {
+        ///@note One slot per frame in flight plus one per worker, so in the steady state neither the GPU
+        ///      nor the encoders wait for each other.
+        m_readbackRing.Create(&m_threadPool, m_framesInFlight + m_threadPool.ThreadCount(), static_cast<VkDeviceSize>(extent.width) * extent.height * 4);
+    }
+
+    ///@note Shared with the encoding jobs, which outlive this call when it throws before they are drained.
+    std::shared_ptr<std::atomic<uint32_t>> written = std::make_shared<std::atomic<uint32_t>>(0);
+
+    std::string fen;
+    uint32_t    line         = 0;
+    uint32_t    queuedImages = 0; // Software rendering: copies waiting for the workers to encode them.
+    while (std::getline(positions, fen))
+    {
+        line++;
+        if (!fen.empty() && (fen.back() == '\r'))
+        {
+            fen.pop_back();
+        }
+        if (fen.empty())
+        {
+            continue;
+        }
+        if (!LoadFen(fen))
+        {
+            std::cerr << "invalid FEN on line " << line << ": " << fen << std::endl;
+            continue;
+        }
+
+        char number[16];
+        snprintf(number, sizeof(number), "%08u", line);
+        std::string fileName = outputPrefix + number + "." + ImageFormatName(format);
+
+        if (m_softwareRendering)
+        {
+            // A copy of each image is encoded while the next one is rasterized; the workers share both jobs.
+            // Waiting once a copy per worker is queued bounds the memory the copies take.
+            if (queuedImages == m_threadPool.ThreadCount())
+            {
+                m_threadPool.WaitIdle();
+                queuedImages = 0;
+            }
+
+            RenderFrame();
+            m_threadPool.Enqueue([fileName, format, extent, pixels = m_softwareRasterizer.Pixels(), written]()
+            {
+                if (WriteImage(fileName, format, pixels.data(), extent.width, extent.height))
+                {
+                    (*written)++;
+                }
+            });
+            queuedImages++;
+            continue;
+        }
+
+        // Waits only when the slot's image from a full ring ago has not been encoded yet.
+        m_captureSlot = m_readbackRing.Acquire();
+        RenderFrame();
+
+        m_readbackRing.Submit(m_captureSlot, VK.LastSubmittedTimelineValue(), [fileName, format, extent, written](const uint8_t* pPixels)
+        {
+            if (WriteImage(fileName, format, pPixels, extent.width, extent.height))
+            {
+                (*written)++;
+            }
+        });
+        m_captureSlot = UINT32_MAX;
+
+        m_readbackRing.Poll();
+    }
+
+    if (!m_softwareRendering)
+    {
+        m_readbackRing.Flush();
+    }
+
+    // Also rethrows what an encoding job threw.
+    m_threadPool.WaitIdle();
+    return *written;
 }
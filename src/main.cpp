@@ -1,8 +1,15 @@
 #include "main.h"
 
 #include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
 
 #include "WizardChess.h"
+#include "ImageWriter.h"
+#include "Utils.h"
 
 namespace std {
     template<> struct hash<Vertex> {
@@ -13,13 +20,218 @@ namespace std {
 }
 
 #include <optional>
-int main()
+#include <string>
+
+static void PrintUsage(const char* name, const WizardChess::UsageReport& usage)
+{
+    std::cout << name << ": " << static_cast<int>(usage.frameRate + 0.5) << " fps, cpu " << static_cast<int>(usage.cpuUsage + 0.5) << "%";
+    if (usage.gpuUsage >= 0.0)
+    {
+        std::cout << ", gpu " << static_cast<int>(usage.gpuUsage + 0.5) << "%";
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[])
 {
-    WizardChess app(WIDTH, HEIGHT);
+    // --profile=low-latency|balanced|throughput|power-saving
+    // --lod-bias=<float>, positive values pick coarser levels of detail on slower machines
+    // --gpu-picking, select objects with the object id buffer instead of ray casts
+    // --headless=<file.ppm>, render one frame without a window and write it to the file
+    // --batch=<fen file>, render the position on each line without a window; - reads standard input
+    // --batch-output=<prefix>, images are written to <prefix><line number>.<format>
+    // --batch-format=png|ppm|raw
+    // --capture=<file>, stream every rendered frame to a video file; - writes to standard output
+    // --capture-format=y4m|raw
+    // --capture-fps=<n>, frame rate of the video, which the frames are paced to and the animations step by
+    // --wall=<boards>, show up to 256 boards side by side, each in its own tile
+    // --wall-positions=<fen file>, the position on line n goes to board n
+    // --software, render on the CPU; also chosen when no Vulkan device can be created
+    // --measure-idle=<seconds>, run the window that long with the turntable spinning, then as long with
+    //                           nothing changing, and print the processor and GPU use of both
+    ELatencyProfile latencyProfile = ELatencyProfile::Balanced;
+    float           lodBias        = 0.0f;
+    bool            gpuPicking     = false;
+    std::string     headlessOutput;
+    std::string     batchInput;
+    std::string     batchOutput;
+    EImageFormat    batchFormat    = EImageFormat::Png;
+    std::string     captureOutput;
+    ECaptureFormat  captureFormat  = ECaptureFormat::Y4m;
+    uint32_t        captureFps     = 60;
+    uint32_t        wallBoards     = 1;
+    std::string     wallPositions;
+    bool            software       = false;
+    double          measureSeconds = 0.0;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--profile=", 0) == 0)
+        {
+            if (!ParseLatencyProfile(arg.substr(strlen("--profile=")), &latencyProfile))
+            {
+                std::cerr << "unknown latency profile: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg.rfind("--lod-bias=", 0) == 0)
+        {
+            lodBias = std::strtof(arg.c_str() + strlen("--lod-bias="), nullptr);
+        }
+        else if (arg == "--gpu-picking")
+        {
+            gpuPicking = true;
+        }
+        else if (arg.rfind("--headless=", 0) == 0)
+        {
+            headlessOutput = arg.substr(strlen("--headless="));
+        }
+        else if (arg.rfind("--batch=", 0) == 0)
+        {
+            batchInput = arg.substr(strlen("--batch="));
+        }
+        else if (arg.rfind("--batch-output=", 0) == 0)
+        {
+            batchOutput = arg.substr(strlen("--batch-output="));
+        }
+        else if (arg.rfind("--batch-format=", 0) == 0)
+        {
+            if (!ParseImageFormat(arg.substr(strlen("--batch-format=")), &batchFormat))
+            {
+                std::cerr << "unknown image format: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg.rfind("--capture=", 0) == 0)
+        {
+            captureOutput = arg.substr(strlen("--capture="));
+        }
+        else if (arg.rfind("--capture-format=", 0) == 0)
+        {
+            if (!ParseCaptureFormat(arg.substr(strlen("--capture-format=")), &captureFormat))
+            {
+                std::cerr << "unknown capture format: " << arg << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if (arg.rfind("--capture-fps=", 0) == 0)
+        {
+            captureFps = std::max(1u, static_cast<uint32_t>(std::strtoul(arg.c_str() + strlen("--capture-fps="), nullptr, 10)));
+        }
+        else if (arg.rfind("--wall=", 0) == 0)
+        {
+            wallBoards = std::max(1u, static_cast<uint32_t>(std::strtoul(arg.c_str() + strlen("--wall="), nullptr, 10)));
+        }
+        else if (arg.rfind("--wall-positions=", 0) == 0)
+        {
+            wallPositions = arg.substr(strlen("--wall-positions="));
+        }
+        else if (arg == "--software")
+        {
+            software = true;
+        }
+        else if (arg.rfind("--measure-idle=", 0) == 0)
+        {
+            measureSeconds = std::max(0.0, std::strtod(arg.c_str() + strlen("--measure-idle="), nullptr));
+        }
+    }
+
+    WizardChess app(WIDTH, HEIGHT, latencyProfile);
+    app.SetLodBias(lodBias);
+    app.SetGpuPicking(gpuPicking);
+    app.SetHeadless(!headlessOutput.empty() || !batchInput.empty());
+    app.SetSpectatorWall(wallBoards);
+    app.SetSoftwareRendering(software);
+    if (!captureOutput.empty())
+    {
+        app.SetCapture(captureOutput, captureFormat, captureFps);
+    }
+
+    std::vector<std::string> positions;
+    if (!wallPositions.empty())
+    {
+        std::ifstream positionFile(wallPositions);
+        if (!positionFile.is_open())
+        {
+            std::cerr << "failed to open " << wallPositions << std::endl;
+            return EXIT_FAILURE;
+        }
+        for (std::string fen; std::getline(positionFile, fen);)
+        {
+            positions.push_back(fen);
+        }
+    }
+
+    // Called after Init(), once the boards exist.
+    auto loadPositions = [&app, &positions]()
+    {
+        for (uint32_t board = 0; board < static_cast<uint32_t>(positions.size()); board++)
+        {
+            if (!positions[board].empty() && !app.LoadFen(positions[board], board))
+            {
+                std::cerr << "invalid FEN for board " << board << ": " << positions[board] << std::endl;
+            }
+        }
+    };
 
     try
     {
-        app.run();
+        if (!batchInput.empty())
+        {
+            std::ifstream fenFile;
+            if (batchInput != "-")
+            {
+                fenFile.open(batchInput);
+                if (!fenFile.is_open())
+                {
+                    std::cerr << "failed to open " << batchInput << std::endl;
+                    return EXIT_FAILURE;
+                }
+            }
+
+            app.Init();
+            double   startTime = MonotonicTime();
+            uint32_t images    = app.RenderBatch((batchInput == "-") ? std::cin : fenFile, batchOutput, batchFormat);
+            double   elapsed   = MonotonicTime() - startTime;
+            app.Shutdown();
+
+            std::ostream& stats = (captureOutput == "-") ? std::cerr : std::cout;
+            stats << images << " images in " << elapsed << " s, " << (images / std::max(elapsed, 1e-9)) << " images/s" << std::endl;
+        }
+        else if (headlessOutput.empty() && (measureSeconds > 0.0))
+        {
+            app.Init();
+            loadPositions();
+            WizardChess::UsageReport animating = app.MeasureUsage(measureSeconds, true);
+            WizardChess::UsageReport idle      = app.MeasureUsage(measureSeconds, false);
+            app.Shutdown();
+
+            PrintUsage("animating", animating);
+            PrintUsage("idle", idle);
+        }
+        else if (headlessOutput.empty())
+        {
+            app.Init();
+            loadPositions();
+            app.MainLoop();
+            app.Shutdown();
+        }
+        else
+        {
+            std::vector<uint8_t> pixels;
+            uint32_t             width, height;
+            app.Init();
+            loadPositions();
+            app.RenderFrame();
+            app.ReadPixels(pixels, width, height);
+            app.Shutdown();
+
+            if (!WriteImage(headlessOutput, EImageFormat::Ppm, pixels.data(), width, height))
+            {
+                std::cerr << "failed to write " << headlessOutput << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
     }
     catch (const std::exception& e)
     {
@@ -27,5 +239,18 @@ int main()
         return EXIT_FAILURE;
     }
 
+    // Standard output may be the captured video itself.
+    if (!captureOutput.empty())
+    {
+        std::cerr << app.CapturedFrames() << " frames captured, " << app.DroppedFrames() << " dropped, "
+                  << app.SustainedFrameRate() << " of " << captureFps << " frames/s sustained" << std::endl;
+
+        // The video still plays at the right speed, but the window showed the scene in slow motion meanwhile.
+        if (app.SustainedFrameRate() < captureFps * 0.99)
+        {
+            std::cerr << "the frames could not be rendered and written at " << captureFps << " frames/s" << std::endl;
+        }
+    }
+
     return EXIT_SUCCESS;
 }
\ No newline at end of file
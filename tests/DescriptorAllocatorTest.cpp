@@ -0,0 +1,117 @@
+#include "DescriptorAllocator.h"
+#include "VulkanDeviceManager.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <set>
+#include <vector>
+
+// Enough sets for the chain to grow past its first pools, which start at 2 sets and grow by half.
+const uint32_t TEST_INITIAL_SETS = 2;
+const uint32_t TEST_SET_COUNT    = 40;
+
+// Brings up a headless device, the same way the application does without a window.
+static void CreateDevice()
+{
+    g_pVk = new VulkanDeviceManager();
+    VK.SetHeadless(true);
+    VK.CreateHeadlessTarget(1, 1);
+    VK.EnableValidationLayers(false, nullptr);
+    VK.CreateInstance();
+    VK.EnableDeviceExtensions(nullptr);
+    VK.EnableOptionalDeviceExtensions(nullptr);
+    VK.PickPhysicalDevice();
+    VK.CreateLogicalDevice();
+}
+
+static VkDescriptorSetLayout CreateSetLayout()
+{
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding         = 0;
+    binding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    binding.descriptorCount = 1;
+    binding.stageFlags      = VK_SHADER_STAGE_VERTEX_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings    = &binding;
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    if (vkCreateDescriptorSetLayout(VK.Device(), &layoutInfo, nullptr, &layout) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create descriptor set layout!");
+    }
+    return layout;
+}
+
+// Allocates TEST_SET_COUNT sets, which must all be valid and different from each other.
+static bool AllocateSets(DescriptorAllocator& allocator, VkDescriptorSetLayout layout, const char* name)
+{
+    std::set<VkDescriptorSet> sets;
+    for (uint32_t i = 0; i < TEST_SET_COUNT; i++)
+    {
+        VkDescriptorSet set = allocator.Allocate(layout);
+        if ((set == VK_NULL_HANDLE) || !sets.insert(set).second)
+        {
+            std::cerr << name << ": set " << i << " is null or was handed out twice" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Fills the first pool and the ones chained after it, resets, and checks the same sets fit in the recycled pools.
+static bool RunAllocator()
+{
+    VkDescriptorSetLayout layout = CreateSetLayout();
+
+    DescriptorAllocator allocator;
+    allocator.Init(TEST_INITIAL_SETS, { { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f } });
+
+    bool     ok        = AllocateSets(allocator, layout, "first frame");
+    uint32_t poolCount = allocator.PoolCount();
+    if (ok && (poolCount < 2))
+    {
+        std::cerr << "first frame: " << TEST_SET_COUNT << " sets fit in " << poolCount << " pool" << std::endl;
+        ok = false;
+    }
+
+    allocator.Reset();
+    ok = ok && AllocateSets(allocator, layout, "after reset");
+    if (ok && (allocator.PoolCount() != poolCount))
+    {
+        std::cerr << "after reset: " << allocator.PoolCount() << " pools instead of the " << poolCount << " recycled ones" << std::endl;
+        ok = false;
+    }
+
+    allocator.Destroy();
+    vkDestroyDescriptorSetLayout(VK.Device(), layout, nullptr);
+
+    if (ok)
+    {
+        std::cout << TEST_SET_COUNT << " sets in " << poolCount << " pools, recycled after reset" << std::endl;
+    }
+    return ok;
+}
+
+int main()
+{
+    bool ok = false;
+    try
+    {
+        CreateDevice();
+        ok = RunAllocator();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+    }
+
+    delete g_pVk;
+    g_pVk = nullptr;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
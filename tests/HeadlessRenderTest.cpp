@@ -0,0 +1,88 @@
+#include "WizardChess.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+const uint32_t TEST_WIDTH  = 160;
+const uint32_t TEST_HEIGHT = 120;
+
+// Renders a few frames of the starting position without a window and checks what ReadPixels() returns.
+static bool RenderHeadless(bool software)
+{
+    const char* name = software ? "software" : "vulkan";
+
+    WizardChess app(static_cast<int>(TEST_WIDTH), static_cast<int>(TEST_HEIGHT));
+    app.SetHeadless(true);
+    app.SetSoftwareRendering(software);
+    app.Init();
+
+    // Init() falls back to software rendering without a usable device, which would hide a broken Vulkan path.
+    if (!software && app.SoftwareRendering())
+    {
+        app.Shutdown();
+        std::cerr << name << ": failed to initialize Vulkan, no device or driver like lavapipe was found" << std::endl;
+        return false;
+    }
+
+    bool ok = app.LoadFen("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR");
+
+    // More frames than are in flight, so every offscreen image has been rendered to and reused.
+    std::vector<uint8_t> pixels;
+    uint32_t             width  = 0;
+    uint32_t             height = 0;
+    for (int frame = 0; frame < 4; frame++)
+    {
+        app.RenderFrame();
+    }
+    app.ReadPixels(pixels, width, height);
+    app.Shutdown();
+
+    if (!ok)
+    {
+        std::cerr << name << ": failed to load the position" << std::endl;
+        return false;
+    }
+    if ((width != TEST_WIDTH) || (height != TEST_HEIGHT) || (pixels.size() != static_cast<size_t>(width) * height * 4))
+    {
+        std::cerr << name << ": read " << width << "x" << height << " with " << pixels.size() << " bytes" << std::endl;
+        return false;
+    }
+
+    // The board and the pieces are in view, so the frame cannot be a single color.
+    bool uniform = true;
+    for (size_t i = 4; (i < pixels.size()) && uniform; i += 4)
+    {
+        uniform = (pixels[i] == pixels[0]) && (pixels[i + 1] == pixels[1]) && (pixels[i + 2] == pixels[2]);
+    }
+    if (uniform)
+    {
+        std::cerr << name << ": the frame is a single color" << std::endl;
+        return false;
+    }
+
+    std::cout << name << ": ok" << std::endl;
+    return true;
+}
+
+// --software, render on the CPU; otherwise with Vulkan, and fail when no Vulkan device can be used.
+///@note One run per process, since the application owns process-wide state like the memory tracker.
+int main(int argc, char* argv[])
+{
+    bool software = (argc > 1) && (std::string(argv[1]) == "--software");
+
+    bool ok = false;
+    try
+    {
+        ok = RenderHeadless(software);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
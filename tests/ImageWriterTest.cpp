@@ -0,0 +1,113 @@
+#include "ImageWriter.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Written to the working directory and removed again.
+const char* TEST_FILE_NAME = "ImageWriterTest.png";
+
+enum EPattern : unsigned int
+{
+    Solid    = 0, // One color, which deflates to long runs.
+    Gradient = 1, // Smooth in both directions, which the Paeth filter predicts well.
+    Stripes  = 2, // A short period, so most of each row matches the rows and pixels before it.
+    Noise    = 3, // Incompressible, so the stream holds mostly literals.
+    NumPatterns,
+};
+
+static const char* PatternName(EPattern pattern)
+{
+    static const char* names[] = { "solid", "gradient", "stripes", "noise" };
+    return names[pattern];
+}
+
+static std::vector<uint8_t> MakePixels(EPattern pattern, uint32_t width, uint32_t height)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    uint32_t             seed = 12345;
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* pPixel = &pixels[(static_cast<size_t>(y) * width + x) * 4];
+            for (uint32_t c = 0; c < 4; c++)
+            {
+                switch (pattern)
+                {
+                case EPattern::Solid:
+                    pPixel[c] = static_cast<uint8_t>(40 + c * 50);
+                    break;
+                case EPattern::Gradient:
+                    pPixel[c] = static_cast<uint8_t>(x * (c + 1) + y * (3 - c));
+                    break;
+                case EPattern::Stripes:
+                    pPixel[c] = (((x + y) / 3 + c) % 2 == 0) ? 255 : 0;
+                    break;
+                default:
+                    seed      = seed * 1664525u + 1013904223u;
+                    pPixel[c] = static_cast<uint8_t>(seed >> 24);
+                    break;
+                }
+            }
+        }
+    }
+    return pixels;
+}
+
+// Encodes the pixels, decodes the file with stb_image and compares the two.
+static bool RoundTrip(EPattern pattern, uint32_t width, uint32_t height)
+{
+    std::string name = std::string(PatternName(pattern)) + " " + std::to_string(width) + "x" + std::to_string(height);
+
+    std::vector<uint8_t> pixels = MakePixels(pattern, width, height);
+    if (!WriteImage(TEST_FILE_NAME, EImageFormat::Png, pixels.data(), width, height))
+    {
+        std::cerr << name << ": failed to write " << TEST_FILE_NAME << std::endl;
+        return false;
+    }
+
+    int      decodedWidth, decodedHeight, channels;
+    stbi_uc* decoded = stbi_load(TEST_FILE_NAME, &decodedWidth, &decodedHeight, &channels, STBI_rgb_alpha);
+    std::remove(TEST_FILE_NAME);
+    if (decoded == nullptr)
+    {
+        std::cerr << name << ": failed to decode, " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    bool ok = (static_cast<uint32_t>(decodedWidth) == width) && (static_cast<uint32_t>(decodedHeight) == height) &&
+              (std::memcmp(decoded, pixels.data(), pixels.size()) == 0);
+    stbi_image_free(decoded);
+
+    if (!ok)
+    {
+        std::cerr << name << ": decoded pixels differ" << std::endl;
+    }
+    return ok;
+}
+
+int main()
+{
+    // Single pixels and rows, odd sizes, and images larger than the 32 KiB deflate window.
+    const uint32_t sizes[][2] = { { 1, 1 }, { 1, 37 }, { 300, 1 }, { 3, 2 }, { 17, 5 }, { 64, 64 }, { 257, 129 } };
+
+    bool ok = true;
+    for (unsigned int pattern = 0; pattern < NumPatterns; pattern++)
+    {
+        for (const auto& size : sizes)
+        {
+            ok &= RoundTrip(static_cast<EPattern>(pattern), size[0], size[1]);
+        }
+    }
+
+    std::cout << (ok ? "all images decoded as written" : "some images did not decode as written") << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}